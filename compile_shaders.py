@@ -1,11 +1,161 @@
 #!/usr/bin/env python3
 
 import shutil
+import struct
 import subprocess
 import sys
 from pathlib import Path
 from subprocess import CalledProcessError
 
+# bump together with SHADER_METADATA_VERSION in lib/sdl_utils.h
+METADATA_VERSION = 1
+
+# passed to every shader (must match constants.h)
+DEFINES = {"WORKGROUP_SIZE": 64}
+
+# shader -> axes of (define, {tag: value}), every combination is compiled to
+# <name>.<tag>...<stage>.spv so the host can bind a specialised pipeline instead of branching
+INTEGRATORS = ("INTEGRATOR", {"euler": 0, "verlet": 1, "runge_kutta": 2})  # simulation.h order
+STAGES = ("INTEGRATOR_STAGE", {"s0": 0, "s1": 1, "s2": 2, "s3": 3})  # see integrators.lib.glsl
+COMPACT = ("COMPACT", {"float": 0, "half": 1})  # trail and prediction point encoding, see compact.lib.glsl
+VARIANTS = {
+    "simulation/integrate.comp.glsl": [INTEGRATORS, STAGES],
+    "trajectory.comp.glsl": [INTEGRATORS, STAGES, ("GHOST", {"noghost": 0, "ghost": 1}), COMPACT],
+    "ghost_trajectory.comp.glsl": [INTEGRATORS, STAGES, COMPACT],
+    "trail.comp.glsl": [COMPACT],
+    "trail_reset.comp.glsl": [COMPACT],
+    "trail_decimate.comp.glsl": [COMPACT],
+    "graphics/trail.vert.glsl": [COMPACT],
+    "graphics/trajectory.vert.glsl": [COMPACT],
+    "graphics/ghost_trajectory.vert.glsl": [COMPACT],
+    "cull.comp.glsl": [("CULL_STAGE", {"count": 0, "scan": 1, "scatter": 2})],
+    "splat.comp.glsl": [("SPLAT_STAGE", {"clear": 0, "accumulate": 1})],
+    "field.comp.glsl": [("FIELD_STAGE", {"check": 0, "commit": 1, "evaluate": 2})],
+    "graphics/field.vert.glsl": [("FIELD_ARROWS", {"map": 0, "arrows": 1})],
+}
+
+# stages per step, INTEGRATOR_STAGES in simulation.h. the simulation commits Euler's single stage in a second one
+PREDICTION_STAGES = {0: 1, 1: 2, 2: 4}
+SIMULATION_STAGES = {0: 2, 1: 2, 2: 4}
+
+# shader -> whether a combination of defines is ever bound, the others aren't compiled
+USED = {
+    "simulation/integrate.comp.glsl": lambda d: d["INTEGRATOR_STAGE"] < SIMULATION_STAGES[d["INTEGRATOR"]],
+    "trajectory.comp.glsl": lambda d: d["INTEGRATOR_STAGE"] < PREDICTION_STAGES[d["INTEGRATOR"]],
+    "ghost_trajectory.comp.glsl": lambda d: d["INTEGRATOR_STAGE"] < PREDICTION_STAGES[d["INTEGRATOR"]],
+}
+
+SPIRV_MAGIC = 0x07230203
+OP_EXECUTION_MODE = 16
+OP_TYPE_IMAGE = 25
+OP_TYPE_SAMPLED_IMAGE = 27
+OP_TYPE_ARRAY = 28
+OP_TYPE_RUNTIME_ARRAY = 29
+OP_TYPE_POINTER = 32
+OP_VARIABLE = 59
+OP_DECORATE = 71
+
+DECORATION_BLOCK = 2
+DECORATION_BUFFER_BLOCK = 3
+DECORATION_DESCRIPTOR_SET = 34
+EXECUTION_MODE_LOCAL_SIZE = 17
+
+STORAGE_CLASS_UNIFORM_CONSTANT = 0
+STORAGE_CLASS_UNIFORM = 2
+STORAGE_CLASS_STORAGE_BUFFER = 12
+
+
+def reflect_spirv(spirv):
+    """Counts shader resources the same way SDL_shadercross reflection does, so the
+    runtime can create pipelines without parsing SPIR-V on every launch."""
+    words = struct.unpack(f"<{len(spirv) // 4}I", spirv)
+    if words[0] != SPIRV_MAGIC:
+        raise ValueError("not a SPIR-V module")
+
+    decorations, types, pointers, variables = {}, {}, {}, []
+    local_size = (1, 1, 1)
+    i = 5
+    while i < len(words):
+        count, opcode = words[i] >> 16, words[i] & 0xFFFF
+        operands = words[i + 1:i + count]
+        if opcode == OP_DECORATE:
+            decorations.setdefault(operands[0], {})[operands[1]] = operands[2:]
+        elif opcode in (OP_TYPE_IMAGE, OP_TYPE_SAMPLED_IMAGE, OP_TYPE_ARRAY, OP_TYPE_RUNTIME_ARRAY):
+            types[operands[0]] = (opcode, operands[1:])
+        elif opcode == OP_TYPE_POINTER:
+            pointers[operands[0]] = (operands[1], operands[2])
+        elif opcode == OP_VARIABLE:
+            variables.append((operands[0], operands[1], operands[2]))
+        elif opcode == OP_EXECUTION_MODE and operands[1] == EXECUTION_MODE_LOCAL_SIZE:
+            local_size = tuple(operands[2:5])
+        i += count
+
+    resources = []
+    for pointer_type, variable, storage_class in variables:
+        _, pointee = pointers[pointer_type]
+        while pointee in types and types[pointee][0] in (OP_TYPE_ARRAY, OP_TYPE_RUNTIME_ARRAY):
+            pointee = types[pointee][1][0]
+
+        kind = None
+        if storage_class == STORAGE_CLASS_STORAGE_BUFFER:
+            kind = "storage_buffer"
+        elif storage_class == STORAGE_CLASS_UNIFORM:
+            kind = "storage_buffer" if DECORATION_BUFFER_BLOCK in decorations.get(pointee, {}) else "uniform_buffer"
+        elif storage_class == STORAGE_CLASS_UNIFORM_CONSTANT and pointee in types:
+            opcode, operands = types[pointee]
+            if opcode == OP_TYPE_SAMPLED_IMAGE:
+                kind = "sampler"
+            elif opcode == OP_TYPE_IMAGE:
+                kind = "storage_texture" if operands[5] == 2 else "sampler"
+
+        if kind is not None:
+            descriptor_set = decorations.get(variable, {}).get(DECORATION_DESCRIPTOR_SET, [0])[0]
+            resources.append((kind, descriptor_set))
+
+    def count(kind, descriptor_set=None):
+        return sum(1 for k, s in resources if k == kind and (descriptor_set is None or s == descriptor_set))
+
+    return count, local_size
+
+
+def write_metadata(spirv_file, metadata_file):
+    count, local_size = reflect_spirv(spirv_file.read_bytes())
+    if ".comp" in spirv_file.name:
+        # same field order as SDL_ShaderCross_ComputePipelineMetadata
+        values = [
+            count("sampler"),
+            count("storage_texture", 0),
+            count("storage_buffer", 0),
+            count("storage_texture", 1),
+            count("storage_buffer", 1),
+            count("uniform_buffer"),
+            *local_size,
+        ]
+    else:
+        # same field order as SDL_ShaderCross_GraphicsShaderResourceInfo
+        values = [
+            count("sampler"),
+            count("storage_texture"),
+            count("storage_buffer"),
+            count("uniform_buffer"),
+        ]
+
+    metadata_file.write_text(" ".join(str(value) for value in [METADATA_VERSION, *values]) + "\n")
+
+
+def variants(relative_path):
+    """Yields (output name suffix, defines) for every variant of a shader."""
+    combinations = [("", {})]
+    for define, values in VARIANTS.get(relative_path.as_posix(), []):
+        combinations = [
+            (f"{tags}.{tag}", {**defines, define: value})
+            for tags, defines in combinations
+            for tag, value in values.items()
+        ]
+
+    used = USED.get(relative_path.as_posix(), lambda defines: True)
+    yield from ((tags, defines) for tags, defines in combinations if used(defines))
+
 
 def main():
     if len(sys.argv) < 2:
@@ -27,25 +177,36 @@ def main():
         sys.exit(0)
 
     for input_file in glsl_files:
-        relative_path = input_file.relative_to(in_dir)
-        output_file = (out_dir / relative_path).with_suffix(".spv")
-        output_file.parent.mkdir(parents=True, exist_ok=True)
-
         if ".lib" in input_file.stem:
             continue
 
-        try:
-            subprocess.run([
-                "glslang",
-                "-V",
-                str(input_file),
-                "-o",
-                str(output_file),
-            ], check=True)
-            print(f"Compiled {input_file} -> {output_file}")
-        except CalledProcessError:
-            print(f"Error compiling shader at {input_file}")
-            sys.exit(1)
+        relative_path = input_file.relative_to(in_dir)
+        name, stage = relative_path.stem.split(".", 1)
+        for tags, defines in variants(relative_path):
+            output_file = out_dir / relative_path.parent / f"{name}{tags}.{stage}.spv"
+            metadata_file = output_file.with_suffix(".meta")
+            output_file.parent.mkdir(parents=True, exist_ok=True)
+
+            try:
+                subprocess.run([
+                    "glslang",
+                    "-V",
+                    f"-I{in_dir}",
+                    *(f"-D{key}={value}" for key, value in {**DEFINES, **defines}.items()),
+                    str(input_file),
+                    "-o",
+                    str(output_file),
+                ], check=True)
+                print(f"Compiled {input_file} -> {output_file}")
+            except CalledProcessError:
+                print(f"Error compiling shader at {input_file}")
+                sys.exit(1)
+
+            try:
+                write_metadata(output_file, metadata_file)
+            except (ValueError, KeyError, struct.error) as error:
+                print(f"Error reflecting shader at {output_file}: {error}")
+                sys.exit(1)
 
 
 if __name__ == "__main__":
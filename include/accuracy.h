@@ -0,0 +1,19 @@
+#ifndef N_BODY_ACCURACY
+#define N_BODY_ACCURACY
+
+#include <stdbool.h>
+#include "SDL3/SDL_gpu.h"
+#include "simulation.h"
+#include "types.h"
+
+#define ACCURACY_MAX_BODIES 3
+#define ACCURACY_SAMPLES 16
+#define ACCURACY_GRAVITY 1.0f
+#define ACCURACY_SOFTENING 1e-3f
+
+// runs canonical scenes through every integrator on the GPU and compares them against the same method in double
+// precision on the CPU, and the Kepler binary against its exact orbit too. returns false if any run strays past its
+// tolerance. `sim` is left holding the last scene
+bool accuracy_run(SDL_GPUDevice *gpu, Simulation *sim);
+
+#endif
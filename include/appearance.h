@@ -0,0 +1,38 @@
+#ifndef N_BODY_APPEARANCE
+#define N_BODY_APPEARANCE
+
+#include <stdbool.h>
+#include "sdl_utils.h"
+#include "types.h"
+
+// how bodies look, kept apart from Graphics so snapshots carry it without a window or any pipelines.
+// Graphics only reads it while drawing
+typedef struct {
+    SDL_FColor clear_color;
+    f32 movable_outline;
+    f32 static_outline;
+    f32 trail_brightness;
+    f32 trail_tolerance;
+    f32 splat_radius;
+    f32 splat_exposure;
+    bool field;
+    f32 field_spacing; // pixels between arrows
+    f32 field_opacity; // of the potential map
+    f32 field_arrow_opacity;
+} GraphicsOptions;
+
+typedef struct Appearance {
+    GraphicsOptions options;
+    GPUArray colors; // RGBA8, one per body
+    u32 body_count;
+    u32 revision; // bumped whenever bodies are added, removed or replaced, Graphics rebuilds what it derived from them
+} Appearance;
+
+SDL_AppResult appearance_init(Appearance *appearance, SDL_GPUDevice *gpu);
+u32 appearance_pack_color(SDL_FColor color);
+u32 appearance_add_body(Appearance *appearance, SDL_GPUDevice *gpu, SDL_GPUCopyPass *copy_pass, SDL_FColor color);
+u32 appearance_add_bodies(Appearance *appearance, SDL_GPUDevice *gpu, SDL_GPUCopyPass *copy_pass, const SDL_FColor *colors, u32 count);
+void appearance_clear(Appearance *appearance);
+void appearance_free(const Appearance *appearance, SDL_GPUDevice *gpu);
+
+#endif
@@ -0,0 +1,23 @@
+#ifndef N_BODY_BODIES
+#define N_BODY_BODIES
+
+#include <stdbool.h>
+#include "SDL3/SDL_pixels.h"
+#include "HandmadeMath.h"
+#include "types.h"
+
+// structure of arrays in the exact layout of the simulation and appearance GPUArrays,
+// so a whole table goes up with one copy per array
+typedef struct {
+    HMM_Vec2 *positions;
+    HMM_Vec2 *velocities;
+    f32 *masses;
+    f32 *movable;
+    SDL_FColor *colors;
+    u32 count;
+} BodyTable;
+
+bool body_table_alloc(BodyTable *bodies, u32 count);
+void body_table_free(BodyTable *bodies);
+
+#endif
@@ -21,6 +21,8 @@ typedef struct Camera {
 
 void camera_init(Camera *cam);
 void camera_update(Camera *cam, SDL_Window *window, SDL_GPUDevice *gpu, const Simulation *sim);
+void camera_follow(Camera *cam, SDL_GPUDevice *gpu, const Simulation *sim); // blocks on the target's position
+void camera_project(Camera *cam, f32 width, f32 height); // zoom stays in world units per pixel
 void camera_mouse(Camera *cam, const SDL_Event *event, const Ghost *ghost);
 void camera_keyboard(Camera *cam, const SDL_Event *event, const Simulation *sim);
 
@@ -0,0 +1,27 @@
+#ifndef N_BODY_CHECKPOINT
+#define N_BODY_CHECKPOINT
+
+#include <stdbool.h>
+#include "SDL3/SDL_thread.h"
+#include "constants.h"
+#include "snapshot.h"
+#include "types.h"
+
+#define CHECKPOINT_INTERVAL_DEFAULT 100000 // steps
+
+// a checkpoint is a full snapshot including the trail ring and step counter. it is serialized on the
+// main thread and handed to a writer thread, which writes and syncs `<path>.tmp` before renaming it over `path`,
+// so a crash or power loss at any point leaves the previous checkpoint intact
+typedef struct {
+    char path[FILE_PATH_LENGTH];
+    u64 interval;
+    u64 next_step;
+    SDL_Thread *writer; // at most one write in flight
+} Checkpoint;
+
+void checkpoint_init(Checkpoint *checkpoint, const char *path, u64 interval, u64 step);
+bool checkpoint_due(const Checkpoint *checkpoint, const Simulation *sim);
+bool checkpoint_save(Checkpoint *checkpoint, const SnapshotInfo *info); // false if this or the previous checkpoint failed
+bool checkpoint_wait(Checkpoint *checkpoint); // false if the last write failed
+
+#endif
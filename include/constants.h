@@ -5,9 +5,16 @@
 #define WIDTH_DEFAULT 1200
 #define HEIGHT_DEFAULT 900
 #define FIXED_DELTA_TIME_DEFAULT 0.01f
+#define HEADLESS_BATCH_STEPS 256
 #define PREDICTION_DELTA_TIME_MULTIPLIER 1
 #define EPSILON 1e-6f // TODO: turn into simulation parameter?
-#define MAX_ACCUMULATOR_TIME 0.25
+#define MAX_ACCUMULATOR_TIME 0.25 // seconds of real time one frame may catch up on
+#define PRESENT_MODE_DEFAULT SDL_GPU_PRESENTMODE_VSYNC
+#define TIME_SCALE_DEFAULT 1.0f // simulated seconds per real second
+#define STEPS_PER_FRAME_DEFAULT 8
+#define RENDER_RATE_DEFAULT 30.0f // frames per second an uncapped simulation keeps drawing at
+#define UNCAPPED_STEPS_MAX 65536 // per frame
+#define FILE_PATH_LENGTH 256
 
 // new body defaults
 #define MASS_DEFAULT 50.0f
@@ -22,14 +29,28 @@
 
 // graphics defaults
 #define CLEAR_COLOR_DEFAULT (SDL_FColor) { 0.0f, 0.0f, 0.0f, 1.0f }
-#define FIELD_GRID_DEFAULT 100.0f
+#define FIELD_GRID_DEFAULT 100.0f // pixels between field arrows
+#define FIELD_SUBDIVISIONS 8 // potential samples per arrow spacing
+#define FIELD_OPACITY_DEFAULT 0.5f
+#define FIELD_ARROW_OPACITY_DEFAULT 0.8f
+#define FIELD_MOVE_THRESHOLD 0.5f // samples a body may move before the field is re-evaluated
+#define FIELD_ZOOM_THRESHOLD 1.25f // zoom ratio that re-evaluates it
 #define MOVABLE_OUTLINE_DEFAULT 0.1f
 #define STATIC_OUTLINE_DEFAULT 1.0f
 #define TRAIL_FADE_DEFAULT 1.0f
+#define TRAIL_TOLERANCE_DEFAULT 0.5f // pixels a trail may stray from its decimated line
+#define SPLAT_RADIUS_DEFAULT 1.0f // pixels, smaller bodies are splatted into a density buffer, 0 draws every body as a circle
+#define SPLAT_EXPOSURE_DEFAULT 1.0f
 
-// fixed (change is shaders as well)
-#define TRAIL_LENGTH 512
-#define PREDICTION_LENGTH 2048
+// trail and prediction defaults (frames per body)
+#define TRAIL_LENGTH_DEFAULT 512
+#define TRAIL_LENGTH_MAX 4096
+#define PREDICTION_LENGTH_DEFAULT 2048
+#define PREDICTION_LENGTH_MAX 8192
+
+// fixed (change in compile_shaders.py as well)
+#define WORKGROUP_SIZE 64
+#define WORKGROUP_COUNT(n) (((n) + WORKGROUP_SIZE - 1) / WORKGROUP_SIZE)
 
 #endif
 
@@ -0,0 +1,62 @@
+#ifndef N_BODY_DIAGNOSTICS
+#define N_BODY_DIAGNOSTICS
+
+#include <stdbool.h>
+#include "SDL3/SDL_gpu.h"
+#include "HandmadeMath.h"
+#include "readback.h"
+#include "types.h"
+
+typedef struct Simulation Simulation;
+
+#define DIAGNOSTICS_SLOTS 4
+#define DIAGNOSTICS_HISTORY 512
+#define DIAGNOSTICS_INTERVAL_DEFAULT 10
+
+// conserved quantities of one step, positions are relative to the world origin
+typedef struct {
+    u64 step;
+    u32 body_count;
+    f32 kinetic;
+    f32 potential;
+    f32 energy;
+    HMM_Vec2 momentum;
+    f32 angular_momentum;
+    f32 mass;
+    HMM_Vec2 center_of_mass;
+} DiagnosticsSample;
+
+// a two stage GPU reduction over the simulation buffers, read back through a small Readback without a writer thread.
+// drift is measured against the first sample after a reset, which happens whenever the body count changes
+typedef struct Diagnostics {
+    bool enabled;
+    u32 interval;
+    u64 next_step;
+
+    SDL_GPUComputePipeline *pipeline;
+    SDL_GPUComputePipeline *reduce_pipeline;
+    SDL_GPUBuffer *partials;
+    u32 partials_capacity; // workgroups
+    SDL_GPUBuffer *result;
+    Readback readback;
+    DiagnosticsSample captures[DIAGNOSTICS_SLOTS]; // step and body count until the readback lands
+
+    bool has_baseline;
+    DiagnosticsSample baseline;
+    DiagnosticsSample latest;
+    f32 energy_drift[DIAGNOSTICS_HISTORY];           // (E - E₀) / |E₀|
+    f32 momentum_drift[DIAGNOSTICS_HISTORY];         // |p - p₀|
+    f32 angular_momentum_drift[DIAGNOSTICS_HISTORY]; // L - L₀
+    u32 head;
+    u32 count;
+} Diagnostics;
+
+SDL_AppResult diagnostics_init(Diagnostics *diag, SDL_GPUDevice *gpu);
+void diagnostics_reset(Diagnostics *diag);
+bool diagnostics_due(const Diagnostics *diag, const Simulation *sim);
+void diagnostics_capture(Diagnostics *diag, SDL_GPUDevice *gpu, SDL_GPUCommandBuffer *command_buffer, const Simulation *sim);
+void diagnostics_submit(Diagnostics *diag, SDL_GPUDevice *gpu);
+void diagnostics_poll(Diagnostics *diag, SDL_GPUDevice *gpu);
+void diagnostics_free(Diagnostics *diag, SDL_GPUDevice *gpu);
+
+#endif
@@ -0,0 +1,73 @@
+#ifndef N_BODY_EXPORTER
+#define N_BODY_EXPORTER
+
+#include <stdbool.h>
+#include "SDL3/SDL_gpu.h"
+#include "SDL3/SDL_atomic.h"
+#include "SDL3/SDL_iostream.h"
+#include "constants.h"
+#include "readback.h"
+#include "types.h"
+
+typedef struct Simulation Simulation;
+
+#define EXPORT_PATH_DEFAULT "frame"
+#define EXPORT_WIDTH_DEFAULT 1920
+#define EXPORT_HEIGHT_DEFAULT 1080
+#define EXPORT_INTERVAL_DEFAULT 1
+#define EXPORTER_SLOTS 8
+
+// PPM writes `<path>000000.ppm` per frame, RAW appends rgb24 frames to `path` for `ffmpeg -f rawvideo -pix_fmt rgb24 -s WxH`
+typedef enum {
+    EXPORT_PPM,
+    EXPORT_RAW,
+    EXPORT_FORMAT_COUNT
+} ExportFormat;
+
+extern const char *EXPORT_FORMAT_NAMES[EXPORT_FORMAT_COUNT];
+
+// frames are drawn into a fixed size offscreen texture every `interval` simulation steps, so an export
+// doesn't depend on the window or the frame rate. downloads go through a Readback like the recorder's
+typedef struct Exporter {
+    bool exporting;
+    ExportFormat format;
+    u32 width;
+    u32 height;
+    u32 interval;
+    u64 next_step;
+    u64 frames;
+    u64 dropped;
+    SDL_GPUTexture *texture;
+    SDL_GPUTextureFormat texture_format;
+
+    Readback readback;
+    u64 captures[EXPORTER_SLOTS]; // frame number, one per readback slot
+    SDL_AtomicInt failed;
+
+    // owned by the writer thread while exporting
+    char path[FILE_PATH_LENGTH];
+    SDL_IOStream *io; // EXPORT_RAW only
+    u8 *pixels; // one rgb24 frame
+} Exporter;
+
+void exporter_init(Exporter *exp);
+typedef struct {
+    const char *path;
+    ExportFormat format;
+    u32 width;
+    u32 height;
+    u32 interval;
+    SDL_GPUTextureFormat texture_format; // Graphics.format
+    u64 step;
+} ExporterStartInfo;
+bool exporter_start(Exporter *exp, SDL_GPUDevice *gpu, const ExporterStartInfo *info);
+bool exporter_due(const Exporter *exp, const Simulation *sim);
+bool exporter_available(const Exporter *exp);
+bool exporter_begin(Exporter *exp, const Simulation *sim);
+void exporter_capture(Exporter *exp, SDL_GPUCommandBuffer *command_buffer);
+void exporter_submit(Exporter *exp, SDL_GPUDevice *gpu);
+void exporter_poll(Exporter *exp, SDL_GPUDevice *gpu, bool wait);
+void exporter_stop(Exporter *exp, SDL_GPUDevice *gpu);
+void exporter_free(Exporter *exp, SDL_GPUDevice *gpu);
+
+#endif
@@ -0,0 +1,43 @@
+#ifndef N_BODY_GENERATORS
+#define N_BODY_GENERATORS
+
+#include <stdbool.h>
+#include "bodies.h"
+#include "simulation.h"
+#include "types.h"
+
+#define GENERATOR_MAX_THREADS 32
+#define GENERATOR_BODIES_PER_THREAD 4096 // below this a thread isn't worth starting
+
+// generator defaults
+#define GENERATOR_COUNT_DEFAULT 1000
+#define GENERATOR_SEED_DEFAULT 1
+#define GENERATOR_MASS_DEFAULT 5000.0f
+#define GENERATOR_RADIUS_DEFAULT 200.0f
+#define GENERATOR_CENTRAL_MASS_DEFAULT 50000.0f
+#define GENERATOR_RINGS_DEFAULT 8
+
+typedef enum {
+    GENERATOR_PLUMMER,  // Plummer sphere projected onto the plane, `radius` is the Plummer radius
+    GENERATOR_DISK,     // exponential disk on circular orbits, `radius` is the scale length
+    GENERATOR_BINARIES, // bound pairs scattered over a disk of `radius`
+    GENERATOR_RINGS,    // Keplerian rings out to `radius` around a static central mass
+    GENERATOR_TYPE_COUNT,
+} GeneratorType;
+
+typedef struct {
+    GeneratorType type;
+    u32 count;
+    u64 seed;
+    f32 mass; // total, spread evenly over the generated bodies
+    f32 radius;
+    f32 central_mass; // disk and rings only, 0 for none
+    u32 rings;
+    HMM_Vec2 center;
+} GeneratorOptions;
+
+extern const char *GENERATOR_NAMES[GENERATOR_TYPE_COUNT];
+
+bool generate_bodies(const GeneratorOptions *options, const SimulationOptions *sim, BodyTable *bodies);
+
+#endif
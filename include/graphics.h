@@ -2,40 +2,73 @@
 #define N_BODY_GRAPHICS
 
 #include <stdbool.h>
+#include "HandmadeMath.h"
 #include "types.h"
 #include "sdl_utils.h"
+#include "appearance.h"
 
 typedef struct Simulation Simulation;
 typedef struct Ghost Ghost;
 typedef struct Trails Trails;
 typedef struct Trajectories Trajectories;
 typedef struct Camera Camera;
+typedef struct Tracking Tracking;
 
+#define GRAPHICS_OFFSCREEN_FORMAT SDL_GPU_TEXTUREFORMAT_R8G8B8A8_UNORM // pipelines built without a window
+
+// world space grid the field was last evaluated on, kept while it still covers the view
 typedef struct {
-    SDL_FColor clear_color;
-    f32 movable_outline;
-    f32 static_outline;
-    f32 trail_brightness;
-} GraphicsOptions;
+    HMM_Vec2 origin;
+    f32 cell;
+    u32 columns;
+    u32 rows;
+} GraphicsFieldGrid;
 
 typedef struct Graphics {
-    GraphicsOptions options;
-    u32 body_count;
     SDL_GPUGraphicsPipeline *body_pipeline;
-    SDL_GPUGraphicsPipeline *trail_pipeline;
-    SDL_GPUGraphicsPipeline *trajectory_pipeline;
+    SDL_GPUGraphicsPipeline *trail_pipelines[2]; // [compact]
+    SDL_GPUGraphicsPipeline *trajectory_pipelines[2]; // [compact]
     SDL_GPUGraphicsPipeline *ghost_body_pipeline;
-    SDL_GPUGraphicsPipeline *ghost_trajectory_pipeline;
-    GPUArray colors;
+    SDL_GPUGraphicsPipeline *ghost_trajectory_pipelines[2]; // [compact]
+    SDL_GPUComputePipeline *cull_pipelines[3]; // count, scan, scatter
+    SDL_GPUBuffer *cull_groups;
+    SDL_GPUBuffer *visible; // indices of the bodies on screen, in body order
+    SDL_GPUBuffer *draw_arguments; // SDL_GPUIndirectDrawCommand for the body pipeline
+    u32 cull_capacity;
+    SDL_GPUGraphicsPipeline *splat_pipeline;
+    SDL_GPUComputePipeline *splat_pipelines[2]; // clear, accumulate
+    SDL_GPUBuffer *splat_density; // fixed point rgb per pixel
+    u32 splat_capacity; // pixels
+    SDL_GPUComputePipeline *trail_decimate_pipelines[2]; // [compact]
+    SDL_GPUBuffer *trail_indices; // kept trail points, trail length per slot
+    SDL_GPUBuffer *trail_arguments; // SDL_GPUIndirectDrawCommand per slot
+    u32 trail_index_capacity;
+    u32 trail_argument_capacity; // slots
+    SDL_GPUComputePipeline *render_data_pipeline;
+    SDL_GPUBuffer *render_data; // radius and packed colour per body, see render.lib.glsl
+    u32 render_capacity;
+    f32 render_density; // the density `render_data` was built with
+    bool render_dirty; // set when the buffer grows, it's rebuilt at the next draw
+    u32 render_revision; // Appearance.revision `render_data` was built for
+    SDL_GPUComputePipeline *field_pipelines[3]; // check, commit, evaluate
+    SDL_GPUGraphicsPipeline *field_map_pipeline;
+    SDL_GPUGraphicsPipeline *field_arrow_pipeline;
+    SDL_GPUBuffer *field_samples; // acceleration and potential per grid point, see field.comp.glsl
+    SDL_GPUBuffer *field_anchors; // body positions the samples were evaluated with
+    SDL_GPUBuffer *field_range; // deepest potential and strongest acceleration
+    SDL_GPUBuffer *field_arguments; // SDL_GPUIndirectDispatchCommand for the evaluation, empty when nothing moved, then two stale flags
+    u32 field_parity; // which of the stale flags this frame uses
+    u32 field_sample_capacity;
+    u32 field_anchor_capacity;
+    GraphicsFieldGrid field_grid;
+    f32 field_gravity; // and softening, the ones `field_samples` were evaluated with
+    f32 field_softening;
+    u32 field_revision; // Appearance.revision `field_samples` were evaluated for
+    SDL_GPUTextureFormat format; // of every color target the pipelines draw into
 } Graphics;
 
+// a NULL window builds the pipelines for GRAPHICS_OFFSCREEN_FORMAT, for drawing into offscreen targets only
 SDL_AppResult graphics_init(Graphics *gfx, SDL_GPUDevice *gpu, SDL_Window *window);
-typedef struct {
-    SDL_GPUDevice *gpu;
-    SDL_FColor color;
-} GraphicsAddBodyInfo;
-
-u32 graphics_add_body(Graphics *gfx, SDL_GPUDevice *gpu, SDL_GPUCopyPass *copy_pass, SDL_FColor *color);
 typedef struct {
     SDL_Window *window;
     SDL_GPUDevice *gpu;
@@ -44,9 +77,14 @@ typedef struct {
     const Ghost *ghost;
     const Trails *trails;
     const Trajectories *trajectories;
+    const Tracking *tracking;
     const Camera *cam;
+    const Appearance *appearance;
+    SDL_GPUTexture *target; // drawn into instead of the swapchain when set
+    u32 target_width;
+    u32 target_height;
 } GraphicsDrawInfo;
-void graphics_draw(const Graphics *gfx, const GraphicsDrawInfo *info);
+SDL_GPUTexture *graphics_draw(Graphics *gfx, const GraphicsDrawInfo *info); // the texture drawn into, NULL without a swapchain
 void graphics_free(const Graphics *gfx, SDL_GPUDevice *gpu);
 
 #endif
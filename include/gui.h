@@ -4,18 +4,71 @@
 typedef struct Simulation Simulation;
 typedef struct Camera Camera;
 typedef struct Ghost Ghost;
+typedef struct Trails Trails;
 typedef struct Trajectories Trajectories;
-typedef struct Graphics Graphics;
+typedef struct Appearance Appearance;
+typedef struct Recorder Recorder;
+typedef struct Exporter Exporter;
+typedef struct Replay Replay;
+typedef struct History History;
+typedef struct Diagnostics Diagnostics;
 
 #include <stdbool.h>
 #include "SDL3/SDL_video.h"
 #include "SDL3/SDL_gpu.h"
 #include "SDL3/SDL_events.h"
 #include "dcimgui.h"
+#include "constants.h"
+#include "generators.h"
+#include "tracking.h"
+#include "exporter.h"
 #include "types.h"
 
+// how many steps a frame simulates: enough to keep up with real time (scaled), a fixed number,
+// or as many as fit while still drawing `render_rate` frames per second
+typedef enum {
+    RATE_REAL_TIME,
+    RATE_STEPS_PER_FRAME,
+    RATE_UNCAPPED,
+    RATE_COUNT
+} SimulationRate;
+
 typedef struct {
     f32 fixed_delta_time;
+    SimulationRate simulation_rate;
+    f32 time_scale;
+    u32 steps_per_frame;
+    f32 render_rate;
+    SDL_GPUPresentMode present_mode;
+    u32 trail_length;
+    u32 prediction_length;
+    bool compact_history; // half precision trails and predictions
+    TrackingMode tracking_mode;
+    bool toggle_tracked; // the followed body
+    u32 heaviest_count;
+    bool track_heaviest;
+    char snapshot_path[FILE_PATH_LENGTH];
+    bool save_snapshot;
+    bool load_snapshot;
+    char recording_path[FILE_PATH_LENGTH];
+    u32 record_interval;
+    u32 keyframe_interval;
+    bool toggle_recording;
+    char export_path[FILE_PATH_LENGTH];
+    ExportFormat export_format;
+    u32 export_width;
+    u32 export_height;
+    u32 export_interval;
+    bool toggle_export;
+    char replay_path[FILE_PATH_LENGTH];
+    bool toggle_replay;
+    u32 rewind_steps;
+    bool rewind;
+    GeneratorOptions generator;
+    bool replace_bodies;
+    bool generate;
+    char import_path[FILE_PATH_LENGTH];
+    bool import_bodies;
 } ApplicationOptions;
 
 typedef struct {
@@ -25,13 +78,20 @@ typedef struct {
 void gui_init(Gui *gui, SDL_Window *window, SDL_GPUDevice *gpu);
 typedef struct {
     ApplicationOptions *app;
+    const Recorder *rec;
+    const Exporter *exporter;
+    Replay *replay;
+    History *history;
+    Diagnostics *diag;
     Simulation *sim;
     Ghost *ghost;
     Trajectories *trajectories;
+    const Tracking *tracking;
     Camera *cam;
-    Graphics *gfx;
+    Appearance *appearance;
 } GuiUpdateInfo;
 void gui_update(const GuiUpdateInfo *info);
+void gui_draw(SDL_GPUCommandBuffer *command_buffer, SDL_GPUTexture *swapchain);
 void gui_event(const SDL_Event *event);
 void gui_free(void);
 
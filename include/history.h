@@ -0,0 +1,42 @@
+#ifndef N_BODY_HISTORY
+#define N_BODY_HISTORY
+
+#include <stdbool.h>
+#include "SDL3/SDL_gpu.h"
+#include "types.h"
+
+typedef struct Simulation Simulation;
+
+#define HISTORY_LENGTH 32 // at most, large scenes keep as many states as fit in HISTORY_MEMORY_BUDGET
+#define HISTORY_MEMORY_BUDGET (128u << 20)
+#define HISTORY_INTERVAL_DEFAULT 100
+
+typedef struct {
+    u64 step;
+} HistoryEntry;
+
+// the last `length` states, copied on the GPU and never read back.
+// each slot holds positions, velocities then masses, and the ring is cleared whenever the body count changes
+typedef struct History {
+    bool enabled;
+    u32 interval;
+    u64 next_step;
+    SDL_GPUBuffer *buffer;
+    u32 slot_size;
+    u32 length; // 0 while the scene is too large to keep at least two states
+    u32 body_count;
+    u32 head;
+    u32 count;
+    HistoryEntry entries[HISTORY_LENGTH];
+} History;
+
+void history_init(History *history);
+void history_clear(History *history);
+u32 history_length(u32 body_count);
+bool history_due(const History *history, const Simulation *sim);
+void history_capture(History *history, SDL_GPUDevice *gpu, SDL_GPUCommandBuffer *command_buffer, const Simulation *sim);
+u64 history_oldest_step(const History *history);
+u64 history_rewind(History *history, SDL_GPUCopyPass *copy_pass, Simulation *sim, u64 step);
+void history_free(History *history, SDL_GPUDevice *gpu);
+
+#endif
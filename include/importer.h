@@ -0,0 +1,17 @@
+#ifndef N_BODY_IMPORTER
+#define N_BODY_IMPORTER
+
+#include <stdbool.h>
+#include "bodies.h"
+#include "types.h"
+
+#define IMPORTER_MAX_THREADS 32
+#define IMPORTER_CHUNK_MIN (1 << 20) // bytes, below this a thread isn't worth starting
+#define IMPORT_PATH_DEFAULT "bodies.csv"
+
+// one body per line: x, y, vx, vy[, mass[, r, g, b[, movable]]], separated by commas, semicolons or whitespace.
+// lines that don't start with a number (headers, # comments) are skipped, missing columns get the defaults.
+// rows that don't parse, or whose mass isn't positive and finite, are skipped with a warning
+bool import_csv(const char *path, BodyTable *bodies);
+
+#endif
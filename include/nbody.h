@@ -0,0 +1,27 @@
+#ifndef N_BODY
+#define N_BODY
+
+// nbody_core: the simulation, its GPU modules and file formats, usable without a window or ImGui.
+// every module takes the SDL_GPUDevice it runs on, so an embedder creates the device and owns the frame loop
+#include "constants.h"
+#include "simulation.h"
+#include "appearance.h"
+#include "trails.h"
+#include "trajectories.h"
+#include "tracking.h"
+#include "camera.h"
+#include "ghost.h"
+#include "bodies.h"
+#include "generators.h"
+#include "importer.h"
+#include "snapshot.h"
+#include "readback.h"
+#include "recorder.h"
+#include "exporter.h"
+#include "replay.h"
+#include "history.h"
+#include "checkpoint.h"
+#include "diagnostics.h"
+#include "tracer.h"
+
+#endif
@@ -0,0 +1,54 @@
+#ifndef N_BODY_READBACK
+#define N_BODY_READBACK
+
+#include <stdbool.h>
+#include "SDL3/SDL_gpu.h"
+#include "SDL3/SDL_atomic.h"
+#include "SDL3/SDL_mutex.h"
+#include "SDL3/SDL_thread.h"
+#include "types.h"
+
+#define READBACK_SLOTS_MAX 16
+
+typedef struct {
+    SDL_GPUTransferBuffer *transfer_buffer;
+    u32 capacity;
+    u32 size; // of this capture, nothing is mapped for 0
+    const u8 *data; // mapped from ready until released
+    SDL_GPUFence *fence; // shared by every slot captured in the same frame
+} ReadbackSlot;
+
+// gets each capture in order with the index of its slot, `data` is NULL if it was empty or couldn't be mapped
+typedef void (*ReadbackRead)(void *user, u32 index, const u8 *data);
+
+// a ring of download transfer buffers, each slot moves captured -> submitted -> ready -> written -> released.
+// `ready` and `written` are the lock-free handoff to and from the writer thread, without one the captures are
+// read on the polling thread instead. owners keep whatever they need per capture in arrays indexed like the slots
+typedef struct Readback {
+    ReadbackSlot slots[READBACK_SLOTS_MAX];
+    u32 slot_count;
+    ReadbackRead read;
+    void *user;
+
+    u32 captured;
+    u32 submitted;
+    u32 released;
+    SDL_AtomicU32 ready;
+    SDL_AtomicU32 written;
+    SDL_AtomicInt stop;
+    SDL_Semaphore *wake;
+    SDL_Thread *writer;
+} Readback;
+
+void readback_init(Readback *rb, u32 slot_count, ReadbackRead read, void *user);
+bool readback_start(Readback *rb, const char *thread_name); // `thread_name` NULL reads on the polling thread
+bool readback_available(const Readback *rb);
+bool readback_reserve(ReadbackSlot *slot, SDL_GPUDevice *gpu, u32 size);
+ReadbackSlot *readback_next(Readback *rb); // the slot the next capture goes into
+u32 readback_capture(Readback *rb, u32 size);
+void readback_submit(Readback *rb, SDL_GPUDevice *gpu);
+void readback_poll(Readback *rb, SDL_GPUDevice *gpu, bool wait);
+void readback_stop(Readback *rb, SDL_GPUDevice *gpu);
+void readback_free(Readback *rb, SDL_GPUDevice *gpu);
+
+#endif
@@ -0,0 +1,86 @@
+#ifndef N_BODY_RECORDER
+#define N_BODY_RECORDER
+
+#include <stdbool.h>
+#include "SDL3/SDL_gpu.h"
+#include "SDL3/SDL_atomic.h"
+#include "SDL3/SDL_iostream.h"
+#include "snapshot.h"
+#include "readback.h"
+#include "types.h"
+
+#define RECORDING_MAGIC 0x4352424Eu // "NBRC"
+#define RECORDING_VERSION 2
+#define RECORDING_PATH_DEFAULT "recording.nbrec"
+#define RECORD_INTERVAL_DEFAULT 1
+#define RECORD_KEYFRAME_INTERVAL_DEFAULT 64
+#define RECORDER_SLOTS 16
+
+#define RECORDING_FRAME_KEYFRAME 1u
+
+// native endian: header, a snapshot of the starting state, frames, then the frame index.
+// a recording that was not stopped cleanly has no index and has to be scanned frame by frame
+typedef struct {
+    u32 magic;
+    u32 version;
+    u32 header_size;
+    u32 interval;           // simulation steps between frames
+    u32 keyframe_interval;  // frames between keyframes
+    f32 delta_time;
+    u64 snapshot_offset;
+    u64 snapshot_size;
+    u64 index_offset;       // 0 if there is no index
+    u64 frame_count;
+} RecordingHeader;
+
+// followed by body_count positions, and body_count velocities as well on keyframes
+typedef struct {
+    u64 step;
+    u32 body_count;
+    u32 flags;
+} RecordingFrame;
+
+typedef struct {
+    u64 step;
+    u64 offset;
+    u32 body_count;
+    u32 flags;
+} RecordingIndexEntry;
+
+typedef struct Recorder {
+    bool recording;
+    u32 interval;
+    u32 keyframe_interval;
+    u64 next_step;
+    u64 frames;
+    u64 dropped;
+
+    Readback readback;
+    RecordingFrame captures[RECORDER_SLOTS]; // one per readback slot
+    SDL_AtomicInt failed;
+
+    // owned by the writer thread while recording
+    SDL_IOStream *io;
+    RecordingHeader header;
+    RecordingIndexEntry *index;
+    u64 offset;
+} Recorder;
+
+void recorder_init(Recorder *rec);
+typedef struct {
+    const char *path;
+    u32 interval;
+    u32 keyframe_interval;
+    f32 delta_time;
+    const SnapshotInfo *snapshot;
+} RecorderStartInfo;
+bool recorder_start(Recorder *rec, const RecorderStartInfo *info);
+bool recorder_due(const Recorder *rec, const Simulation *sim);
+bool recorder_available(const Recorder *rec);
+void recorder_capture(Recorder *rec, SDL_GPUDevice *gpu, SDL_GPUCommandBuffer *command_buffer, const Simulation *sim);
+void recorder_submit(Recorder *rec, SDL_GPUDevice *gpu);
+void recorder_poll(Recorder *rec, SDL_GPUDevice *gpu, bool wait);
+void recorder_stop(Recorder *rec, SDL_GPUDevice *gpu);
+void recorder_free(Recorder *rec, SDL_GPUDevice *gpu);
+
+#endif
@@ -0,0 +1,58 @@
+#ifndef N_BODY_REPLAY
+#define N_BODY_REPLAY
+
+#include <stdbool.h>
+#include "SDL3/SDL_gpu.h"
+#include "SDL3/SDL_atomic.h"
+#include "SDL3/SDL_iostream.h"
+#include "SDL3/SDL_mutex.h"
+#include "SDL3/SDL_thread.h"
+#include "recorder.h"
+#include "snapshot.h"
+#include "types.h"
+
+#define REPLAY_BUFFERS 3 // the shown frame, the next one and one spare for seeks
+
+typedef enum {
+    REPLAY_BUFFER_EMPTY,
+    REPLAY_BUFFER_REQUESTED, // owned by the loader thread
+    REPLAY_BUFFER_READY,
+} ReplayBufferState;
+
+typedef struct {
+    u8 *data;
+    usize capacity;
+    usize size;
+    u64 frame;
+    SDL_AtomicInt state;
+} ReplayBuffer;
+
+typedef struct Replay {
+    bool open;
+    bool seek; // set when `position` jumped, the trails are collapsed onto the new frame
+    f32 speed;
+    f64 position; // in frames
+    u64 shown;
+    u32 body_count;
+    bool trajectories_enabled;
+
+    RecordingHeader header;
+    RecordingIndexEntry *index;
+    SDL_IOStream *io; // owned by the loader thread while open
+
+    ReplayBuffer buffers[REPLAY_BUFFERS];
+    SDL_Thread *loader;
+    SDL_Semaphore *wake;
+    SDL_AtomicInt stop;
+
+    SDL_GPUTransferBuffer *transfer_buffer;
+    u32 transfer_capacity;
+} Replay;
+
+void replay_init(Replay *replay);
+bool replay_open(Replay *replay, const char *path, const SnapshotInfo *info);
+bool replay_update(Replay *replay, SDL_GPUDevice *gpu, SDL_GPUCopyPass *copy_pass, Simulation *sim, Trails *trails, f32 delta_time);
+void replay_close(Replay *replay, const SnapshotInfo *info);
+void replay_free(Replay *replay, SDL_GPUDevice *gpu);
+
+#endif
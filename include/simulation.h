@@ -5,6 +5,7 @@
 #include "SDL3/SDL_gpu.h"
 #include "HandmadeMath.h"
 #include "sdl_utils.h"
+#include "bodies.h"
 #include "types.h"
 
 typedef struct {
@@ -12,6 +13,7 @@ typedef struct {
         INTEGRATOR_EULER,
         INTEGRATOR_VERLET,
         INTEGRATOR_RUNGE_KUTTA_4,
+        INTEGRATOR_COUNT,
     } integrator;
     f32 gravity;
     f32 softening;
@@ -19,15 +21,24 @@ typedef struct {
     bool paused;
 } SimulationOptions;
 
+// force evaluations per step, each one a dispatch over every body so it sees the others' positions of the same stage.
+// the simulation runs Euler's single stage in place of the positions it reads, so it adds a pass that commits them
+#define INTEGRATOR_STAGES(integrator) ((integrator) == INTEGRATOR_EULER ? 1u : (integrator) == INTEGRATOR_VERLET ? 2u : 4u)
+#define SIMULATION_STAGES(integrator) SDL_max(INTEGRATOR_STAGES(integrator), 2u)
+#define INTEGRATOR_STAGES_MAX 4
+#define INTEGRATOR_SCRATCH_SIZE (3 * 4 * sizeof(f32)) // per body, what one stage hands to the next
+
 typedef struct Simulation {
     SimulationOptions options;
-    SDL_GPUComputePipeline *integrators[3];
+    SDL_GPUComputePipeline *integrators[INTEGRATOR_COUNT][INTEGRATOR_STAGES_MAX]; // [integrator][stage]
 
     GPUArray positions;
     GPUArray velocities;
     GPUArray masses;
     GPUArray movable;
+    GPUArray scratch; // body_count + 1 entries, predictions use the spare one for the ghost
     u32 body_count;
+    u64 step;
 } Simulation;
 
 SDL_AppResult simulation_init(Simulation *sim, SDL_GPUDevice *gpu);
@@ -39,7 +50,10 @@ typedef struct {
 } SimulationAddBodyInfo;
 
 u32 simulation_add_body(Simulation *sim, SDL_GPUDevice *gpu, SDL_GPUCopyPass *copy_pass, const SimulationAddBodyInfo *body);
-void simulation_update(const Simulation *sim, SDL_GPUCommandBuffer *command_buffer, SDL_GPUComputePass *compute_pass, f32 delta_time);
+u32 simulation_add_bodies(Simulation *sim, SDL_GPUDevice *gpu, SDL_GPUCopyPass *copy_pass, const BodyTable *bodies);
+void simulation_clear(Simulation *sim);
+void simulation_reserve_scratch(Simulation *sim, SDL_GPUDevice *gpu, SDL_GPUCopyPass *copy_pass);
+void simulation_update(Simulation *sim, SDL_GPUCommandBuffer *command_buffer, SDL_GPUComputePass *compute_pass, f32 delta_time);
 void simulation_free(const Simulation *sim, SDL_GPUDevice *gpu);
 
 #endif
@@ -0,0 +1,72 @@
+#ifndef N_BODY_SNAPSHOT
+#define N_BODY_SNAPSHOT
+
+#include <stdbool.h>
+#include "SDL3/SDL_gpu.h"
+#include "SDL3/SDL_iostream.h"
+#include "simulation.h"
+#include "appearance.h"
+#include "camera.h"
+#include "types.h"
+
+typedef struct Trails Trails;
+typedef struct Trajectories Trajectories;
+typedef struct Tracking Tracking;
+
+#define SNAPSHOT_MAGIC 0x534E424Eu // "NBNS"
+#define SNAPSHOT_VERSION 6
+#define SNAPSHOT_ALIGNMENT 64
+#define SNAPSHOT_MAX_BLOCKS 8
+#define SNAPSHOT_PATH_DEFAULT "snapshot.nbody"
+#define SNAPSHOT_TRAILS_MAX_SIZE (256u << 20) // larger trail rings are left out and start collapsed after loading
+
+typedef enum {
+    SNAPSHOT_BLOCK_POSITIONS,
+    SNAPSHOT_BLOCK_VELOCITIES,
+    SNAPSHOT_BLOCK_MASSES,
+    SNAPSHOT_BLOCK_MOVABLE,
+    SNAPSHOT_BLOCK_COLORS,
+    SNAPSHOT_BLOCK_TRAILS, // empty or `trail_length` positions per body, always empty for compact or partially tracked trails
+    SNAPSHOT_BLOCK_COUNT,
+} SnapshotBlockType;
+
+// offsets are relative to the start of the snapshot and SNAPSHOT_ALIGNMENT aligned
+typedef struct {
+    u64 offset;
+    u64 size;
+} SnapshotBlock;
+
+// native endian, every block is laid out exactly like its GPUArray so loading is one upload per block
+typedef struct {
+    u32 magic;
+    u32 version;
+    u32 header_size;
+    u32 body_count;
+    u32 block_count;
+    u32 trail_length;
+    u32 trail_frame;
+    u32 _padding;
+    u64 step;
+    SnapshotBlock blocks[SNAPSHOT_MAX_BLOCKS];
+    SimulationOptions simulation;
+    GraphicsOptions graphics;
+    Camera camera;
+} SnapshotHeader;
+
+typedef struct {
+    SDL_GPUDevice *gpu;
+    Simulation *sim;
+    Appearance *appearance;
+    Trails *trails;
+    Trajectories *trajectories; // optional, headless runs have no predictions
+    Tracking *tracking; // the tracking mode is kept, every body starts out tracked or untracked by it
+    Camera *cam;
+} SnapshotInfo;
+
+bool snapshot_write(SDL_IOStream *io, const SnapshotInfo *info);
+bool snapshot_read(SDL_IOStream *io, const SnapshotInfo *info);
+bool snapshot_save(const char *path, const SnapshotInfo *info);
+bool snapshot_load(const char *path, const SnapshotInfo *info);
+bool snapshot_peek(const char *path, SnapshotHeader *header); // header only, nothing is uploaded
+
+#endif
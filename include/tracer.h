@@ -0,0 +1,31 @@
+#ifndef N_BODY_TRACER
+#define N_BODY_TRACER
+
+#include <stdbool.h>
+#include "SDL3/SDL_events.h"
+#include "types.h"
+
+// per-thread ring capacity, oldest events are overwritten once full
+#define TRACE_EVENT_CAPACITY 16384
+#define TRACE_MAX_DEPTH 32
+#define TRACE_MAX_THREADS 16
+#define TRACE_DUMP_PATH "trace.json"
+
+// `name` must outlive the tracer (string literals only)
+void tracer_begin(const char *name);
+void tracer_end(void);
+bool tracer_dump(const char *path);
+void tracer_keyboard(const SDL_Event *event);
+
+#ifdef N_BODY_TRACING
+#define TRACE_BEGIN(name) tracer_begin(name)
+#define TRACE_END() tracer_end()
+// wraps the following statement or block, don't `return` out of it!
+#define TRACE_SCOPE(name) for (int trace_once_ = (tracer_begin(name), 1); trace_once_; trace_once_ = (tracer_end(), 0))
+#else
+#define TRACE_BEGIN(name) ((void) 0)
+#define TRACE_END() ((void) 0)
+#define TRACE_SCOPE(name)
+#endif
+
+#endif
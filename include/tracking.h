@@ -0,0 +1,42 @@
+#ifndef N_BODY_TRACKING
+#define N_BODY_TRACKING
+
+#include <stdbool.h>
+#include "sdl_utils.h"
+#include "types.h"
+
+#define TRACKING_NONE ((u32) -1)
+#define TRACKING_HEAVIEST_DEFAULT 8
+
+typedef enum {
+    TRACKING_ALL,      // every body has a trail and a prediction, slot i is body i
+    TRACKING_SELECTED, // only the bodies passed to tracking_add
+    TRACKING_MODE_COUNT,
+} TrackingMode;
+
+extern const char *TRACKING_MODE_NAMES[TRACKING_MODE_COUNT];
+
+// the sparse slot table shared by trails and predictions, both are stored and drawn per slot instead of per body.
+// removing a body moves the last slot into its place, so slots stay dense and only that one trail has to move
+typedef struct Tracking {
+    TrackingMode mode;
+    u32 body_count;
+    u32 *slots;  // stb_ds array, body -> slot or TRACKING_NONE
+    u32 *bodies; // stb_ds array, slot -> body
+    GPUArray slot_table; // GPU copies of the two arrays
+    GPUArray body_table;
+    bool dirty;
+} Tracking;
+
+SDL_AppResult tracking_init(Tracking *tracking, SDL_GPUDevice *gpu);
+u32 tracking_slot_count(const Tracking *tracking);
+u32 tracking_slot(const Tracking *tracking, u32 body);
+u32 tracking_add_bodies(Tracking *tracking, u32 count); // returns how many slots were appended
+bool tracking_add(Tracking *tracking, u32 body);
+bool tracking_remove(Tracking *tracking, u32 body, u32 *slot); // `slot` is the freed slot the last one moved into
+void tracking_set_mode(Tracking *tracking, TrackingMode mode);
+void tracking_clear(Tracking *tracking);
+void tracking_upload(Tracking *tracking, SDL_GPUDevice *gpu, SDL_GPUCopyPass *copy_pass);
+void tracking_free(Tracking *tracking, SDL_GPUDevice *gpu);
+
+#endif
@@ -5,18 +5,36 @@
 #include "HandmadeMath.h"
 
 typedef struct Simulation Simulation;
+typedef struct Tracking Tracking;
+
+// compact trails store half precision offsets from a per body anchor instead of positions, half the memory
+#define TRAIL_POINT_SIZE(compact) ((compact) ? sizeof(u32) : sizeof(HMM_Vec2))
 
 typedef struct Trails {
-    SDL_GPUComputePipeline *pipeline;
+    SDL_GPUComputePipeline *pipelines[2]; // [compact]
+    SDL_GPUComputePipeline *reset_pipelines[2]; // [compact]
     GPUArray array;
-    u32 body_count;
+    GPUArray anchors;
+    bool compact;
+    u32 slot_count; // one ring per tracked body, see tracking.h
+    u32 length;
     u32 frame;
+    u32 reset_from; // trails from this slot on are collapsed onto their body at the next update
 } Trails;
 
 SDL_AppResult trails_init(Trails *trails, SDL_GPUDevice *gpu);
 
-u32 trails_add_body(Trails *trails, SDL_GPUDevice *gpu, SDL_GPUCopyPass *copy_pass, HMM_Vec2 position);
-void trails_update(Trails *trails, SDL_GPUCommandBuffer *command_buffer, SDL_GPUComputePass *compute_pass, const Simulation *sim);
+u32 trails_add_slots(Trails *trails, SDL_GPUDevice *gpu, SDL_GPUCopyPass *copy_pass, u32 count);
+void trails_remove_slot(Trails *trails, SDL_GPUCopyPass *copy_pass, u32 slot); // the last slot moves into `slot`
+void trails_clear(Trails *trails);
+void trails_resize(Trails *trails, SDL_GPUDevice *gpu, u32 length, bool compact);
+typedef struct {
+    SDL_GPUCommandBuffer *command_buffer;
+    SDL_GPUComputePass *compute_pass;
+    const Simulation *sim;
+    const Tracking *tracking;
+} TrailsUpdateInfo;
+void trails_update(Trails *trails, const TrailsUpdateInfo *info);
 void trails_free(const Trails *trails, SDL_GPUDevice *gpu);
 
 #endif
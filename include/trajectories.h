@@ -3,27 +3,40 @@
 
 #include "HandmadeMath.h"
 #include "sdl_utils.h"
+#include "simulation.h"
 
 typedef struct Simulation Simulation;
 typedef struct Ghost Ghost;
+typedef struct Tracking Tracking;
+
+// compact predictions store half precision offsets from the body's current position, half the memory
+#define TRAJECTORY_POINT_SIZE(compact) ((compact) ? sizeof(u32) : sizeof(HMM_Vec2))
+#define TRAJECTORY_STATE_SIZE (3 * sizeof(HMM_Vec2)) // previous and current position, velocity
 
 typedef struct Trajectories {
-    SDL_GPUComputePipeline *pipeline;
-    SDL_GPUComputePipeline *ghost_pipeline;
-    GPUArray positions;
-    GPUArray velocities;
+    SDL_GPUComputePipeline *pipelines[INTEGRATOR_COUNT][INTEGRATOR_STAGES_MAX][2][2]; // [integrator][stage][ghost enabled][compact]
+    SDL_GPUComputePipeline *ghost_pipelines[INTEGRATOR_COUNT][INTEGRATOR_STAGES_MAX][2]; // [integrator][stage][compact]
+    GPUArray positions; // `length` points per tracked body, see tracking.h
+    GPUArray state; // per body, every body is integrated since they all pull on the tracked ones
     SDL_GPUBuffer *ghost;
+    bool compact;
     u32 body_count;
+    u32 slot_count;
+    u32 length;
     bool enabled;
 } Trajectories;
 
 SDL_AppResult trajectories_init(Trajectories *trajectories, SDL_GPUDevice *gpu);
-u32 trajectories_add_body(Trajectories *trajectories, SDL_GPUDevice *gpu, SDL_GPUCopyPass *copy_pass, HMM_Vec2 position);
+u32 trajectories_add_bodies(Trajectories *trajectories, SDL_GPUDevice *gpu, SDL_GPUCopyPass *copy_pass, u32 count);
+void trajectories_set_slots(Trajectories *trajectories, SDL_GPUDevice *gpu, SDL_GPUCopyPass *copy_pass, u32 slot_count);
+void trajectories_clear(Trajectories *trajectories);
+void trajectories_resize(Trajectories *trajectories, SDL_GPUDevice *gpu, u32 length, bool compact);
 typedef struct {
     SDL_GPUCommandBuffer *command_buffer;
     SDL_GPUComputePass *compute_pass;
     const Simulation *sim;
     const Ghost *ghost;
+    const Tracking *tracking;
     f32 delta_time;
 } TrajectoriesUpdateInfo;
 void trajectories_update(const Trajectories *trajectories, const TrajectoriesUpdateInfo *info);
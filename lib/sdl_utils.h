@@ -15,6 +15,65 @@ static SDL_GPUColorTargetBlendState BLEND_STATE = {
     .dst_alpha_blendfactor = SDL_GPU_BLENDFACTOR_ONE_MINUS_SRC_ALPHA
 };
 
+// pre-reflected resource counts written next to each .spv by compile_shaders.py
+#define SHADER_METADATA_VERSION 1
+#define SHADER_CACHE_DIRECTORY "shaders/cache"
+#define SHADER_CACHE_VERSION 1
+
+static inline bool LoadSPIRVMetadata(const char *shader_path, u32 *values, const usize values_count) {
+    char metadata_path[512];
+    const usize length = SDL_strlen(shader_path);
+    if (length < 4 || length + 2 > sizeof(metadata_path) || SDL_strcmp(shader_path + length - 4, ".spv") != 0) return false;
+    SDL_memcpy(metadata_path, shader_path, length - 3);
+    SDL_strlcpy(metadata_path + length - 3, "meta", sizeof(metadata_path) - (length - 3));
+
+    char *metadata = SDL_LoadFile(metadata_path, NULL);
+    if (metadata == NULL) return false;
+
+    char *cursor = metadata;
+    const u32 version = (u32) SDL_strtoul(cursor, &cursor, 10);
+    usize parsed = 0;
+    while (version == SHADER_METADATA_VERSION && parsed < values_count) {
+        char *end;
+        values[parsed] = (u32) SDL_strtoul(cursor, &end, 10);
+        if (end == cursor) break;
+        cursor = end;
+        parsed++;
+    }
+
+    SDL_free(metadata);
+    return parsed == values_count;
+}
+
+static inline u64 HashSPIRV(const void *code, const usize size) {
+    u64 hash = 0xcbf29ce484222325ull; // FNV-1a
+    for (usize i = 0; i < size; i++) hash = (hash ^ ((const u8 *) code)[i]) * 0x100000001b3ull;
+    return hash;
+}
+
+// SPIRV-Cross output is cached on disk keyed by the SPIR-V hash so only the first launch pays for translation
+static inline char *LoadCachedMSL(const void *shader_code, const usize shader_size, const SDL_ShaderCross_ShaderStage stage) {
+    char cache_path[128];
+    SDL_snprintf(cache_path, sizeof(cache_path), "%s/%016" SDL_PRIx64 ".v%d.msl", SHADER_CACHE_DIRECTORY, HashSPIRV(shader_code, shader_size), SHADER_CACHE_VERSION);
+
+    char *msl = SDL_LoadFile(cache_path, NULL);
+    if (msl != NULL) return msl;
+
+    msl = SDL_ShaderCross_TranspileMSLFromSPIRV(&(SDL_ShaderCross_SPIRV_Info) {
+        .bytecode = shader_code,
+        .bytecode_size = shader_size,
+        .entrypoint = "main",
+        .shader_stage = stage,
+    });
+
+    if (msl == NULL) return NULL;
+    if (!SDL_CreateDirectory(SHADER_CACHE_DIRECTORY) || !SDL_SaveFile(cache_path, msl, SDL_strlen(msl))) {
+        SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "SDL_SaveFile() in LoadCachedMSL(): Couldn't cache shader at path %s.\n", cache_path);
+    }
+
+    return msl;
+}
+
 static inline SDL_GPUShader *LoadSPIRVShader(SDL_GPUDevice *gpu, const char *shader_path) {
     SDL_ShaderCross_ShaderStage stage;
     if (SDL_strstr(shader_path, ".vert")) stage = SDL_SHADERCROSS_SHADERSTAGE_VERTEX;
@@ -31,16 +90,66 @@ static inline SDL_GPUShader *LoadSPIRVShader(SDL_GPUDevice *gpu, const char *sha
         return NULL;
     }
 
-    const SDL_ShaderCross_GraphicsShaderMetadata *metadata = SDL_ShaderCross_ReflectGraphicsSPIRV(shader_code, shader_size, 0);
-    SDL_GPUShader *shader = SDL_ShaderCross_CompileGraphicsShaderFromSPIRV(gpu, &(SDL_ShaderCross_SPIRV_Info) {
-        .bytecode = shader_code,
-        .bytecode_size = shader_size,
-        .entrypoint = "main",
-        .shader_stage = stage,
-    }, &metadata->resource_info, 0);
+    SDL_ShaderCross_GraphicsShaderResourceInfo resources;
+    u32 values[4];
+    if (LoadSPIRVMetadata(shader_path, values, 4)) {
+        resources = (SDL_ShaderCross_GraphicsShaderResourceInfo) {
+            .num_samplers = values[0],
+            .num_storage_textures = values[1],
+            .num_storage_buffers = values[2],
+            .num_uniform_buffers = values[3],
+        };
+    } else {
+        const SDL_ShaderCross_GraphicsShaderMetadata *metadata = SDL_ShaderCross_ReflectGraphicsSPIRV(shader_code, shader_size, 0);
+        if (metadata == NULL) {
+            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "SDL_ShaderCross_ReflectGraphicsSPIRV() in LoadSPIRVShader(): Couldn't reflect shader at path %s.\n", shader_path);
+            SDL_free((void *) shader_code);
+            return NULL;
+        }
+
+        resources = metadata->resource_info;
+        SDL_free((void *) metadata);
+    }
+
+    SDL_GPUShader *shader;
+    const SDL_GPUShaderFormat formats = SDL_GetGPUShaderFormats(gpu);
+    const SDL_GPUShaderStage gpu_stage = stage == SDL_SHADERCROSS_SHADERSTAGE_VERTEX ? SDL_GPU_SHADERSTAGE_VERTEX : SDL_GPU_SHADERSTAGE_FRAGMENT;
+    char *msl = NULL;
+    if (formats & SDL_GPU_SHADERFORMAT_SPIRV) {
+        shader = SDL_CreateGPUShader(gpu, &(SDL_GPUShaderCreateInfo) {
+            .code = shader_code,
+            .code_size = shader_size,
+            .entrypoint = "main",
+            .format = SDL_GPU_SHADERFORMAT_SPIRV,
+            .stage = gpu_stage,
+            .num_samplers = resources.num_samplers,
+            .num_storage_textures = resources.num_storage_textures,
+            .num_storage_buffers = resources.num_storage_buffers,
+            .num_uniform_buffers = resources.num_uniform_buffers,
+        });
+    } else if ((formats & SDL_GPU_SHADERFORMAT_MSL) && (msl = LoadCachedMSL(shader_code, shader_size, stage))) {
+        shader = SDL_CreateGPUShader(gpu, &(SDL_GPUShaderCreateInfo) {
+            .code = (const u8 *) msl,
+            .code_size = SDL_strlen(msl),
+            .entrypoint = "main0", // SPIRV-Cross renames `main` for MSL
+            .format = SDL_GPU_SHADERFORMAT_MSL,
+            .stage = gpu_stage,
+            .num_samplers = resources.num_samplers,
+            .num_storage_textures = resources.num_storage_textures,
+            .num_storage_buffers = resources.num_storage_buffers,
+            .num_uniform_buffers = resources.num_uniform_buffers,
+        });
+    } else {
+        shader = SDL_ShaderCross_CompileGraphicsShaderFromSPIRV(gpu, &(SDL_ShaderCross_SPIRV_Info) {
+            .bytecode = shader_code,
+            .bytecode_size = shader_size,
+            .entrypoint = "main",
+            .shader_stage = stage,
+        }, &resources, 0);
+    }
 
+    SDL_free(msl);
     SDL_free((void *) shader_code);
-    SDL_free((void *) metadata);
     return shader;
 }
 
@@ -74,7 +183,8 @@ static inline void PrintSPIRVShader(const char *shader_path) {
 }
 
 typedef struct {
-    SDL_Window *window;
+    SDL_Window *window; // NULL for offscreen targets, which use `format` instead
+    SDL_GPUTextureFormat format;
     const char *vertex_shader_path;
     const char *fragment_shader_path;
     SDL_GPUPrimitiveType primitive_type;
@@ -89,7 +199,7 @@ static inline SDL_GPUGraphicsPipeline *CreateGPUGraphicsPipeline(SDL_GPUDevice *
         .target_info = (SDL_GPUGraphicsPipelineTargetInfo) {
             .num_color_targets = 1,
             .color_target_descriptions = &(SDL_GPUColorTargetDescription) {
-                .format = SDL_GetGPUSwapchainTextureFormat(gpu, info->window),
+                .format = info->window ? SDL_GetGPUSwapchainTextureFormat(gpu, info->window) : info->format,
                 .blend_state = BLEND_STATE
             }
         }
@@ -108,13 +218,63 @@ static inline SDL_GPUComputePipeline *CreateGPUComputePipeline(SDL_GPUDevice *gp
         return NULL;
     }
 
-    const SDL_ShaderCross_ComputePipelineMetadata *metadata = SDL_ShaderCross_ReflectComputeSPIRV(shader_code, shader_size, 0);
-    return SDL_ShaderCross_CompileComputePipelineFromSPIRV(gpu, &(SDL_ShaderCross_SPIRV_Info) {
-        .bytecode = shader_code,
-        .bytecode_size = shader_size,
-        .entrypoint = "main",
-        .shader_stage = SDL_SHADERCROSS_SHADERSTAGE_COMPUTE,
-    }, metadata, 0);
+    SDL_ShaderCross_ComputePipelineMetadata metadata;
+    u32 values[9];
+    if (LoadSPIRVMetadata(shader_path, values, 9)) {
+        metadata = (SDL_ShaderCross_ComputePipelineMetadata) {
+            .num_samplers = values[0],
+            .num_readonly_storage_textures = values[1],
+            .num_readonly_storage_buffers = values[2],
+            .num_readwrite_storage_textures = values[3],
+            .num_readwrite_storage_buffers = values[4],
+            .num_uniform_buffers = values[5],
+            .threadcount_x = values[6],
+            .threadcount_y = values[7],
+            .threadcount_z = values[8],
+        };
+    } else {
+        const SDL_ShaderCross_ComputePipelineMetadata *reflected = SDL_ShaderCross_ReflectComputeSPIRV(shader_code, shader_size, 0);
+        if (reflected == NULL) {
+            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "SDL_ShaderCross_ReflectComputeSPIRV() in CreateGPUComputePipeline(): Couldn't reflect shader at path %s.\n", shader_path);
+            SDL_free((void *) shader_code);
+            return NULL;
+        }
+
+        metadata = *reflected;
+        SDL_free((void *) reflected);
+    }
+
+    SDL_GPUComputePipeline *pipeline;
+    const SDL_GPUShaderFormat formats = SDL_GetGPUShaderFormats(gpu);
+    char *msl = NULL;
+    if (formats & SDL_GPU_SHADERFORMAT_SPIRV || ((formats & SDL_GPU_SHADERFORMAT_MSL) && (msl = LoadCachedMSL(shader_code, shader_size, SDL_SHADERCROSS_SHADERSTAGE_COMPUTE)))) {
+        pipeline = SDL_CreateGPUComputePipeline(gpu, &(SDL_GPUComputePipelineCreateInfo) {
+            .code = msl ? (const u8 *) msl : shader_code,
+            .code_size = msl ? SDL_strlen(msl) : shader_size,
+            .entrypoint = msl ? "main0" : "main",
+            .format = msl ? SDL_GPU_SHADERFORMAT_MSL : SDL_GPU_SHADERFORMAT_SPIRV,
+            .num_samplers = metadata.num_samplers,
+            .num_readonly_storage_textures = metadata.num_readonly_storage_textures,
+            .num_readonly_storage_buffers = metadata.num_readonly_storage_buffers,
+            .num_readwrite_storage_textures = metadata.num_readwrite_storage_textures,
+            .num_readwrite_storage_buffers = metadata.num_readwrite_storage_buffers,
+            .num_uniform_buffers = metadata.num_uniform_buffers,
+            .threadcount_x = metadata.threadcount_x,
+            .threadcount_y = metadata.threadcount_y,
+            .threadcount_z = metadata.threadcount_z,
+        });
+    } else {
+        pipeline = SDL_ShaderCross_CompileComputePipelineFromSPIRV(gpu, &(SDL_ShaderCross_SPIRV_Info) {
+            .bytecode = shader_code,
+            .bytecode_size = shader_size,
+            .entrypoint = "main",
+            .shader_stage = SDL_SHADERCROSS_SHADERSTAGE_COMPUTE,
+        }, &metadata, 0);
+    }
+
+    SDL_free(msl);
+    SDL_free((void *) shader_code);
+    return pipeline;
 }
 
 typedef struct {
@@ -204,6 +364,32 @@ static inline void ReadFromGPUBufferNow(SDL_GPUDevice *gpu, const ReadGPUBufferB
     SDL_ReleaseGPUTransferBuffer(gpu, transfer_buffer);
 }
 
+// non-blocking counterpart to ReadFromGPUBufferNow, `destination_offset` is the offset into the transfer buffer
+// and the data can be mapped once a fence acquired after this command buffer's submission has signaled
+static inline u32 DownloadFromGPUBuffers(SDL_GPUCopyPass *copy_pass, SDL_GPUTransferBuffer *transfer_buffer, const ReadGPUBufferBinding *bindings, const usize bindings_count) {
+    u32 end = 0;
+    for (usize i = 0; i < bindings_count; i++) {
+        if (bindings[i].size == 0) continue;
+        SDL_DownloadFromGPUBuffer(
+            copy_pass,
+            &(SDL_GPUBufferRegion) { .buffer = bindings[i].buffer, .offset = bindings[i].buffer_offset, .size = bindings[i].size },
+            &(SDL_GPUTransferBufferLocation) { .transfer_buffer = transfer_buffer, .offset = bindings[i].destination_offset }
+        );
+
+        if (bindings[i].destination_offset + bindings[i].size > end) end = bindings[i].destination_offset + bindings[i].size;
+    }
+
+    return end;
+}
+
+// SDL_gpu submits everything to a single queue, so an empty submission's fence
+// signals once every command buffer submitted before it has finished
+static inline SDL_GPUFence *AcquireGPUFenceNow(SDL_GPUDevice *gpu) {
+    SDL_GPUCommandBuffer *command_buffer = SDL_AcquireGPUCommandBuffer(gpu);
+    if (!command_buffer) return NULL;
+    return SDL_SubmitGPUCommandBufferAndAcquireFence(command_buffer);
+}
+
 typedef struct {
     SDL_GPUBuffer *buffer;
     SDL_GPUBufferCreateInfo info;
@@ -241,6 +427,14 @@ static inline void ExpandGPUArray(GPUArray *array, SDL_GPUDevice *gpu, SDL_GPUCo
     SDL_ReleaseGPUBuffer(gpu, old_buffer);
 }
 
+// appends `size` uninitialized bytes, for arrays that are filled in on the GPU
+static inline u32 ReserveGPUArray(GPUArray *array, SDL_GPUDevice *gpu, SDL_GPUCopyPass *copy_pass, const u32 size) {
+    ExpandGPUArray(array, gpu, copy_pass, size);
+    const u32 offset = array->used;
+    array->used += size;
+    return offset;
+}
+
 typedef struct {
     GPUArray *array;
     const u8 *source;
@@ -0,0 +1,279 @@
+#include "accuracy.h"
+#include "constants.h"
+
+#include "SDL3/SDL_stdinc.h"
+#include "sdl_utils.h"
+
+// HandmadeMath has no double precision vectors
+typedef struct {
+    f64 x;
+    f64 y;
+} AccuracyVec2;
+
+typedef struct {
+    const char *name;
+    u32 body_count;
+    f64 masses[ACCURACY_MAX_BODIES];
+    AccuracyVec2 positions[ACCURACY_MAX_BODIES];
+    AccuracyVec2 velocities[ACCURACY_MAX_BODIES];
+    f32 delta_time;
+    u64 steps;
+    f64 tolerance; // largest allowed position error in the scene's length units, float rounding alone stays below 1e-4
+    bool analytic; // a two-body scene that is also checked against its exact orbit, see accuracy_kepler()
+} AccuracyScene;
+
+// all in G = 1 units
+static const AccuracyScene ACCURACY_SCENES[] = {
+    {
+        // equal mass binary at 80% of circular speed, e ≈ 0.36, a few orbits
+        .name = "kepler",
+        .body_count = 2,
+        .masses = { 1.0, 1.0 },
+        .positions = { { -0.5, 0.0 }, { 0.5, 0.0 } },
+        .velocities = { { 0.0, -0.565685424949238 }, { 0.0, 0.565685424949238 } },
+        .delta_time = 1e-3f,
+        .steps = 8000,
+        .tolerance = 1e-3,
+        .analytic = true,
+    },
+    {
+        // Chenciner & Montgomery (2000), one period
+        .name = "figure_eight",
+        .body_count = 3,
+        .masses = { 1.0, 1.0, 1.0 },
+        .positions = { { 0.97000436, -0.24308753 }, { -0.97000436, 0.24308753 }, { 0.0, 0.0 } },
+        .velocities = { { 0.46620369, 0.43236573 }, { 0.46620369, 0.43236573 }, { -0.93240737, -0.86473146 } },
+        .delta_time = 1e-3f,
+        .steps = 6326,
+        .tolerance = 1e-3,
+    },
+    {
+        // Burrau's problem, only up to t = 1 since the close encounters after it amplify any rounding difference
+        .name = "pythagorean",
+        .body_count = 3,
+        .masses = { 3.0, 4.0, 5.0 },
+        .positions = { { 1.0, 3.0 }, { -2.0, -1.0 }, { 1.0, -1.0 } },
+        .velocities = { { 0.0, 0.0 }, { 0.0, 0.0 }, { 0.0, 0.0 } },
+        .delta_time = 1e-4f,
+        .steps = 10000,
+        .tolerance = 1e-3,
+    },
+};
+
+static const char *ACCURACY_INTEGRATOR_NAMES[] = { "euler", "verlet", "runge_kutta" };
+
+// largest allowed distance from the exact orbit per integrator, semi-implicit Euler is only first order and ends up
+// around 1.3e-3 off in the Kepler scene, the others around 5e-5 where the softening starts to show
+static const f64 ACCURACY_ORBIT_TOLERANCE[] = { 5e-3, 1e-3, 1e-3 };
+
+static AccuracyVec2 accuracy_add(const AccuracyVec2 a, const AccuracyVec2 b) { return (AccuracyVec2) { a.x + b.x, a.y + b.y }; }
+static AccuracyVec2 accuracy_scale(const AccuracyVec2 a, const f64 s) { return (AccuracyVec2) { a.x * s, a.y * s }; }
+
+// gravity.lib.glsl in double precision
+static AccuracyVec2 accuracy_acceleration(const AccuracyScene *scene, const AccuracyVec2 *r, const u32 self, const AccuracyVec2 r_self) {
+    const f64 ee = ACCURACY_SOFTENING;
+    AccuracyVec2 a = { 0.0, 0.0 };
+    for (u32 i = 0; i < scene->body_count; i++) {
+        if (i == self) continue;
+        const AccuracyVec2 R = { r[i].x - r_self.x, r[i].y - r_self.y };
+        const f64 length = SDL_sqrt(R.x * R.x + R.y * R.y);
+        const f64 R2 = R.x * R.x + R.y * R.y + ee * ee;
+        a = accuracy_add(a, accuracy_scale(R, ACCURACY_GRAVITY * scene->masses[i] / R2 / length));
+    }
+
+    return a;
+}
+
+// the textbook methods in double precision, every stage moves all bodies before the next one evaluates forces,
+// the same way integrators.lib.glsl dispatches them
+static void accuracy_accelerations(const AccuracyScene *scene, const AccuracyVec2 *r, AccuracyVec2 *a) {
+    for (u32 i = 0; i < scene->body_count; i++) a[i] = accuracy_acceleration(scene, r, i, r[i]);
+}
+
+static void accuracy_step(const AccuracyScene *scene, const u32 integrator, AccuracyVec2 *r, AccuracyVec2 *v) {
+    const f64 dt = scene->delta_time;
+    const u32 n = scene->body_count;
+    AccuracyVec2 a[ACCURACY_MAX_BODIES];
+    accuracy_accelerations(scene, r, a);
+    if (integrator == INTEGRATOR_EULER) {
+        for (u32 i = 0; i < n; i++) {
+            v[i] = accuracy_add(v[i], accuracy_scale(a[i], dt));
+            r[i] = accuracy_add(r[i], accuracy_scale(v[i], dt));
+        }
+    } else if (integrator == INTEGRATOR_VERLET) {
+        AccuracyVec2 a_next[ACCURACY_MAX_BODIES];
+        for (u32 i = 0; i < n; i++) r[i] = accuracy_add(r[i], accuracy_add(accuracy_scale(v[i], dt), accuracy_scale(a[i], dt * dt / 2)));
+        accuracy_accelerations(scene, r, a_next);
+        for (u32 i = 0; i < n; i++) v[i] = accuracy_add(v[i], accuracy_scale(accuracy_add(a[i], a_next[i]), dt / 2));
+    } else {
+        // k_r of a stage is the velocity it was evaluated at, k_v the acceleration
+        const f64 weights[] = { 1.0, 2.0, 2.0, 1.0 };
+        const f64 offsets[] = { dt / 2, dt / 2, dt, 0.0 };
+        AccuracyVec2 r_stage[ACCURACY_MAX_BODIES], v_stage[ACCURACY_MAX_BODIES];
+        AccuracyVec2 sum_r[ACCURACY_MAX_BODIES], sum_v[ACCURACY_MAX_BODIES];
+        SDL_memcpy(r_stage, r, n * sizeof(AccuracyVec2));
+        SDL_memcpy(v_stage, v, n * sizeof(AccuracyVec2));
+        SDL_memset(sum_r, 0, sizeof(sum_r));
+        SDL_memset(sum_v, 0, sizeof(sum_v));
+        for (u32 k = 0; k < 4; k++) {
+            if (k) accuracy_accelerations(scene, r_stage, a);
+            for (u32 i = 0; i < n; i++) {
+                const AccuracyVec2 k_r = v_stage[i], k_v = a[i];
+                sum_r[i] = accuracy_add(sum_r[i], accuracy_scale(k_r, weights[k]));
+                sum_v[i] = accuracy_add(sum_v[i], accuracy_scale(k_v, weights[k]));
+                r_stage[i] = accuracy_add(r[i], accuracy_scale(k_r, offsets[k]));
+                v_stage[i] = accuracy_add(v[i], accuracy_scale(k_v, offsets[k]));
+            }
+        }
+
+        for (u32 i = 0; i < n; i++) {
+            r[i] = accuracy_add(r[i], accuracy_scale(sum_r[i], dt / 6));
+            v[i] = accuracy_add(v[i], accuracy_scale(sum_v[i], dt / 6));
+        }
+    }
+}
+
+// exact positions of a two-body scene at time t, the relative orbit is an ellipse solved through Kepler's equation
+// and the centre of mass drifts uniformly. ignores the softening, which is far below the tolerances at these distances
+static void accuracy_kepler(const AccuracyScene *scene, const f64 t, AccuracyVec2 *r) {
+    const f64 m1 = scene->masses[0], m2 = scene->masses[1], M = m1 + m2;
+    const f64 mu = ACCURACY_GRAVITY * M;
+    const AccuracyVec2 r0 = accuracy_add(scene->positions[1], accuracy_scale(scene->positions[0], -1.0));
+    const AccuracyVec2 v0 = accuracy_add(scene->velocities[1], accuracy_scale(scene->velocities[0], -1.0));
+    const f64 distance = SDL_sqrt(r0.x * r0.x + r0.y * r0.y);
+    const f64 speed2 = v0.x * v0.x + v0.y * v0.y;
+    const f64 radial = r0.x * v0.x + r0.y * v0.y;
+    const f64 h = r0.x * v0.y - r0.y * v0.x;
+
+    // eccentricity vector towards the periapsis, q a quarter turn after it in the direction of motion
+    const AccuracyVec2 e_vec = accuracy_scale(accuracy_add(accuracy_scale(r0, speed2 - mu / distance), accuracy_scale(v0, -radial)), 1.0 / mu);
+    const f64 e = SDL_sqrt(e_vec.x * e_vec.x + e_vec.y * e_vec.y);
+    const f64 a = 1.0 / (2.0 / distance - speed2 / mu);
+    const AccuracyVec2 p = accuracy_scale(e_vec, 1.0 / e);
+    const AccuracyVec2 q = accuracy_scale((AccuracyVec2) { -p.y, p.x }, h < 0.0 ? -1.0 : 1.0);
+
+    const f64 E0 = SDL_atan2(radial / (e * SDL_sqrt(mu * a)), (1.0 - distance / a) / e);
+    const f64 M_t = E0 - e * SDL_sin(E0) + SDL_sqrt(mu / (a * a * a)) * t;
+    f64 E = M_t;
+    for (u32 i = 0; i < 32; i++) E -= (E - e * SDL_sin(E) - M_t) / (1.0 - e * SDL_cos(E));
+
+    const AccuracyVec2 relative = accuracy_add(accuracy_scale(p, a * (SDL_cos(E) - e)), accuracy_scale(q, a * SDL_sqrt(1.0 - e * e) * SDL_sin(E)));
+    const AccuracyVec2 centre = accuracy_add(
+        accuracy_scale(accuracy_add(accuracy_scale(scene->positions[0], m1), accuracy_scale(scene->positions[1], m2)), 1.0 / M),
+        accuracy_scale(accuracy_add(accuracy_scale(scene->velocities[0], m1), accuracy_scale(scene->velocities[1], m2)), t / M)
+    );
+
+    r[0] = accuracy_add(centre, accuracy_scale(relative, -m2 / M));
+    r[1] = accuracy_add(centre, accuracy_scale(relative, m1 / M));
+}
+
+static bool accuracy_upload(SDL_GPUDevice *gpu, Simulation *sim, const AccuracyScene *scene) {
+    BodyTable bodies;
+    if (!body_table_alloc(&bodies, scene->body_count)) return false;
+    for (u32 i = 0; i < scene->body_count; i++) {
+        bodies.positions[i] = HMM_V2((f32) scene->positions[i].x, (f32) scene->positions[i].y);
+        bodies.velocities[i] = HMM_V2((f32) scene->velocities[i].x, (f32) scene->velocities[i].y);
+        bodies.masses[i] = (f32) scene->masses[i];
+        bodies.movable[i] = 1.0f;
+        bodies.colors[i] = COLOR_DEFAULT;
+    }
+
+    SDL_GPUCommandBuffer *command_buffer = SDL_AcquireGPUCommandBuffer(gpu);
+    SDL_GPUCopyPass *copy_pass = SDL_BeginGPUCopyPass(command_buffer);
+    simulation_clear(sim);
+    simulation_add_bodies(sim, gpu, copy_pass, &bodies);
+    SDL_EndGPUCopyPass(copy_pass);
+    SDL_SubmitGPUCommandBuffer(command_buffer);
+    body_table_free(&bodies);
+    return true;
+}
+
+static void accuracy_gpu_steps(SDL_GPUDevice *gpu, Simulation *sim, const f32 delta_time, const u64 steps) {
+    for (u64 done = 0; done < steps;) {
+        const u64 batch = SDL_min(HEADLESS_BATCH_STEPS, steps - done);
+        SDL_GPUCommandBuffer *command_buffer = SDL_AcquireGPUCommandBuffer(gpu);
+        SDL_GPUComputePass *compute_pass = SDL_BeginGPUComputePass(command_buffer, NULL, 0, (SDL_GPUStorageBufferReadWriteBinding[]) {
+            { .buffer = sim->positions.buffer, .cycle = false },
+            { .buffer = sim->velocities.buffer, .cycle = false },
+            { .buffer = sim->scratch.buffer, .cycle = false },
+        }, 3);
+
+        for (u64 i = 0; i < batch; i++) simulation_update(sim, command_buffer, compute_pass, delta_time);
+        SDL_EndGPUComputePass(compute_pass);
+        SDL_SubmitGPUCommandBuffer(command_buffer);
+        done += batch;
+    }
+}
+
+// largest position error against the CPU copy over ACCURACY_SAMPLES evenly spaced readbacks, or a negative value if the
+// run couldn't start. analytic scenes also leave the largest distance from the exact orbit in `orbit_error`
+static f64 accuracy_compare(SDL_GPUDevice *gpu, Simulation *sim, const AccuracyScene *scene, const u32 integrator, f64 *orbit_error) {
+    sim->options.integrator = integrator;
+    sim->options.gravity = ACCURACY_GRAVITY;
+    sim->options.softening = ACCURACY_SOFTENING;
+    sim->options.paused = false;
+    if (!accuracy_upload(gpu, sim, scene)) return -1.0;
+
+    AccuracyVec2 r[ACCURACY_MAX_BODIES], v[ACCURACY_MAX_BODIES];
+    SDL_memcpy(r, scene->positions, sizeof(r));
+    SDL_memcpy(v, scene->velocities, sizeof(v));
+
+    f64 max_error = 0.0;
+    *orbit_error = 0.0;
+    u64 done = 0;
+    for (u32 sample = 1; sample <= ACCURACY_SAMPLES; sample++) {
+        const u64 target = scene->steps * sample / ACCURACY_SAMPLES;
+        accuracy_gpu_steps(gpu, sim, scene->delta_time, target - done);
+        for (; done < target; done++) accuracy_step(scene, integrator, r, v);
+
+        HMM_Vec2 positions[ACCURACY_MAX_BODIES];
+        ReadFromGPUBufferNow(gpu, &(ReadGPUBufferBinding) {
+            .buffer = sim->positions.buffer,
+            .destination = (u8 *) positions,
+            .size = scene->body_count * (u32) sizeof(HMM_Vec2),
+        }, 1);
+
+        for (u32 i = 0; i < scene->body_count; i++) {
+            const f64 dx = (f64) positions[i].X - r[i].x, dy = (f64) positions[i].Y - r[i].y;
+            const f64 error = SDL_sqrt(dx * dx + dy * dy);
+            if (error != error) return error; // NaN fails every tolerance
+            max_error = SDL_max(max_error, error);
+        }
+
+        if (!scene->analytic) continue;
+        AccuracyVec2 exact[ACCURACY_MAX_BODIES];
+        accuracy_kepler(scene, (f64) done * scene->delta_time, exact);
+        for (u32 i = 0; i < scene->body_count; i++) {
+            const f64 dx = (f64) positions[i].X - exact[i].x, dy = (f64) positions[i].Y - exact[i].y;
+            const f64 error = SDL_sqrt(dx * dx + dy * dy);
+            *orbit_error = error == error ? SDL_max(*orbit_error, error) : error;
+        }
+    }
+
+    return max_error;
+}
+
+bool accuracy_run(SDL_GPUDevice *gpu, Simulation *sim) {
+    bool passed = true;
+    SDL_Log("%-14s %-12s %12s %12s\n", "scene", "integrator", "max error", "tolerance");
+    for (u32 s = 0; s < SDL_arraysize(ACCURACY_SCENES); s++) {
+        const AccuracyScene *scene = &ACCURACY_SCENES[s];
+        for (u32 integrator = 0; integrator < SDL_arraysize(ACCURACY_INTEGRATOR_NAMES); integrator++) {
+            f64 orbit_error;
+            const f64 error = accuracy_compare(gpu, sim, scene, integrator, &orbit_error);
+            const bool ok = error >= 0.0 && error <= scene->tolerance;
+            SDL_Log("%-14s %-12s %12.3e %12.3e %s\n", scene->name, ACCURACY_INTEGRATOR_NAMES[integrator], error, scene->tolerance, ok ? "ok" : "FAILED");
+            passed = passed && ok;
+            if (!scene->analytic || error < 0.0) continue;
+
+            char name[32];
+            SDL_snprintf(name, sizeof(name), "%s_orbit", scene->name);
+            const f64 tolerance = ACCURACY_ORBIT_TOLERANCE[integrator];
+            const bool orbit_ok = orbit_error <= tolerance;
+            SDL_Log("%-14s %-12s %12.3e %12.3e %s\n", name, ACCURACY_INTEGRATOR_NAMES[integrator], orbit_error, tolerance, orbit_ok ? "ok" : "FAILED");
+            passed = passed && orbit_ok;
+        }
+    }
+
+    return passed;
+}
@@ -0,0 +1,76 @@
+#include "appearance.h"
+#include "constants.h"
+
+SDL_AppResult appearance_init(Appearance *appearance, SDL_GPUDevice *gpu) {
+    *appearance = (Appearance) {
+        .options = {
+            .clear_color = CLEAR_COLOR_DEFAULT,
+            .movable_outline = MOVABLE_OUTLINE_DEFAULT,
+            .static_outline = STATIC_OUTLINE_DEFAULT,
+            .trail_brightness = TRAIL_FADE_DEFAULT,
+            .trail_tolerance = TRAIL_TOLERANCE_DEFAULT,
+            .splat_radius = SPLAT_RADIUS_DEFAULT,
+            .splat_exposure = SPLAT_EXPOSURE_DEFAULT,
+            .field = false,
+            .field_spacing = FIELD_GRID_DEFAULT,
+            .field_opacity = FIELD_OPACITY_DEFAULT,
+            .field_arrow_opacity = FIELD_ARROW_OPACITY_DEFAULT
+        },
+        .colors = CreateGPUArray(gpu, sizeof(u32), SDL_GPU_BUFFERUSAGE_GRAPHICS_STORAGE_READ | SDL_GPU_BUFFERUSAGE_COMPUTE_STORAGE_READ),
+    };
+
+    if (!appearance->colors.buffer) panic("Failed to create color storage buffer!");
+    return SDL_APP_CONTINUE;
+}
+
+// the layout unpackUnorm4x8 expects, red in the low byte
+u32 appearance_pack_color(const SDL_FColor color) {
+    const f32 channels[] = { color.r, color.g, color.b, color.a };
+    u32 packed = 0;
+    for (u32 i = 0; i < 4; i++) packed |= (u32) (SDL_clamp(channels[i], 0.0f, 1.0f) * 255.0f + 0.5f) << (8 * i);
+    return packed;
+}
+
+u32 appearance_add_body(Appearance *appearance, SDL_GPUDevice *gpu, SDL_GPUCopyPass *copy_pass, const SDL_FColor color) {
+    const u32 packed = appearance_pack_color(color);
+    AppendGPUArrays(gpu, copy_pass, &(AppendGPUArrayBinding) {
+        .array = &appearance->colors,
+        .source = (const u8 *) &packed,
+        .size = sizeof(u32)
+    }, 1);
+
+    appearance->revision++;
+    return appearance->body_count++;
+}
+
+u32 appearance_add_bodies(Appearance *appearance, SDL_GPUDevice *gpu, SDL_GPUCopyPass *copy_pass, const SDL_FColor *colors, const u32 count) {
+    if (count == 0) return appearance->body_count;
+    u32 *packed = SDL_malloc(sizeof(u32) * count);
+    if (!packed) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "SDL_malloc() in appearance_add_bodies(): Out of memory for %u colors.\n", count);
+        return appearance->body_count;
+    }
+
+    for (u32 i = 0; i < count; i++) packed[i] = appearance_pack_color(colors[i]);
+    AppendGPUArrays(gpu, copy_pass, &(AppendGPUArrayBinding) {
+        .array = &appearance->colors,
+        .source = (const u8 *) packed,
+        .size = count * (u32) sizeof(u32)
+    }, 1);
+
+    SDL_free(packed);
+    const u32 first = appearance->body_count;
+    appearance->body_count += count;
+    appearance->revision++;
+    return first;
+}
+
+void appearance_clear(Appearance *appearance) {
+    appearance->colors.used = 0;
+    appearance->body_count = 0;
+    appearance->revision++;
+}
+
+void appearance_free(const Appearance *appearance, SDL_GPUDevice *gpu) {
+    SDL_ReleaseGPUBuffer(gpu, appearance->colors.buffer);
+}
@@ -0,0 +1,232 @@
+#include "constants.h"
+#include "simulation.h"
+#include "diagnostics.h"
+#include "generators.h"
+#include "bodies.h"
+#include "accuracy.h"
+
+#include "SDL3/SDL_init.h"
+#include "SDL3/SDL_iostream.h"
+#include "SDL3/SDL_gpu.h"
+#include "SDL3/SDL_timer.h"
+#include "sdl_utils.h"
+#include "types.h"
+
+// sweeps body counts over every backend and integrator, and writes one JSON record per run so results can be diffed across commits.
+// run it from the build directory, the shaders are loaded from ./shaders like the main executable does
+#define BENCH_OUTPUT_DEFAULT "bench.json"
+#define BENCH_MAX_BODIES_DEFAULT 100000
+#define BENCH_INTERACTIONS 20000000000.0 // per run, the step count is derived from it
+#define BENCH_MIN_STEPS 4
+#define BENCH_MAX_STEPS 2000
+#define BENCH_WARMUP_STEPS 2
+#define BENCH_SEED 1
+
+static const u32 BENCH_SIZES[] = { 10, 100, 1000, 10000, 100000 };
+static const char *BENCH_INTEGRATOR_NAMES[] = { "euler", "verlet", "runge_kutta" };
+static const u32 BENCH_EVALUATIONS[] = { 1, 2, 4 }; // force evaluations per step
+
+typedef struct {
+    const char *backend;
+    u32 integrator;
+    u32 body_count;
+    u64 steps;
+    f64 seconds;
+    f64 interactions_per_second;
+    f64 ns_per_body_step;
+    f64 energy_error;
+} BenchResult;
+
+typedef struct {
+    SDL_GPUDevice *gpu;
+    Simulation sim;
+    Diagnostics diag;
+    const char *output;
+    u32 max_bodies;
+    f32 delta_time;
+    bool accuracy;
+} Bench;
+
+static bool bench_arguments(Bench *bench, const int argc, char **argv) {
+    for (i32 i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        const char *value = i + 1 < argc ? argv[i + 1] : NULL;
+
+        if (SDL_strcmp(arg, "--output") == 0 && value) {
+            bench->output = value;
+            i++;
+        } else if (SDL_strcmp(arg, "--max-bodies") == 0 && value) {
+            bench->max_bodies = (u32) SDL_strtoul(value, NULL, 10);
+            i++;
+        } else if (SDL_strcmp(arg, "--accuracy") == 0) {
+            bench->accuracy = true;
+        } else if (SDL_strcmp(arg, "--dt") == 0 && value) {
+            bench->delta_time = (f32) SDL_atof(value);
+            i++;
+        } else {
+            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION,
+                "bench_arguments() in main(): Unknown argument %s.\n"
+                "usage: nbody_bench [--output <file.json>] [--max-bodies <n>] [--dt <seconds>] | --accuracy\n", arg);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static bool bench_scene(Bench *bench, const u32 body_count) {
+    BodyTable bodies;
+    const GeneratorOptions options = {
+        .type = GENERATOR_PLUMMER,
+        .count = body_count,
+        .seed = BENCH_SEED,
+        .mass = GENERATOR_MASS_DEFAULT,
+        .radius = GENERATOR_RADIUS_DEFAULT,
+    };
+
+    if (!generate_bodies(&options, &bench->sim.options, &bodies)) return false;
+    SDL_GPUCommandBuffer *command_buffer = SDL_AcquireGPUCommandBuffer(bench->gpu);
+    SDL_GPUCopyPass *copy_pass = SDL_BeginGPUCopyPass(command_buffer);
+    simulation_clear(&bench->sim);
+    simulation_add_bodies(&bench->sim, bench->gpu, copy_pass, &bodies);
+    SDL_EndGPUCopyPass(copy_pass);
+    SDL_SubmitGPUCommandBuffer(command_buffer);
+    body_table_free(&bodies);
+    bench->sim.step = 0;
+    return true;
+}
+
+// records `steps` integration steps per command buffer and waits for all of them
+static void bench_steps(Bench *bench, const u64 steps) {
+    for (u64 done = 0; done < steps;) {
+        const u64 batch = SDL_min(HEADLESS_BATCH_STEPS, steps - done);
+        SDL_GPUCommandBuffer *command_buffer = SDL_AcquireGPUCommandBuffer(bench->gpu);
+        SDL_GPUComputePass *compute_pass = SDL_BeginGPUComputePass(command_buffer, NULL, 0, (SDL_GPUStorageBufferReadWriteBinding[]) {
+            { .buffer = bench->sim.positions.buffer, .cycle = false },
+            { .buffer = bench->sim.velocities.buffer, .cycle = false },
+            { .buffer = bench->sim.scratch.buffer, .cycle = false },
+        }, 3);
+
+        for (u64 i = 0; i < batch; i++) simulation_update(&bench->sim, command_buffer, compute_pass, bench->delta_time);
+        SDL_EndGPUComputePass(compute_pass);
+        SDL_SubmitGPUCommandBuffer(command_buffer);
+        done += batch;
+    }
+
+    SDL_WaitForGPUIdle(bench->gpu);
+}
+
+// a blocking diagnostics sample, fine here since nothing else is in flight
+static DiagnosticsSample bench_sample(Bench *bench) {
+    bench->diag.enabled = true;
+    bench->diag.next_step = 0;
+    SDL_GPUCommandBuffer *command_buffer = SDL_AcquireGPUCommandBuffer(bench->gpu);
+    diagnostics_capture(&bench->diag, bench->gpu, command_buffer, &bench->sim);
+    SDL_SubmitGPUCommandBuffer(command_buffer);
+    diagnostics_submit(&bench->diag, bench->gpu);
+    SDL_WaitForGPUIdle(bench->gpu);
+    diagnostics_poll(&bench->diag, bench->gpu);
+    return bench->diag.latest;
+}
+
+static bool bench_gpu(Bench *bench, const u32 integrator, const u32 body_count, BenchResult *result) {
+    bench->sim.options.integrator = integrator;
+    if (!bench_scene(bench, body_count)) return false;
+
+    const f64 pair_evaluations = (f64) body_count * body_count * BENCH_EVALUATIONS[integrator];
+    const u64 steps = (u64) SDL_clamp(BENCH_INTERACTIONS / pair_evaluations, BENCH_MIN_STEPS, BENCH_MAX_STEPS);
+
+    diagnostics_reset(&bench->diag);
+    const DiagnosticsSample before = bench_sample(bench);
+    bench_steps(bench, BENCH_WARMUP_STEPS);
+
+    const u64 start = SDL_GetTicksNS();
+    bench_steps(bench, steps);
+    const f64 seconds = (f64) (SDL_GetTicksNS() - start) / (f64) SDL_NS_PER_SECOND;
+    const DiagnosticsSample after = bench_sample(bench);
+
+    *result = (BenchResult) {
+        .backend = "gpu",
+        .integrator = integrator,
+        .body_count = body_count,
+        .steps = steps,
+        .seconds = seconds,
+        .interactions_per_second = pair_evaluations * (f64) steps / seconds,
+        .ns_per_body_step = seconds * 1e9 / ((f64) steps * body_count),
+        .energy_error = SDL_fabs(((f64) after.energy - before.energy) / SDL_max(SDL_fabs(before.energy), EPSILON)),
+    };
+
+    return true;
+}
+
+static bool bench_write(const Bench *bench, const BenchResult *results, const u32 count) {
+    SDL_IOStream *io = SDL_IOFromFile(bench->output, "w");
+    if (!io) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "SDL_IOFromFile() in bench_write(): Couldn't open %s.\n", bench->output);
+        return false;
+    }
+
+    SDL_IOprintf(io, "{\n  \"driver\": \"%s\",\n  \"delta_time\": %g,\n  \"seed\": %d,\n  \"results\": [\n",
+        SDL_GetGPUDeviceDriver(bench->gpu), bench->delta_time, BENCH_SEED);
+    for (u32 i = 0; i < count; i++) {
+        const BenchResult *r = &results[i];
+        SDL_IOprintf(io,
+            "    { \"backend\": \"%s\", \"integrator\": \"%s\", \"bodies\": %u, \"steps\": %" SDL_PRIu64 ", \"seconds\": %.6f, "
+            "\"interactions_per_second\": %.6e, \"ns_per_body_step\": %.4f, \"energy_error\": %.6e }%s\n",
+            r->backend, BENCH_INTEGRATOR_NAMES[r->integrator], r->body_count, r->steps, r->seconds,
+            r->interactions_per_second, r->ns_per_body_step, r->energy_error, i + 1 < count ? "," : "");
+    }
+
+    SDL_IOprintf(io, "  ]\n}\n");
+    return SDL_CloseIO(io);
+}
+
+static SDL_AppResult bench_init(Bench *bench) {
+    if (!SDL_Init(0)) panic("Failed to initialize SDL3!");
+    bench->gpu = SDL_CreateGPUDevice(SDL_GPU_SHADERFORMAT_SPIRV | SDL_GPU_SHADERFORMAT_MSL, false, NULL);
+    if (!bench->gpu) panic("Failed to create GPU device!");
+    if (simulation_init(&bench->sim, bench->gpu) != 0) panic("Failed to initialize simulation!");
+    if (diagnostics_init(&bench->diag, bench->gpu) != 0) panic("Failed to initialize diagnostics!");
+    return SDL_APP_CONTINUE;
+}
+
+int main(const int argc, char **argv) {
+    Bench bench = {
+        .output = BENCH_OUTPUT_DEFAULT,
+        .max_bodies = BENCH_MAX_BODIES_DEFAULT,
+        .delta_time = FIXED_DELTA_TIME_DEFAULT,
+    };
+
+    if (!bench_arguments(&bench, argc, argv) || bench_init(&bench) != SDL_APP_CONTINUE) return 1;
+
+    // the accuracy check replaces the sweep and its exit code is the verdict, so scripts can gate on it
+    if (bench.accuracy) {
+        const bool passed = accuracy_run(bench.gpu, &bench.sim);
+        diagnostics_free(&bench.diag, bench.gpu);
+        simulation_free(&bench.sim, bench.gpu);
+        SDL_DestroyGPUDevice(bench.gpu);
+        SDL_Quit();
+        return passed ? 0 : 1;
+    }
+
+    // the simulation only has GPU kernels, other backends slot in as more `backend` values
+    BenchResult results[SDL_arraysize(BENCH_SIZES) * SDL_arraysize(BENCH_INTEGRATOR_NAMES)];
+    u32 count = 0;
+    SDL_Log("%-6s %-12s %8s %8s %14s %12s %12s\n", "backend", "integrator", "bodies", "steps", "interactions/s", "ns/body-step", "energy error");
+    for (u32 integrator = 0; integrator < SDL_arraysize(BENCH_INTEGRATOR_NAMES); integrator++) {
+        for (u32 i = 0; i < SDL_arraysize(BENCH_SIZES) && BENCH_SIZES[i] <= bench.max_bodies; i++) {
+            BenchResult *r = &results[count];
+            if (!bench_gpu(&bench, integrator, BENCH_SIZES[i], r)) continue;
+            SDL_Log("%-6s %-12s %8u %8" SDL_PRIu64 " %14.4e %12.3f %12.3e\n", r->backend, BENCH_INTEGRATOR_NAMES[integrator],
+                r->body_count, r->steps, r->interactions_per_second, r->ns_per_body_step, r->energy_error);
+            count++;
+        }
+    }
+
+    const bool written = bench_write(&bench, results, count);
+    diagnostics_free(&bench.diag, bench.gpu);
+    simulation_free(&bench.sim, bench.gpu);
+    SDL_DestroyGPUDevice(bench.gpu);
+    SDL_Quit();
+    return written ? 0 : 1;
+}
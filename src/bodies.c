@@ -0,0 +1,29 @@
+#include "bodies.h"
+
+#include "SDL3/SDL_stdinc.h"
+
+// one allocation, the colors go first to keep every array 16 byte aligned
+bool body_table_alloc(BodyTable *bodies, const u32 count) {
+    const usize n = count;
+    u8 *data = SDL_malloc(n * (sizeof(SDL_FColor) + 2 * sizeof(HMM_Vec2) + 2 * sizeof(f32)) + 1);
+    if (!data) {
+        *bodies = (BodyTable) { 0 };
+        return false;
+    }
+
+    *bodies = (BodyTable) {
+        .colors = (SDL_FColor *) data,
+        .positions = (HMM_Vec2 *) (data + n * sizeof(SDL_FColor)),
+        .velocities = (HMM_Vec2 *) (data + n * (sizeof(SDL_FColor) + sizeof(HMM_Vec2))),
+        .masses = (f32 *) (data + n * (sizeof(SDL_FColor) + 2 * sizeof(HMM_Vec2))),
+        .movable = (f32 *) (data + n * (sizeof(SDL_FColor) + 2 * sizeof(HMM_Vec2) + sizeof(f32))),
+        .count = count,
+    };
+
+    return true;
+}
+
+void body_table_free(BodyTable *bodies) {
+    SDL_free(bodies->colors);
+    *bodies = (BodyTable) { 0 };
+}
@@ -3,24 +3,24 @@
 #include "ghost.h"
 
 #include "sdl_utils.h"
+#include "tracer.h"
 
 void camera_init(Camera *cam) {
     cam->zoom = 1.0f;
     cam->target = (u32) -1;
 }
 
-void camera_update(Camera *cam, SDL_Window *window, SDL_GPUDevice *gpu, const Simulation *sim) {
-    if (cam->target != (u32) -1) ReadFromGPUBufferNow(gpu, &(ReadGPUBufferBinding) {
+void camera_follow(Camera *cam, SDL_GPUDevice *gpu, const Simulation *sim) {
+    if (cam->target != (u32) -1) TRACE_SCOPE("ReadFromGPUBufferNow") ReadFromGPUBufferNow(gpu, &(ReadGPUBufferBinding) {
         .buffer = sim->positions.buffer,
         .buffer_offset = cam->target * sizeof(HMM_Vec2),
         .destination = (u8*) &cam->position,
         .size = sizeof(HMM_Vec2)
     }, 1);
+}
 
-    i32 width, height;
-    SDL_GetWindowSize(window, &width, &height);
-    cam->window_size = HMM_V2((f32) width, (f32) height);
-
+void camera_project(Camera *cam, const f32 width, const f32 height) {
+    cam->window_size = HMM_V2(width, height);
     cam->orthographic = HMM_Orthographic_LH_ZO(
         cam->zoom * (-cam->window_size.Width / 2.0f),
         cam->zoom * ( cam->window_size.Width / 2.0f),
@@ -36,6 +36,13 @@ void camera_update(Camera *cam, SDL_Window *window, SDL_GPUDevice *gpu, const Si
     );
 }
 
+void camera_update(Camera *cam, SDL_Window *window, SDL_GPUDevice *gpu, const Simulation *sim) {
+    camera_follow(cam, gpu, sim);
+    i32 width, height;
+    SDL_GetWindowSize(window, &width, &height);
+    camera_project(cam, (f32) width, (f32) height);
+}
+
 HMM_Vec2 mouse_world_position(const Camera *cam);
 void camera_mouse(Camera *cam, const SDL_Event *event, const Ghost *ghost) {
     HMM_Vec2 mouse_delta = { 0 };
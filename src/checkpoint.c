@@ -0,0 +1,107 @@
+// fileno() and fsync() for the checkpoint sync, outside of the GNU dialect too
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include "checkpoint.h"
+#include "tracer.h"
+
+#include "SDL3/SDL_filesystem.h"
+#include "SDL3/SDL_iostream.h"
+
+#ifdef SDL_PLATFORM_WINDOWS
+#include <windows.h>
+#else
+#include <stdio.h>
+#include <unistd.h>
+#endif
+
+typedef struct {
+    char path[FILE_PATH_LENGTH];
+    SDL_IOStream *memory; // the serialized snapshot, owned by the writer
+} CheckpointJob;
+
+void checkpoint_init(Checkpoint *checkpoint, const char *path, const u64 interval, const u64 step) {
+    *checkpoint = (Checkpoint) {
+        .interval = SDL_max(interval, 1),
+        .next_step = step + SDL_max(interval, 1),
+    };
+
+    SDL_strlcpy(checkpoint->path, path, sizeof(checkpoint->path));
+}
+
+bool checkpoint_due(const Checkpoint *checkpoint, const Simulation *sim) {
+    return checkpoint->path[0] && sim->step >= checkpoint->next_step;
+}
+
+// SDL_FlushIO only hands the bytes to the OS, they have to be on the disk before the rename replaces the old checkpoint
+static bool checkpoint_sync(SDL_IOStream *io) {
+    const SDL_PropertiesID properties = SDL_GetIOProperties(io);
+#ifdef SDL_PLATFORM_WINDOWS
+    HANDLE handle = SDL_GetPointerProperty(properties, SDL_PROP_IOSTREAM_WINDOWS_HANDLE_POINTER, NULL);
+    return handle && FlushFileBuffers(handle);
+#else
+    FILE *file = SDL_GetPointerProperty(properties, SDL_PROP_IOSTREAM_STDIO_FILE_POINTER, NULL);
+    const i64 descriptor = file ? fileno(file) : SDL_GetNumberProperty(properties, SDL_PROP_IOSTREAM_FILE_DESCRIPTOR_NUMBER, -1);
+    if (descriptor < 0) return SDL_SetError("No file descriptor to sync");
+    return fsync((int) descriptor) == 0 || SDL_SetError("fsync() failed");
+#endif
+}
+
+static i32 checkpoint_writer(void *data) {
+    CheckpointJob *job = data;
+    char temp_path[FILE_PATH_LENGTH + 4];
+    SDL_snprintf(temp_path, sizeof(temp_path), "%s.tmp", job->path);
+
+    const void *bytes = SDL_GetPointerProperty(SDL_GetIOProperties(job->memory), SDL_PROP_IOSTREAM_DYNAMIC_MEMORY_POINTER, NULL);
+    const usize size = (usize) SDL_GetIOSize(job->memory);
+
+    bool written = false;
+    TRACE_SCOPE("checkpoint_writer") {
+        SDL_IOStream *io = SDL_IOFromFile(temp_path, "wb");
+        if (io) {
+            written = SDL_WriteIO(io, bytes, size) == size && SDL_FlushIO(io) && checkpoint_sync(io);
+            written = SDL_CloseIO(io) && written;
+        }
+
+        // the rename only happens once the new checkpoint is complete on disk
+        if (written) written = SDL_RenamePath(temp_path, job->path);
+    }
+
+    if (!written) SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "checkpoint_writer(): Couldn't write %s: %s\n", job->path, SDL_GetError());
+    SDL_CloseIO(job->memory);
+    SDL_free(job);
+    return written ? 0 : -1;
+}
+
+bool checkpoint_wait(Checkpoint *checkpoint) {
+    if (!checkpoint->writer) return true;
+    i32 status = 0;
+    SDL_WaitThread(checkpoint->writer, &status);
+    checkpoint->writer = NULL;
+    return status == 0;
+}
+
+// blocks on the gpu download and serialization, the disk write happens in the background.
+// false if this checkpoint couldn't be started or the previous one wasn't written
+bool checkpoint_save(Checkpoint *checkpoint, const SnapshotInfo *info) {
+    checkpoint->next_step = info->sim->step + checkpoint->interval;
+    const bool previous = checkpoint_wait(checkpoint);
+    if (!previous) SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "checkpoint_save(): The previous checkpoint wasn't written, %s is older than it.\n", checkpoint->path);
+
+    CheckpointJob *job = SDL_malloc(sizeof(*job));
+    if (!job) return false;
+    SDL_strlcpy(job->path, checkpoint->path, sizeof(job->path));
+
+    job->memory = SDL_IOFromDynamicMem();
+    if (!job->memory || !snapshot_write(job->memory, info)) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "snapshot_write() in checkpoint_save(): %s\n", SDL_GetError());
+        if (job->memory) SDL_CloseIO(job->memory);
+        SDL_free(job);
+        return false;
+    }
+
+    checkpoint->writer = SDL_CreateThread(checkpoint_writer, "checkpoint", job);
+    const bool started = checkpoint->writer || checkpoint_writer(job) == 0;
+    return previous && started;
+}
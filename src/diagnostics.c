@@ -0,0 +1,154 @@
+#include "diagnostics.h"
+#include "constants.h"
+#include "simulation.h"
+
+#include "sdl_utils.h"
+
+#define DIAGNOSTICS_RESULT_SIZE (2 * sizeof(HMM_Vec4))
+
+static void diagnostics_read(void *data, u32 index, const u8 *result_data);
+SDL_AppResult diagnostics_init(Diagnostics *diag, SDL_GPUDevice *gpu) {
+    *diag = (Diagnostics) { .interval = DIAGNOSTICS_INTERVAL_DEFAULT };
+    readback_init(&diag->readback, DIAGNOSTICS_SLOTS, diagnostics_read, diag);
+    diag->pipeline = CreateGPUComputePipeline(gpu, "shaders/simulation/diagnostics.comp.spv");
+    diag->reduce_pipeline = CreateGPUComputePipeline(gpu, "shaders/simulation/diagnostics_reduce.comp.spv");
+    if (!diag->pipeline) panic("Failed to create diagnostics compute pipeline!");
+    if (!diag->reduce_pipeline) panic("Failed to create diagnostics reduce compute pipeline!");
+
+    diag->result = SDL_CreateGPUBuffer(gpu, &(SDL_GPUBufferCreateInfo) {
+        .size = DIAGNOSTICS_RESULT_SIZE,
+        .usage = SDL_GPU_BUFFERUSAGE_COMPUTE_STORAGE_WRITE
+    });
+    if (!diag->result) panic("Failed to create diagnostics result buffer!");
+
+    for (u32 i = 0; i < DIAGNOSTICS_SLOTS; i++) {
+        if (!readback_reserve(&diag->readback.slots[i], gpu, DIAGNOSTICS_RESULT_SIZE)) panic("Failed to create diagnostics transfer buffer!");
+    }
+
+    return SDL_APP_CONTINUE;
+}
+
+void diagnostics_reset(Diagnostics *diag) {
+    diag->has_baseline = false;
+    diag->head = 0;
+    diag->count = 0;
+    diag->next_step = 0;
+}
+
+bool diagnostics_due(const Diagnostics *diag, const Simulation *sim) {
+    return diag->enabled && sim->body_count && sim->step >= diag->next_step;
+}
+
+// records the reduction and its download into `command_buffer`, which must not have a pass open
+void diagnostics_capture(Diagnostics *diag, SDL_GPUDevice *gpu, SDL_GPUCommandBuffer *command_buffer, const Simulation *sim) {
+    if (!diagnostics_due(diag, sim)) return;
+    diag->next_step = sim->step + diag->interval;
+    if (!readback_available(&diag->readback)) return; // readbacks are behind, skip this sample
+
+    const u32 groups = WORKGROUP_COUNT(sim->body_count);
+    if (diag->partials_capacity < groups) {
+        if (diag->partials) SDL_ReleaseGPUBuffer(gpu, diag->partials);
+        diag->partials_capacity = groups + groups / 2;
+        diag->partials = SDL_CreateGPUBuffer(gpu, &(SDL_GPUBufferCreateInfo) {
+            .size = diag->partials_capacity * (u32) DIAGNOSTICS_RESULT_SIZE,
+            .usage = SDL_GPU_BUFFERUSAGE_COMPUTE_STORAGE_READ | SDL_GPU_BUFFERUSAGE_COMPUTE_STORAGE_WRITE
+        });
+
+        if (!diag->partials) {
+            SDL_LogError(SDL_LOG_CATEGORY_GPU, "SDL_CreateGPUBuffer() in diagnostics_capture(): %s\n", SDL_GetError());
+            diag->partials_capacity = 0;
+            diag->enabled = false;
+            return;
+        }
+    }
+
+    const struct {
+        u32 body_count;
+        f32 gravity;
+        f32 softening;
+        u32 _padding;
+    } constants = { sim->body_count, sim->options.gravity, sim->options.softening, 0 };
+
+    const struct {
+        u32 partial_count;
+        u32 _padding[3];
+    } reduce_constants = { groups, { 0 } };
+
+    // the stages are separate passes so the partial sums are visible to the second one
+    SDL_GPUComputePass *compute_pass = SDL_BeginGPUComputePass(command_buffer, NULL, 0, &(SDL_GPUStorageBufferReadWriteBinding) { .buffer = diag->partials }, 1);
+    SDL_GPUBuffer *buffers[] = { sim->positions.buffer, sim->velocities.buffer, sim->masses.buffer, sim->movable.buffer };
+    SDL_PushGPUComputeUniformData(command_buffer, 0, &constants, sizeof(constants));
+    SDL_BindGPUComputePipeline(compute_pass, diag->pipeline);
+    SDL_BindGPUComputeStorageBuffers(compute_pass, 0, buffers, sizeof(buffers) / sizeof(SDL_GPUBuffer *));
+    SDL_DispatchGPUCompute(compute_pass, groups, 1, 1);
+    SDL_EndGPUComputePass(compute_pass);
+
+    compute_pass = SDL_BeginGPUComputePass(command_buffer, NULL, 0, (SDL_GPUStorageBufferReadWriteBinding[]) {
+        { .buffer = diag->partials },
+        { .buffer = diag->result },
+    }, 2);
+    SDL_PushGPUComputeUniformData(command_buffer, 0, &reduce_constants, sizeof(reduce_constants));
+    SDL_BindGPUComputePipeline(compute_pass, diag->reduce_pipeline);
+    SDL_DispatchGPUCompute(compute_pass, 1, 1, 1);
+    SDL_EndGPUComputePass(compute_pass);
+
+    const ReadbackSlot *slot = readback_next(&diag->readback);
+    SDL_GPUCopyPass *copy_pass = SDL_BeginGPUCopyPass(command_buffer);
+    DownloadFromGPUBuffers(copy_pass, slot->transfer_buffer, &(ReadGPUBufferBinding) { .buffer = diag->result, .size = DIAGNOSTICS_RESULT_SIZE }, 1);
+    SDL_EndGPUCopyPass(copy_pass);
+
+    const u32 index = readback_capture(&diag->readback, DIAGNOSTICS_RESULT_SIZE);
+    diag->captures[index] = (DiagnosticsSample) { .step = sim->step, .body_count = sim->body_count };
+}
+
+void diagnostics_submit(Diagnostics *diag, SDL_GPUDevice *gpu) {
+    readback_submit(&diag->readback, gpu);
+}
+
+static void diagnostics_record(Diagnostics *diag, const DiagnosticsSample *sample) {
+    if (!diag->has_baseline || diag->baseline.body_count != sample->body_count) {
+        diag->baseline = *sample;
+        diag->has_baseline = true;
+        diag->head = 0;
+        diag->count = 0;
+    }
+
+    const DiagnosticsSample *baseline = &diag->baseline;
+    const f32 energy_scale = baseline->energy != 0.0f ? SDL_fabsf(baseline->energy) : 1.0f;
+    diag->energy_drift[diag->head] = (sample->energy - baseline->energy) / energy_scale;
+    diag->momentum_drift[diag->head] = HMM_LenV2(HMM_SubV2(sample->momentum, baseline->momentum));
+    diag->angular_momentum_drift[diag->head] = sample->angular_momentum - baseline->angular_momentum;
+    diag->head = (diag->head + 1) % DIAGNOSTICS_HISTORY;
+    diag->count = SDL_min(diag->count + 1, DIAGNOSTICS_HISTORY);
+    diag->latest = *sample;
+}
+
+// from diagnostics_poll, on the main thread
+static void diagnostics_read(void *data, const u32 index, const u8 *result_data) {
+    Diagnostics *diag = data;
+    if (!result_data) return;
+
+    const HMM_Vec4 *result = (const HMM_Vec4 *) result_data;
+    DiagnosticsSample sample = diag->captures[index];
+    sample.kinetic = result[0].X;
+    sample.potential = result[0].Y;
+    sample.energy = sample.kinetic + sample.potential;
+    sample.momentum = HMM_V2(result[0].Z, result[0].W);
+    sample.angular_momentum = result[1].X;
+    sample.mass = result[1].Y;
+    sample.center_of_mass = sample.mass > 0.0f ? HMM_V2(result[1].Z / sample.mass, result[1].W / sample.mass) : HMM_V2(0.0f, 0.0f);
+    diagnostics_record(diag, &sample);
+}
+
+// never blocks, samples whose readback hasn't landed yet are picked up on a later frame
+void diagnostics_poll(Diagnostics *diag, SDL_GPUDevice *gpu) {
+    readback_poll(&diag->readback, gpu, false);
+}
+
+void diagnostics_free(Diagnostics *diag, SDL_GPUDevice *gpu) {
+    readback_free(&diag->readback, gpu);
+    if (diag->partials) SDL_ReleaseGPUBuffer(gpu, diag->partials);
+    if (diag->result) SDL_ReleaseGPUBuffer(gpu, diag->result);
+    SDL_ReleaseGPUComputePipeline(gpu, diag->pipeline);
+    SDL_ReleaseGPUComputePipeline(gpu, diag->reduce_pipeline);
+}
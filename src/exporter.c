@@ -0,0 +1,205 @@
+#include "exporter.h"
+#include "simulation.h"
+#include "tracer.h"
+
+#include "sdl_utils.h"
+
+const char *EXPORT_FORMAT_NAMES[EXPORT_FORMAT_COUNT] = {
+    [EXPORT_PPM] = "PPM Sequence",
+    [EXPORT_RAW] = "Raw Video",
+};
+
+static void exporter_write_frame(void *data, u32 index, const u8 *frame_data);
+void exporter_init(Exporter *exp) {
+    *exp = (Exporter) {
+        .format = EXPORT_PPM,
+        .width = EXPORT_WIDTH_DEFAULT,
+        .height = EXPORT_HEIGHT_DEFAULT,
+        .interval = EXPORT_INTERVAL_DEFAULT,
+    };
+
+    readback_init(&exp->readback, EXPORTER_SLOTS, exporter_write_frame, exp);
+}
+
+static void exporter_release(Exporter *exp, SDL_GPUDevice *gpu) {
+    readback_free(&exp->readback, gpu);
+    if (exp->texture) SDL_ReleaseGPUTexture(gpu, exp->texture);
+    if (exp->io) SDL_CloseIO(exp->io);
+    SDL_free(exp->pixels);
+    exp->texture = NULL;
+    exp->io = NULL;
+    exp->pixels = NULL;
+}
+
+bool exporter_start(Exporter *exp, SDL_GPUDevice *gpu, const ExporterStartInfo *info) {
+    if (exp->exporting) return false;
+
+    // a frame is downloaded as RGBA8 into one transfer buffer, whose size is a u32
+    const u64 frame_size = (u64) info->width * info->height * 4;
+    if (info->width == 0 || info->height == 0 || frame_size > (u32) -1) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "exporter_start(): Invalid frame size %ux%u.\n", info->width, info->height);
+        return false;
+    }
+
+    exp->format = info->format;
+    exp->width = info->width;
+    exp->height = info->height;
+    exp->interval = SDL_max(info->interval, 1);
+    exp->texture_format = info->texture_format;
+    SDL_strlcpy(exp->path, info->path, sizeof(exp->path));
+
+    if (exp->format == EXPORT_RAW) {
+        exp->io = SDL_IOFromFile(exp->path, "wb");
+        if (!exp->io) {
+            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "SDL_IOFromFile() in exporter_start(): Couldn't open %s.\n", exp->path);
+            return false;
+        }
+    }
+
+    exp->texture = SDL_CreateGPUTexture(gpu, &(SDL_GPUTextureCreateInfo) {
+        .type = SDL_GPU_TEXTURETYPE_2D,
+        .format = exp->texture_format,
+        .usage = SDL_GPU_TEXTUREUSAGE_COLOR_TARGET,
+        .width = exp->width,
+        .height = exp->height,
+        .layer_count_or_depth = 1,
+        .num_levels = 1
+    });
+
+    if (!exp->texture) {
+        SDL_LogError(SDL_LOG_CATEGORY_GPU, "SDL_CreateGPUTexture() in exporter_start(): %s\n", SDL_GetError());
+        exporter_release(exp, gpu);
+        return false;
+    }
+
+    // every frame has the same size, so the transfer buffers are made once up front
+    for (u32 i = 0; i < EXPORTER_SLOTS; i++) {
+        if (!readback_reserve(&exp->readback.slots[i], gpu, (u32) frame_size)) {
+            exporter_release(exp, gpu);
+            return false;
+        }
+    }
+
+    exp->pixels = SDL_malloc((usize) exp->width * exp->height * 3);
+    if (!exp->pixels) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "SDL_malloc() in exporter_start(): Out of memory for a %ux%u frame.\n", exp->width, exp->height);
+        exporter_release(exp, gpu);
+        return false;
+    }
+
+    exp->next_step = info->step;
+    exp->frames = 0;
+    exp->dropped = 0;
+    SDL_SetAtomicInt(&exp->failed, 0);
+
+    if (!readback_start(&exp->readback, "exporter")) {
+        exporter_release(exp, gpu);
+        return false;
+    }
+
+    exp->exporting = true;
+    return true;
+}
+
+bool exporter_due(const Exporter *exp, const Simulation *sim) {
+    return exp->exporting && sim->step >= exp->next_step;
+}
+
+bool exporter_available(const Exporter *exp) {
+    return !exp->exporting || readback_available(&exp->readback);
+}
+
+// true if a frame should be drawn into `texture` now, followed by exporter_capture
+bool exporter_begin(Exporter *exp, const Simulation *sim) {
+    if (!exporter_due(exp, sim)) return false;
+    exp->next_step = sim->step + exp->interval;
+
+    // like the recorder, never wait on the writer here
+    if (!exporter_available(exp)) {
+        exp->dropped++;
+        return false;
+    }
+
+    return true;
+}
+
+// records the download into `command_buffer`, which must not have a pass open
+void exporter_capture(Exporter *exp, SDL_GPUCommandBuffer *command_buffer) {
+    const ReadbackSlot *slot = readback_next(&exp->readback);
+    SDL_GPUCopyPass *copy_pass = SDL_BeginGPUCopyPass(command_buffer);
+    SDL_DownloadFromGPUTexture(copy_pass, &(SDL_GPUTextureRegion) {
+        .texture = exp->texture,
+        .w = exp->width,
+        .h = exp->height,
+        .d = 1
+    }, &(SDL_GPUTextureTransferInfo) {
+        .transfer_buffer = slot->transfer_buffer
+    });
+    SDL_EndGPUCopyPass(copy_pass);
+
+    exp->captures[readback_capture(&exp->readback, slot->capacity)] = exp->frames++;
+}
+
+void exporter_submit(Exporter *exp, SDL_GPUDevice *gpu) {
+    readback_submit(&exp->readback, gpu);
+}
+
+void exporter_poll(Exporter *exp, SDL_GPUDevice *gpu, const bool wait) {
+    readback_poll(&exp->readback, gpu, wait);
+}
+
+// drops alpha and undoes the swapchain's channel order if the pipelines were built for one
+static void exporter_convert(const Exporter *exp, const u8 *source) {
+    const bool bgra = exp->texture_format == SDL_GPU_TEXTUREFORMAT_B8G8R8A8_UNORM || exp->texture_format == SDL_GPU_TEXTUREFORMAT_B8G8R8A8_UNORM_SRGB;
+    const usize pixel_count = (usize) exp->width * exp->height;
+    u8 *destination = exp->pixels;
+    for (usize i = 0; i < pixel_count; i++, source += 4, destination += 3) {
+        destination[0] = source[bgra ? 2 : 0];
+        destination[1] = source[1];
+        destination[2] = source[bgra ? 0 : 2];
+    }
+}
+
+// on the writer thread
+static void exporter_write_frame(void *data, const u32 index, const u8 *frame_data) {
+    Exporter *exp = data;
+    if (!frame_data) {
+        SDL_SetAtomicInt(&exp->failed, 1);
+        return;
+    }
+
+    TRACE_BEGIN("exporter_write_frame");
+    exporter_convert(exp, frame_data);
+    const usize size = (usize) exp->width * exp->height * 3;
+    bool written;
+    if (exp->format == EXPORT_RAW) {
+        written = SDL_WriteIO(exp->io, exp->pixels, size) == size;
+    } else {
+        char path[FILE_PATH_LENGTH + 16];
+        SDL_snprintf(path, sizeof(path), "%s%06" SDL_PRIu64 ".ppm", exp->path, exp->captures[index]);
+        SDL_IOStream *io = SDL_IOFromFile(path, "wb");
+        written = io && SDL_IOprintf(io, "P6\n%u %u\n255\n", exp->width, exp->height) > 0 && SDL_WriteIO(io, exp->pixels, size) == size;
+        if (io) written = SDL_CloseIO(io) && written;
+    }
+
+    TRACE_END();
+    if (!written) {
+        if (!SDL_GetAtomicInt(&exp->failed)) SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "SDL_WriteIO() in exporter_write_frame(): %s\n", SDL_GetError());
+        SDL_SetAtomicInt(&exp->failed, 1);
+    }
+}
+
+void exporter_stop(Exporter *exp, SDL_GPUDevice *gpu) {
+    if (!exp->exporting) return;
+
+    readback_stop(&exp->readback, gpu);
+    if (SDL_GetAtomicInt(&exp->failed)) SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "exporter_stop(): Some frames of %s couldn't be written.\n", exp->path);
+    else SDL_Log("Exported %" SDL_PRIu64 " frames of %ux%u (%" SDL_PRIu64 " dropped).\n", exp->frames, exp->width, exp->height, exp->dropped);
+
+    exporter_release(exp, gpu);
+    exp->exporting = false;
+}
+
+void exporter_free(Exporter *exp, SDL_GPUDevice *gpu) {
+    exporter_stop(exp, gpu);
+}
@@ -0,0 +1,251 @@
+#include "generators.h"
+#include "constants.h"
+
+#include "SDL3/SDL_cpuinfo.h"
+#include "SDL3/SDL_stdinc.h"
+#include "SDL3/SDL_thread.h"
+
+const char *GENERATOR_NAMES[GENERATOR_TYPE_COUNT] = {
+    [GENERATOR_PLUMMER] = "Plummer Sphere",
+    [GENERATOR_DISK] = "Exponential Disk",
+    [GENERATOR_BINARIES] = "Binaries",
+    [GENERATOR_RINGS] = "Kepler Rings",
+};
+
+// counter-based: a body's numbers depend only on (seed, body, draw), so any split across threads gives the same scene
+#define GENERATOR_DRAWS 64
+
+static u64 generator_mix(u64 x) {
+    x += 0x9E3779B97F4A7C15ull;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+    return x ^ (x >> 31);
+}
+
+// uniform in (0, 1)
+static f32 generator_uniform(const u64 seed, const u32 body, const u32 draw) {
+    const u64 bits = generator_mix(seed ^ generator_mix((u64) body * GENERATOR_DRAWS + draw));
+    return ((f32) (bits >> 40) + 0.5f) * 0x1.0p-24f;
+}
+
+static HMM_Vec2 generator_direction(const f32 u) {
+    const f32 angle = 2.0f * HMM_PI32 * u;
+    return HMM_V2(SDL_cosf(angle), SDL_sinf(angle));
+}
+
+static HMM_Vec2 generator_perpendicular(const HMM_Vec2 v) {
+    return HMM_V2(-v.Y, v.X);
+}
+
+// speed of a circular orbit at `r` around `mass`, with the same softening as gravity.lib.glsl
+static f32 generator_circular_speed(const SimulationOptions *sim, const f32 mass, const f32 r) {
+    const f32 ee = sim->softening * sim->softening;
+    return SDL_sqrtf(sim->gravity * mass * r * r / (r * r + ee) / SDL_max(r, EPSILON));
+}
+
+static SDL_FColor generator_gradient(const SDL_FColor inner, const SDL_FColor outer, f32 t) {
+    t = SDL_clamp(t, 0.0f, 1.0f);
+    return (SDL_FColor) {
+        inner.r + (outer.r - inner.r) * t,
+        inner.g + (outer.g - inner.g) * t,
+        inner.b + (outer.b - inner.b) * t,
+        1.0f
+    };
+}
+
+static bool generator_has_center(const GeneratorOptions *options) {
+    return (options->type == GENERATOR_DISK || options->type == GENERATOR_RINGS) && options->central_mass > 0.0f && options->count > 0;
+}
+
+static void generate_central_body(const GeneratorOptions *options, BodyTable *bodies) {
+    bodies->positions[0] = options->center;
+    bodies->velocities[0] = HMM_V2(0.0f, 0.0f);
+    bodies->masses[0] = options->central_mass;
+    bodies->movable[0] = 0.0f;
+    bodies->colors[0] = (SDL_FColor) { 1.0f, 0.9f, 0.6f, 1.0f };
+}
+
+// Aarseth, Henon & Wielen (1974), sampled in 3D and projected onto the plane, truncated at 10 Plummer radii
+static void generate_plummer(const GeneratorOptions *options, const SimulationOptions *sim, BodyTable *bodies, const u32 i) {
+    const u64 seed = options->seed;
+    const f32 a = options->radius;
+    const f32 body_mass = options->mass / (f32) options->count;
+
+    const f32 cutoff = 10.0f;
+    const f32 enclosed = cutoff * cutoff * cutoff / SDL_powf(cutoff * cutoff + 1.0f, 1.5f);
+    const f32 m = generator_uniform(seed, i, 0) * enclosed;
+    const f32 r = a / SDL_sqrtf(SDL_powf(m, -2.0f / 3.0f) - 1.0f);
+
+    // only the in-plane part of an isotropic direction survives the projection
+    const f32 cos_theta = 2.0f * generator_uniform(seed, i, 1) - 1.0f;
+    const f32 sin_theta = SDL_sqrtf(1.0f - cos_theta * cos_theta);
+    const HMM_Vec2 position = HMM_MulV2F(generator_direction(generator_uniform(seed, i, 2)), r * sin_theta);
+
+    // von Neumann rejection for q = v / v_escape from q^2 (1 - q^2)^3.5
+    f32 q = 0.0f;
+    for (u32 draw = 3; draw + 1 < GENERATOR_DRAWS; draw += 2) {
+        q = generator_uniform(seed, i, draw);
+        const f32 g = q * q * SDL_powf(1.0f - q * q, 3.5f);
+        if (0.1f * generator_uniform(seed, i, draw + 1) < g) break;
+    }
+
+    const f32 escape = SDL_sqrtf(2.0f * sim->gravity * options->mass / a) * SDL_powf(1.0f + r * r / (a * a), -0.25f);
+    const f32 cos_phi = 2.0f * generator_uniform(seed, i, GENERATOR_DRAWS - 2) - 1.0f;
+    const f32 sin_phi = SDL_sqrtf(1.0f - cos_phi * cos_phi);
+    const HMM_Vec2 velocity = HMM_MulV2F(generator_direction(generator_uniform(seed, i, GENERATOR_DRAWS - 1)), q * escape * sin_phi);
+
+    bodies->positions[i] = HMM_AddV2(options->center, position);
+    bodies->velocities[i] = velocity;
+    bodies->masses[i] = body_mass;
+    bodies->movable[i] = 1.0f;
+    bodies->colors[i] = generator_gradient((SDL_FColor) { 1.0f, 0.85f, 0.6f, 1.0f }, (SDL_FColor) { 0.5f, 0.6f, 1.0f, 1.0f }, r / (4.0f * a));
+}
+
+// surface density ~ exp(-r / h), so r follows a gamma distribution with shape 2
+static void generate_disk(const GeneratorOptions *options, const SimulationOptions *sim, BodyTable *bodies, const u32 i, const u32 first) {
+    const u64 seed = options->seed;
+    const f32 h = options->radius;
+    const f32 body_mass = options->mass / (f32) (options->count - first);
+
+    const f32 r = -h * SDL_logf(generator_uniform(seed, i, 0) * generator_uniform(seed, i, 1));
+    const HMM_Vec2 direction = generator_direction(generator_uniform(seed, i, 2));
+
+    // mass inside r of the disk treated as if it were spherical, plus the central body
+    const f32 x = r / h;
+    const f32 enclosed = options->mass * (1.0f - (1.0f + x) * SDL_expf(-x)) + (first ? options->central_mass : 0.0f);
+    const f32 speed = generator_circular_speed(sim, enclosed, r);
+
+    bodies->positions[i] = HMM_AddV2(options->center, HMM_MulV2F(direction, r));
+    bodies->velocities[i] = HMM_MulV2F(generator_perpendicular(direction), speed);
+    bodies->masses[i] = body_mass;
+    bodies->movable[i] = 1.0f;
+    bodies->colors[i] = generator_gradient((SDL_FColor) { 1.0f, 0.9f, 0.7f, 1.0f }, (SDL_FColor) { 0.4f, 0.5f, 1.0f, 1.0f }, x / 4.0f);
+}
+
+// pairs (2k, 2k + 1) on circular orbits around their barycenter, separations log-uniform in [radius / 1000, radius / 100]
+static void generate_binaries(const GeneratorOptions *options, const SimulationOptions *sim, BodyTable *bodies, const u32 i) {
+    const u64 seed = options->seed;
+    const u32 pair = i / 2;
+    const f32 body_mass = options->mass / (f32) options->count;
+
+    const f32 r = options->radius * SDL_sqrtf(generator_uniform(seed, pair, 0));
+    const HMM_Vec2 barycenter = HMM_AddV2(options->center, HMM_MulV2F(generator_direction(generator_uniform(seed, pair, 1)), r));
+    if ((i | 1) >= options->count) {
+        bodies->positions[i] = barycenter;
+        bodies->velocities[i] = HMM_V2(0.0f, 0.0f);
+    } else {
+        const f32 separation = options->radius * 0.001f * SDL_powf(10.0f, generator_uniform(seed, pair, 2));
+        const HMM_Vec2 axis = HMM_MulV2F(generator_direction(generator_uniform(seed, pair, 3)), i & 1 ? -1.0f : 1.0f);
+        const f32 speed = 0.5f * generator_circular_speed(sim, 2.0f * body_mass, separation);
+
+        bodies->positions[i] = HMM_AddV2(barycenter, HMM_MulV2F(axis, 0.5f * separation));
+        bodies->velocities[i] = HMM_MulV2F(generator_perpendicular(axis), speed);
+    }
+
+    bodies->masses[i] = body_mass;
+    bodies->movable[i] = 1.0f;
+    bodies->colors[i] = i & 1 ? (SDL_FColor) { 1.0f, 0.6f, 0.4f, 1.0f } : (SDL_FColor) { 0.6f, 0.8f, 1.0f, 1.0f };
+}
+
+// test particles on circular orbits around the central body, ring self-gravity is ignored
+static void generate_rings(const GeneratorOptions *options, const SimulationOptions *sim, BodyTable *bodies, const u32 i, const u32 first) {
+    const u64 seed = options->seed;
+    const u32 count = options->count - first;
+    const u32 rings = SDL_clamp(options->rings, 1, count);
+
+    // ring sizes differ by at most one body, so every ring gets some as long as there are at least as many bodies
+    const u32 ring = (u32) ((u64) (i - first) * rings / count);
+    const u32 ring_start = (u32) (((u64) ring * count + rings - 1) / rings);
+    const u32 ring_end = (u32) (((u64) (ring + 1) * count + rings - 1) / rings);
+    const u32 slot = i - first - ring_start;
+    const u32 ring_size = ring_end - ring_start;
+
+    const f32 r = options->radius * (f32) (ring + 1) / (f32) rings;
+    const f32 phase = generator_uniform(seed, ring, 0);
+    const HMM_Vec2 direction = generator_direction(phase + (f32) slot / (f32) ring_size);
+    const f32 speed = generator_circular_speed(sim, options->central_mass, r);
+
+    bodies->positions[i] = HMM_AddV2(options->center, HMM_MulV2F(direction, r));
+    bodies->velocities[i] = HMM_MulV2F(generator_perpendicular(direction), speed);
+    bodies->masses[i] = options->mass / (f32) count;
+    bodies->movable[i] = 1.0f;
+    bodies->colors[i] = generator_gradient((SDL_FColor) { 0.9f, 0.7f, 0.5f, 1.0f }, (SDL_FColor) { 0.5f, 0.8f, 0.9f, 1.0f }, (f32) ring / (f32) rings);
+}
+
+typedef struct {
+    const GeneratorOptions *options;
+    const SimulationOptions *sim;
+    BodyTable *bodies;
+    u32 first; // 1 if body 0 is the central body
+    u32 begin;
+    u32 end;
+} GeneratorJob;
+
+static i32 generator_worker(void *data) {
+    const GeneratorJob *job = data;
+    for (u32 i = job->begin; i < job->end; i++) {
+        switch (job->options->type) {
+            case GENERATOR_PLUMMER: generate_plummer(job->options, job->sim, job->bodies, i); break;
+            case GENERATOR_DISK: generate_disk(job->options, job->sim, job->bodies, i, job->first); break;
+            case GENERATOR_BINARIES: generate_binaries(job->options, job->sim, job->bodies, i); break;
+            case GENERATOR_RINGS: generate_rings(job->options, job->sim, job->bodies, i, job->first); break;
+            default: break;
+        }
+    }
+
+    return 0;
+}
+
+// every generator scales by the radius, a Plummer sphere of radius 0 has a NaN escape speed
+static bool generator_validate(const GeneratorOptions *options) {
+    if (!(options->radius > 0.0f) || SDL_isinff(options->radius)) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "generate_bodies(): The radius has to be positive and finite, not %g.\n", (f64) options->radius);
+        return false;
+    }
+
+    const u32 orbiting = options->count - (generator_has_center(options) ? 1 : 0);
+    if (options->type == GENERATOR_RINGS && orbiting && orbiting < options->rings) {
+        SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "generate_bodies(): %u bodies can't fill %u rings, generating %u rings instead.\n", orbiting, options->rings, orbiting);
+    }
+
+    return true;
+}
+
+bool generate_bodies(const GeneratorOptions *options, const SimulationOptions *sim, BodyTable *bodies) {
+    if (!generator_validate(options)) return false;
+    if (!body_table_alloc(bodies, options->count)) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "body_table_alloc() in generate_bodies(): Out of memory for %u bodies.\n", options->count);
+        return false;
+    }
+
+    const u32 first = generator_has_center(options) ? 1 : 0;
+    if (first) generate_central_body(options, bodies);
+    if (options->count <= first) return true;
+
+    // ranges start on even bodies so binary pairs are never split
+    const u32 count = options->count - first;
+    const u32 wanted = SDL_max(count / GENERATOR_BODIES_PER_THREAD, 1);
+    const u32 thread_count = SDL_min(SDL_min((u32) SDL_GetNumLogicalCPUCores(), wanted), GENERATOR_MAX_THREADS);
+    const u32 per_thread = ((count + thread_count - 1) / thread_count + 1) & ~1u;
+
+    GeneratorJob jobs[GENERATOR_MAX_THREADS];
+    SDL_Thread *threads[GENERATOR_MAX_THREADS] = { 0 };
+    for (u32 t = 0; t < thread_count; t++) {
+        jobs[t] = (GeneratorJob) {
+            .options = options,
+            .sim = sim,
+            .bodies = bodies,
+            .first = first,
+            .begin = SDL_min(first + t * per_thread, options->count),
+            .end = SDL_min(first + (t + 1) * per_thread, options->count),
+        };
+
+        // the calling thread takes the first range, and any range a thread couldn't be started for
+        if (t > 0) threads[t] = SDL_CreateThread(generator_worker, "generator", &jobs[t]);
+        if (t > 0 && !threads[t]) generator_worker(&jobs[t]);
+    }
+
+    generator_worker(&jobs[0]);
+    for (u32 t = 1; t < thread_count; t++) if (threads[t]) SDL_WaitThread(threads[t], NULL);
+    return true;
+}
@@ -4,6 +4,7 @@
 #include "camera.h"
 
 #include "sdl_utils.h"
+#include "tracer.h"
 
 void ghost_init(Ghost *ghost) {
     *ghost = (Ghost) {
@@ -35,7 +36,7 @@ void ghost_update(Ghost *ghost, SDL_GPUDevice *gpu, const Simulation *sim, const
             },
         };
 
-        ReadFromGPUBufferNow(gpu, bindings, 2);
+        TRACE_SCOPE("ReadFromGPUBufferNow") ReadFromGPUBufferNow(gpu, bindings, 2);
     }
 
     const HMM_Vec2 mouse = mouse_world_position(cam);
@@ -5,136 +5,236 @@
 #include "ghost.h"
 #include "trails.h"
 #include "trajectories.h"
+#include "tracking.h"
 #include "camera.h"
+#include "tracer.h"
 
 #include "SDL3/SDL_gpu.h"
-#include "dcimgui.h"
-#include "backends/dcimgui_impl_sdlgpu3.h"
 
-#define TRAIL_SIZE sizeof(HMM_Vec2) * TRAIL_LENGTH
-#define PREDICTION_SIZE sizeof(HMM_Vec2) * PREDICTIONS_LENGTH
+#define SPLAT_CLEAR_GROUPS 4096 // the clear loops over the rest
 
 SDL_AppResult graphics_init(Graphics *gfx, SDL_GPUDevice *gpu, SDL_Window *window) {
-    gfx->options = (GraphicsOptions) {
-        .clear_color = CLEAR_COLOR_DEFAULT,
-        .movable_outline = MOVABLE_OUTLINE_DEFAULT,
-        .static_outline = STATIC_OUTLINE_DEFAULT,
-        .trail_brightness = TRAIL_FADE_DEFAULT
-    };
+    gfx->format = window ? SDL_GetGPUSwapchainTextureFormat(gpu, window) : GRAPHICS_OFFSCREEN_FORMAT;
 
     gfx->body_pipeline = CreateGPUGraphicsPipeline(gpu, &(CreateGPUGraphicsPipelineInfo) {
         .window = window,
+        .format = gfx->format,
         .vertex_shader_path = "shaders/graphics/body.vert.spv",
         .fragment_shader_path = "shaders/graphics/circle.frag.spv",
         .primitive_type = SDL_GPU_PRIMITIVETYPE_TRIANGLESTRIP,
     });
 
-    gfx->trail_pipeline = CreateGPUGraphicsPipeline(gpu, &(CreateGPUGraphicsPipelineInfo) {
+    // trails and predictions have a pipeline per point encoding
+    const char *encodings[] = { "float", "half" };
+    for (u32 c = 0; c < 2; c++) {
+        char vertex_path[128], decimate_path[128];
+        SDL_snprintf(vertex_path, sizeof(vertex_path), "shaders/graphics/trail.%s.vert.spv", encodings[c]);
+        gfx->trail_pipelines[c] = CreateGPUGraphicsPipeline(gpu, &(CreateGPUGraphicsPipelineInfo) {
+            .window = window,
+            .format = gfx->format,
+            .vertex_shader_path = vertex_path,
+            .fragment_shader_path = "shaders/graphics/solid.frag.spv",
+            .primitive_type = SDL_GPU_PRIMITIVETYPE_LINESTRIP
+        });
+
+        SDL_snprintf(vertex_path, sizeof(vertex_path), "shaders/graphics/trajectory.%s.vert.spv", encodings[c]);
+        gfx->trajectory_pipelines[c] = CreateGPUGraphicsPipeline(gpu, &(CreateGPUGraphicsPipelineInfo) {
+            .window = window,
+            .format = gfx->format,
+            .vertex_shader_path = vertex_path,
+            .fragment_shader_path = "shaders/graphics/solid.frag.spv",
+            .primitive_type = SDL_GPU_PRIMITIVETYPE_LINESTRIP
+        });
+
+        SDL_snprintf(vertex_path, sizeof(vertex_path), "shaders/graphics/ghost_trajectory.%s.vert.spv", encodings[c]);
+        gfx->ghost_trajectory_pipelines[c] = CreateGPUGraphicsPipeline(gpu, &(CreateGPUGraphicsPipelineInfo) {
+            .window = window,
+            .format = gfx->format,
+            .vertex_shader_path = vertex_path,
+            .fragment_shader_path = "shaders/graphics/solid.frag.spv",
+            .primitive_type = SDL_GPU_PRIMITIVETYPE_LINESTRIP
+        });
+
+        SDL_snprintf(decimate_path, sizeof(decimate_path), "shaders/trail_decimate.%s.comp.spv", encodings[c]);
+        gfx->trail_decimate_pipelines[c] = CreateGPUComputePipeline(gpu, decimate_path);
+
+        if (!gfx->trail_pipelines[c]) panic("Failed to create trail graphics pipeline!");
+        if (!gfx->trajectory_pipelines[c]) panic("Failed to create trajectory graphics pipeline!");
+        if (!gfx->ghost_trajectory_pipelines[c]) panic("Failed to create ghost trajectory pipeline!");
+        if (!gfx->trail_decimate_pipelines[c]) panic("Failed to create trail decimation pipeline!");
+    }
+
+    gfx->ghost_body_pipeline = CreateGPUGraphicsPipeline(gpu, &(CreateGPUGraphicsPipelineInfo) {
         .window = window,
-        .vertex_shader_path = "shaders/graphics/trail.vert.spv",
-        .fragment_shader_path = "shaders/graphics/solid.frag.spv",
-        .primitive_type = SDL_GPU_PRIMITIVETYPE_LINESTRIP
+        .format = gfx->format,
+        .vertex_shader_path = "shaders/graphics/ghost_body.vert.spv",
+        .fragment_shader_path = "shaders/graphics/circle.frag.spv",
+        .primitive_type = SDL_GPU_PRIMITIVETYPE_TRIANGLESTRIP
     });
 
-    gfx->trajectory_pipeline = CreateGPUGraphicsPipeline(gpu, &(CreateGPUGraphicsPipelineInfo) {
+    if (!gfx->body_pipeline) panic("Failed to create circle graphics pipeline!");
+    if (!gfx->ghost_body_pipeline) panic("Failed to create ghost body pipeline!");
+
+    gfx->splat_pipeline = CreateGPUGraphicsPipeline(gpu, &(CreateGPUGraphicsPipelineInfo) {
         .window = window,
-        .vertex_shader_path = "shaders/graphics/trajectory.vert.spv",
-        .fragment_shader_path = "shaders/graphics/solid.frag.spv",
-        .primitive_type = SDL_GPU_PRIMITIVETYPE_LINESTRIP
+        .format = gfx->format,
+        .vertex_shader_path = "shaders/graphics/splat.vert.spv",
+        .fragment_shader_path = "shaders/graphics/splat.frag.spv",
+        .primitive_type = SDL_GPU_PRIMITIVETYPE_TRIANGLELIST
     });
 
-    gfx->ghost_body_pipeline = CreateGPUGraphicsPipeline(gpu, &(CreateGPUGraphicsPipelineInfo) {
+    gfx->splat_pipelines[0] = CreateGPUComputePipeline(gpu, "shaders/splat.clear.comp.spv");
+    gfx->splat_pipelines[1] = CreateGPUComputePipeline(gpu, "shaders/splat.accumulate.comp.spv");
+    if (!gfx->splat_pipeline || !gfx->splat_pipelines[0] || !gfx->splat_pipelines[1]) panic("Failed to create splat pipelines!");
+
+    gfx->cull_pipelines[0] = CreateGPUComputePipeline(gpu, "shaders/cull.count.comp.spv");
+    gfx->cull_pipelines[1] = CreateGPUComputePipeline(gpu, "shaders/cull.scan.comp.spv");
+    gfx->cull_pipelines[2] = CreateGPUComputePipeline(gpu, "shaders/cull.scatter.comp.spv");
+    if (!gfx->cull_pipelines[0] || !gfx->cull_pipelines[1] || !gfx->cull_pipelines[2]) panic("Failed to create cull compute pipelines!");
+
+    gfx->render_data_pipeline = CreateGPUComputePipeline(gpu, "shaders/render_data.comp.spv");
+    if (!gfx->render_data_pipeline) panic("Failed to create render data pipeline!");
+
+    gfx->field_pipelines[0] = CreateGPUComputePipeline(gpu, "shaders/field.check.comp.spv");
+    gfx->field_pipelines[1] = CreateGPUComputePipeline(gpu, "shaders/field.commit.comp.spv");
+    gfx->field_pipelines[2] = CreateGPUComputePipeline(gpu, "shaders/field.evaluate.comp.spv");
+    gfx->field_map_pipeline = CreateGPUGraphicsPipeline(gpu, &(CreateGPUGraphicsPipelineInfo) {
         .window = window,
-        .vertex_shader_path = "shaders/graphics/ghost_body.vert.spv",
-        .fragment_shader_path = "shaders/graphics/circle.frag.spv",
+        .format = gfx->format,
+        .vertex_shader_path = "shaders/graphics/field.map.vert.spv",
+        .fragment_shader_path = "shaders/graphics/field.frag.spv",
         .primitive_type = SDL_GPU_PRIMITIVETYPE_TRIANGLESTRIP
     });
 
-    gfx->ghost_trajectory_pipeline = CreateGPUGraphicsPipeline(gpu, &(CreateGPUGraphicsPipelineInfo) {
+    gfx->field_arrow_pipeline = CreateGPUGraphicsPipeline(gpu, &(CreateGPUGraphicsPipelineInfo) {
         .window = window,
-        .vertex_shader_path = "shaders/graphics/ghost_trajectory.vert.spv",
+        .format = gfx->format,
+        .vertex_shader_path = "shaders/graphics/field.arrows.vert.spv",
         .fragment_shader_path = "shaders/graphics/solid.frag.spv",
-        .primitive_type = SDL_GPU_PRIMITIVETYPE_LINESTRIP
+        .primitive_type = SDL_GPU_PRIMITIVETYPE_LINELIST
     });
 
-    if (!gfx->body_pipeline) panic("Failed to create circle graphics pipeline!");
-    if (!gfx->trail_pipeline) panic("Failed to create trail graphics pipeline!");
-    if (!gfx->trajectory_pipeline) panic("Failed to create trail graphics pipeline!");
-    if (!gfx->ghost_body_pipeline) panic("Failed to create ghost body pipeline!");
-    if (!gfx->ghost_trajectory_pipeline) panic("Failed to create ghost trajectory pipeline!");
+    if (!gfx->field_pipelines[0] || !gfx->field_pipelines[1] || !gfx->field_pipelines[2] || !gfx->field_map_pipeline || !gfx->field_arrow_pipeline) panic("Failed to create field pipelines!");
 
-    gfx->colors = CreateGPUArray(gpu, sizeof(SDL_FColor), SDL_GPU_BUFFERUSAGE_GRAPHICS_STORAGE_READ);
-    if (!gfx->colors.buffer) panic("Failed to create color storage buffer!");
+    gfx->field_range = SDL_CreateGPUBuffer(gpu, &(SDL_GPUBufferCreateInfo) {
+        .size = 2 * sizeof(u32),
+        .usage = SDL_GPU_BUFFERUSAGE_COMPUTE_STORAGE_WRITE | SDL_GPU_BUFFERUSAGE_COMPUTE_STORAGE_READ | SDL_GPU_BUFFERUSAGE_GRAPHICS_STORAGE_READ
+    });
 
-    return SDL_APP_CONTINUE;
-}
+    gfx->field_arguments = SDL_CreateGPUBuffer(gpu, &(SDL_GPUBufferCreateInfo) {
+        .size = sizeof(SDL_GPUIndirectDispatchCommand) + 2 * sizeof(u32),
+        .usage = SDL_GPU_BUFFERUSAGE_INDIRECT | SDL_GPU_BUFFERUSAGE_COMPUTE_STORAGE_WRITE | SDL_GPU_BUFFERUSAGE_COMPUTE_STORAGE_READ
+    });
 
-u32 graphics_add_body(Graphics *gfx, SDL_GPUDevice *gpu, SDL_GPUCopyPass *copy_pass, SDL_FColor *color) {
-    AppendGPUArrays(gpu, copy_pass, &(AppendGPUArrayBinding) {
-        .array = &gfx->colors,
-        .source = (u8 *) color,
-        .size = sizeof(SDL_FColor)
-    }, 1);
+    if (!gfx->field_range || !gfx->field_arguments) panic("Failed to create field buffers!");
+
+    gfx->draw_arguments = SDL_CreateGPUBuffer(gpu, &(SDL_GPUBufferCreateInfo) {
+        .size = sizeof(SDL_GPUIndirectDrawCommand),
+        .usage = SDL_GPU_BUFFERUSAGE_INDIRECT | SDL_GPU_BUFFERUSAGE_COMPUTE_STORAGE_WRITE
+    });
 
-    return gfx->body_count++;
+    if (!gfx->draw_arguments) panic("Failed to create indirect draw buffer!");
+
+    return SDL_APP_CONTINUE;
 }
 
 static void graphics_uniform_camera(SDL_GPUCommandBuffer *command_buffer, const Camera *cam, const u32 slot);
 typedef struct {
     SDL_GPUCommandBuffer *command_buffer;
     const SimulationOptions *sim;
+    const GraphicsOptions *options;
     const Trails *trails;
+    const Trajectories *trajectories;
+    const Tracking *tracking;
     const Camera *cam;
     const u32 slot;
 } GraphicsUniformConsantsInfo;
-static void graphics_uniform_constants(const Graphics *gfx, const GraphicsUniformConsantsInfo *info);
+static void graphics_uniform_constants(const GraphicsUniformConsantsInfo *info);
 
+typedef struct {
+    u32 width;
+    u32 height;
+} GraphicsViewport;
+static bool graphics_render_data(Graphics *gfx, const GraphicsDrawInfo *info);
+static void graphics_cull(Graphics *gfx, const GraphicsDrawInfo *info, GraphicsViewport viewport, bool splatted);
+static bool graphics_splat(Graphics *gfx, const GraphicsDrawInfo *info, GraphicsViewport viewport);
+static void graphics_splat_draw(const Graphics *gfx, const GraphicsOptions *options, SDL_GPUCommandBuffer *command_buffer, SDL_GPURenderPass *render_pass, GraphicsViewport viewport);
+static bool graphics_trails_decimate(Graphics *gfx, const GraphicsDrawInfo *info, GraphicsViewport viewport);
 static void graphics_simulation_draw(const Graphics *gfx, const Simulation *sim, SDL_GPURenderPass *render_pass);
+static bool graphics_field(Graphics *gfx, const GraphicsDrawInfo *info, GraphicsViewport viewport);
+static void graphics_field_draw(const Graphics *gfx, const GraphicsOptions *options, SDL_GPUCommandBuffer *command_buffer, SDL_GPURenderPass *render_pass);
 typedef struct {
     SDL_GPUCommandBuffer *command_buffer;
     SDL_GPURenderPass *render_pass;
+    const Simulation *sim;
     const Trajectories *trajectories;
+    const Tracking *tracking;
 } GraphicsGhostDrawInfo;
 static void graphics_ghost_draw(const Graphics *gfx, const Ghost *ghost, const GraphicsGhostDrawInfo *info);
-static void graphics_trails_draw(const Graphics *gfx, const Trails *trails, SDL_GPURenderPass *render_pass);
-static void graphics_trajectories_draw(const Graphics *gfx, const Trajectories *trajectories, SDL_GPURenderPass *render_pass);
-static void graphics_gui_draw(SDL_GPUCommandBuffer *command_buffer, SDL_GPUTexture *swapchain);
-
-void graphics_draw(const Graphics *gfx, const GraphicsDrawInfo *info) {
-    SDL_GPUTexture *swapchain;
-    SDL_WaitAndAcquireGPUSwapchainTexture(info->command_buffer, info->window, &swapchain, NULL, NULL);
+static void graphics_trails_draw(const Graphics *gfx, const GraphicsDrawInfo *info, SDL_GPURenderPass *render_pass);
+typedef struct {
+    SDL_GPURenderPass *render_pass;
+    const Simulation *sim;
+    const Trajectories *trajectories;
+    const Tracking *tracking;
+    const Appearance *appearance;
+} GraphicsTrajectoriesDrawInfo;
+static void graphics_trajectories_draw(const Graphics *gfx, const GraphicsTrajectoriesDrawInfo *info);
+SDL_GPUTexture *graphics_draw(Graphics *gfx, const GraphicsDrawInfo *info) {
+    SDL_GPUTexture *swapchain = info->target;
+    GraphicsViewport viewport = { info->target_width, info->target_height };
+    if (!info->target) TRACE_SCOPE("SDL_WaitAndAcquireGPUSwapchainTexture") SDL_WaitAndAcquireGPUSwapchainTexture(info->command_buffer, info->window, &swapchain, &viewport.width, &viewport.height);
     if (!swapchain) {
         SDL_SubmitGPUCommandBuffer(info->command_buffer);
-        return;
+        return NULL;
     }
 
+    const bool rendered = graphics_render_data(gfx, info);
+    const bool splatted = rendered && graphics_splat(gfx, info, viewport);
+    if (rendered) graphics_cull(gfx, info, viewport, splatted);
+    const bool decimated = graphics_trails_decimate(gfx, info, viewport);
+    const bool field = graphics_field(gfx, info, viewport);
+
     graphics_uniform_camera(info->command_buffer, info->cam, 0);
-    graphics_uniform_constants(gfx, &(GraphicsUniformConsantsInfo) {
+    SDL_GPURenderPass *render_pass = SDL_BeginGPURenderPass(info->command_buffer, &(SDL_GPUColorTargetInfo) {
+        .clear_color = info->appearance->options.clear_color,
+        .load_op = SDL_GPU_LOADOP_CLEAR,
+        .store_op = SDL_GPU_STOREOP_STORE,
+        .texture = swapchain
+    }, 1, NULL);
+
+    // the field pushes its own constants into slot 1, so the shared ones follow it
+    if (field) graphics_field_draw(gfx, &info->appearance->options, info->command_buffer, render_pass);
+    graphics_uniform_constants(&(GraphicsUniformConsantsInfo) {
         .command_buffer = info->command_buffer,
         .sim = &info->sim->options,
+        .options = &info->appearance->options,
         .trails = info->trails,
+        .trajectories = info->trajectories,
+        .tracking = info->tracking,
         .cam = info->cam,
         .slot = 1
     });
 
-    SDL_GPURenderPass *render_pass = SDL_BeginGPURenderPass(info->command_buffer, &(SDL_GPUColorTargetInfo) {
-        .clear_color = gfx->options.clear_color,
-        .load_op = SDL_GPU_LOADOP_CLEAR,
-        .store_op = SDL_GPU_STOREOP_STORE,
-        .texture = swapchain
-    }, 1, NULL);
-
-    graphics_simulation_draw(gfx, info->sim, render_pass);
+    if (splatted) graphics_splat_draw(gfx, &info->appearance->options, info->command_buffer, render_pass, viewport);
+    if (rendered) graphics_simulation_draw(gfx, info->sim, render_pass);
     graphics_ghost_draw(gfx, info->ghost, &(GraphicsGhostDrawInfo) {
         .command_buffer = info->command_buffer,
         .render_pass = render_pass,
-        .trajectories = info->trajectories
+        .sim = info->sim,
+        .trajectories = info->trajectories,
+        .tracking = info->tracking
+    });
+    if (decimated) graphics_trails_draw(gfx, info, render_pass);
+    graphics_trajectories_draw(gfx, &(GraphicsTrajectoriesDrawInfo) {
+        .render_pass = render_pass,
+        .sim = info->sim,
+        .trajectories = info->trajectories,
+        .tracking = info->tracking,
+        .appearance = info->appearance
     });
-    graphics_trails_draw(gfx, info->trails, render_pass);
-    graphics_trajectories_draw(gfx, info->trajectories, render_pass);
     SDL_EndGPURenderPass(render_pass);
-
-    graphics_gui_draw(info->command_buffer, swapchain);
+    return swapchain;
 }
 
 static void graphics_uniform_camera(SDL_GPUCommandBuffer *command_buffer, const Camera *cam, const u32 slot) {
@@ -142,7 +242,7 @@ static void graphics_uniform_camera(SDL_GPUCommandBuffer *command_buffer, const
     SDL_PushGPUVertexUniformData(command_buffer, slot, &matrices, sizeof(matrices));
 }
 
-static void graphics_uniform_constants(const Graphics *gfx, const GraphicsUniformConsantsInfo *info) {
+static void graphics_uniform_constants(const GraphicsUniformConsantsInfo *info) {
     const struct {
         f32 density;
         f32 movable_outline;
@@ -150,28 +250,236 @@ static void graphics_uniform_constants(const Graphics *gfx, const GraphicsUnifor
         u32 trail_target;
         f32 trail_brightness;
         u32 trail_frame;
+        u32 trail_length;
+        u32 prediction_length;
     } constants = {
         info->sim->density,
-        gfx->options.movable_outline,
-        gfx->options.static_outline,
-        info->cam->target,
-        gfx->options.trail_brightness,
+        info->options->movable_outline,
+        info->options->static_outline,
+        tracking_slot(info->tracking, info->cam->target),
+        info->options->trail_brightness,
         info->trails->frame,
+        info->trails->length,
+        info->trajectories->length,
     };
 
     SDL_PushGPUVertexUniformData(info->command_buffer, info->slot, &constants, sizeof(constants));
 }
 
+// rebuilds the per body radius and colour when bodies were added or loaded or the density changed,
+// false when there are no bodies to draw or the buffer couldn't grow
+static bool graphics_render_data(Graphics *gfx, const GraphicsDrawInfo *info) {
+    const Simulation *sim = info->sim;
+    if (!sim->body_count) return false;
+    if (gfx->render_capacity < sim->body_count) {
+        const u32 capacity = sim->body_count + sim->body_count / 2;
+        SDL_GPUBuffer *render_data = SDL_CreateGPUBuffer(info->gpu, &(SDL_GPUBufferCreateInfo) {
+            .size = capacity * 2 * (u32) sizeof(u32),
+            .usage = SDL_GPU_BUFFERUSAGE_COMPUTE_STORAGE_READ | SDL_GPU_BUFFERUSAGE_COMPUTE_STORAGE_WRITE | SDL_GPU_BUFFERUSAGE_GRAPHICS_STORAGE_READ
+        });
+
+        if (!render_data) {
+            SDL_LogError(SDL_LOG_CATEGORY_GPU, "SDL_CreateGPUBuffer() in graphics_render_data(): %s\n", SDL_GetError());
+            return false;
+        }
+
+        SDL_ReleaseGPUBuffer(info->gpu, gfx->render_data);
+        gfx->render_data = render_data;
+        gfx->render_capacity = capacity;
+        gfx->render_dirty = true;
+    }
+
+    const Appearance *appearance = info->appearance;
+    if (!gfx->render_dirty && gfx->render_revision == appearance->revision && gfx->render_density == sim->options.density) return true;
+    const struct {
+        u32 body_count;
+        f32 density;
+    } constants = { sim->body_count, sim->options.density };
+
+    SDL_PushGPUComputeUniformData(info->command_buffer, 0, &constants, sizeof(constants));
+    TRACE_SCOPE("graphics_render_data") {
+        SDL_GPUComputePass *compute_pass = SDL_BeginGPUComputePass(info->command_buffer, NULL, 0, (SDL_GPUStorageBufferReadWriteBinding[]) {
+            { .buffer = gfx->render_data, .cycle = false },
+        }, 1);
+
+        SDL_GPUBuffer *buffers[] = { sim->masses.buffer, sim->movable.buffer, appearance->colors.buffer };
+        SDL_BindGPUComputePipeline(compute_pass, gfx->render_data_pipeline);
+        SDL_BindGPUComputeStorageBuffers(compute_pass, 0, buffers, SDL_arraysize(buffers));
+        SDL_DispatchGPUCompute(compute_pass, WORKGROUP_COUNT(sim->body_count), 1, 1);
+        SDL_EndGPUComputePass(compute_pass);
+    }
+
+    gfx->render_dirty = false;
+    gfx->render_revision = appearance->revision;
+    gfx->render_density = sim->options.density;
+    return true;
+}
+
+// grows the cull buffers to fit the bodies, on failure the old ones are kept and the bodies are skipped this frame
+static bool graphics_cull_reserve(Graphics *gfx, SDL_GPUDevice *gpu, const u32 body_count) {
+    if (gfx->cull_capacity >= body_count) return true;
+    const u32 capacity = body_count + body_count / 2;
+
+    SDL_GPUBuffer *groups = SDL_CreateGPUBuffer(gpu, &(SDL_GPUBufferCreateInfo) {
+        .size = WORKGROUP_COUNT(capacity) * (u32) sizeof(u32),
+        .usage = SDL_GPU_BUFFERUSAGE_COMPUTE_STORAGE_READ | SDL_GPU_BUFFERUSAGE_COMPUTE_STORAGE_WRITE
+    });
+
+    SDL_GPUBuffer *visible = SDL_CreateGPUBuffer(gpu, &(SDL_GPUBufferCreateInfo) {
+        .size = capacity * (u32) sizeof(u32),
+        .usage = SDL_GPU_BUFFERUSAGE_COMPUTE_STORAGE_WRITE | SDL_GPU_BUFFERUSAGE_GRAPHICS_STORAGE_READ
+    });
+
+    if (!groups || !visible) {
+        SDL_LogError(SDL_LOG_CATEGORY_GPU, "SDL_CreateGPUBuffer() in graphics_cull_reserve(): %s\n", SDL_GetError());
+        SDL_ReleaseGPUBuffer(gpu, groups);
+        SDL_ReleaseGPUBuffer(gpu, visible);
+        return false;
+    }
+
+    SDL_ReleaseGPUBuffer(gpu, gfx->cull_groups);
+    SDL_ReleaseGPUBuffer(gpu, gfx->visible);
+    gfx->cull_groups = groups;
+    gfx->visible = visible;
+    gfx->cull_capacity = capacity;
+    return true;
+}
+
+// compacts the bodies whose quad touches the screen and that aren't splatted into `visible` and writes the instance count to `draw_arguments`,
+// three passes so each stage sees the previous one's writes
+static void graphics_cull(Graphics *gfx, const GraphicsDrawInfo *info, const GraphicsViewport viewport, const bool splatted) {
+    const Simulation *sim = info->sim;
+    if (!sim->body_count || !graphics_cull_reserve(gfx, info->gpu, sim->body_count)) return;
+
+    const struct {
+        HMM_Mat4 orthographic;
+        HMM_Mat4 view;
+        u32 body_count;
+        f32 splat_radius; // 0 keeps every body
+        f32 viewport_width;
+        u32 _padding;
+    } constants = {
+        info->cam->orthographic, info->cam->view,
+        sim->body_count, splatted ? info->appearance->options.splat_radius : 0.0f, (f32) viewport.width, 0
+    };
+
+    SDL_PushGPUComputeUniformData(info->command_buffer, 0, &constants, sizeof(constants));
+    SDL_GPUBuffer *inputs[] = { sim->positions.buffer, gfx->render_data };
+    const u32 groups = WORKGROUP_COUNT(sim->body_count);
+
+    TRACE_SCOPE("graphics_cull") {
+        SDL_GPUComputePass *compute_pass = SDL_BeginGPUComputePass(info->command_buffer, NULL, 0, (SDL_GPUStorageBufferReadWriteBinding[]) {
+            { .buffer = gfx->cull_groups, .cycle = false },
+        }, 1);
+
+        SDL_BindGPUComputePipeline(compute_pass, gfx->cull_pipelines[0]);
+        SDL_BindGPUComputeStorageBuffers(compute_pass, 0, inputs, SDL_arraysize(inputs));
+        SDL_DispatchGPUCompute(compute_pass, groups, 1, 1);
+        SDL_EndGPUComputePass(compute_pass);
+
+        compute_pass = SDL_BeginGPUComputePass(info->command_buffer, NULL, 0, (SDL_GPUStorageBufferReadWriteBinding[]) {
+            { .buffer = gfx->cull_groups, .cycle = false },
+            { .buffer = gfx->draw_arguments, .cycle = false },
+        }, 2);
+
+        SDL_BindGPUComputePipeline(compute_pass, gfx->cull_pipelines[1]);
+        SDL_DispatchGPUCompute(compute_pass, 1, 1, 1);
+        SDL_EndGPUComputePass(compute_pass);
+
+        compute_pass = SDL_BeginGPUComputePass(info->command_buffer, NULL, 0, (SDL_GPUStorageBufferReadWriteBinding[]) {
+            { .buffer = gfx->cull_groups, .cycle = false },
+            { .buffer = gfx->visible, .cycle = false },
+        }, 2);
+
+        SDL_BindGPUComputePipeline(compute_pass, gfx->cull_pipelines[2]);
+        SDL_BindGPUComputeStorageBuffers(compute_pass, 0, inputs, SDL_arraysize(inputs));
+        SDL_DispatchGPUCompute(compute_pass, groups, 1, 1);
+        SDL_EndGPUComputePass(compute_pass);
+    }
+}
+
+// accumulates the bodies below `splat_radius` pixels into the density buffer, false when splatting is off or failed
+static bool graphics_splat(Graphics *gfx, const GraphicsDrawInfo *info, const GraphicsViewport viewport) {
+    const Simulation *sim = info->sim;
+    const u32 pixels = viewport.width * viewport.height;
+    if (info->appearance->options.splat_radius <= 0.0f || !sim->body_count || !pixels) return false;
+
+    if (gfx->splat_capacity < pixels) {
+        SDL_GPUBuffer *density = SDL_CreateGPUBuffer(info->gpu, &(SDL_GPUBufferCreateInfo) {
+            .size = pixels * 3 * (u32) sizeof(u32),
+            .usage = SDL_GPU_BUFFERUSAGE_COMPUTE_STORAGE_READ | SDL_GPU_BUFFERUSAGE_COMPUTE_STORAGE_WRITE | SDL_GPU_BUFFERUSAGE_GRAPHICS_STORAGE_READ
+        });
+
+        if (!density) {
+            SDL_LogError(SDL_LOG_CATEGORY_GPU, "SDL_CreateGPUBuffer() in graphics_splat(): %s\n", SDL_GetError());
+            return false;
+        }
+
+        SDL_ReleaseGPUBuffer(info->gpu, gfx->splat_density);
+        gfx->splat_density = density;
+        gfx->splat_capacity = pixels;
+    }
+
+    const struct {
+        HMM_Mat4 orthographic;
+        HMM_Mat4 view;
+        u32 body_count;
+        f32 splat_radius;
+        f32 movable_outline;
+        f32 static_outline;
+        u32 width;
+        u32 height;
+        u32 _padding[2];
+    } constants = {
+        info->cam->orthographic, info->cam->view,
+        sim->body_count, info->appearance->options.splat_radius, info->appearance->options.movable_outline, info->appearance->options.static_outline,
+        viewport.width, viewport.height, { 0, 0 }
+    };
+
+    SDL_PushGPUComputeUniformData(info->command_buffer, 0, &constants, sizeof(constants));
+    TRACE_SCOPE("graphics_splat") {
+        SDL_GPUComputePass *compute_pass = SDL_BeginGPUComputePass(info->command_buffer, NULL, 0, (SDL_GPUStorageBufferReadWriteBinding[]) {
+            { .buffer = gfx->splat_density, .cycle = false },
+        }, 1);
+
+        SDL_BindGPUComputePipeline(compute_pass, gfx->splat_pipelines[0]);
+        SDL_DispatchGPUCompute(compute_pass, SDL_min(WORKGROUP_COUNT(pixels * 3), SPLAT_CLEAR_GROUPS), 1, 1);
+        SDL_EndGPUComputePass(compute_pass);
+
+        compute_pass = SDL_BeginGPUComputePass(info->command_buffer, NULL, 0, (SDL_GPUStorageBufferReadWriteBinding[]) {
+            { .buffer = gfx->splat_density, .cycle = false },
+        }, 1);
+
+        SDL_GPUBuffer *buffers[] = { sim->positions.buffer, gfx->render_data };
+        SDL_BindGPUComputePipeline(compute_pass, gfx->splat_pipelines[1]);
+        SDL_BindGPUComputeStorageBuffers(compute_pass, 0, buffers, SDL_arraysize(buffers));
+        SDL_DispatchGPUCompute(compute_pass, WORKGROUP_COUNT(sim->body_count), 1, 1);
+        SDL_EndGPUComputePass(compute_pass);
+    }
+
+    return true;
+}
+
+static void graphics_splat_draw(const Graphics *gfx, const GraphicsOptions *options, SDL_GPUCommandBuffer *command_buffer, SDL_GPURenderPass *render_pass, const GraphicsViewport viewport) {
+    const struct {
+        u32 width;
+        u32 height;
+        f32 exposure;
+        u32 _padding;
+    } constants = { viewport.width, viewport.height, options->splat_exposure, 0 };
+
+    SDL_BindGPUGraphicsPipeline(render_pass, gfx->splat_pipeline);
+    SDL_PushGPUFragmentUniformData(command_buffer, 0, &constants, sizeof(constants));
+    SDL_BindGPUFragmentStorageBuffers(render_pass, 0, &gfx->splat_density, 1);
+    SDL_DrawGPUPrimitives(render_pass, 3, 1, 0, 0);
+}
+
 static void graphics_simulation_draw(const Graphics *gfx, const Simulation *sim, SDL_GPURenderPass *render_pass) {
-    if (!sim->body_count) return;
+    if (!sim->body_count || gfx->cull_capacity < sim->body_count) return;
     SDL_BindGPUGraphicsPipeline(render_pass, gfx->body_pipeline);
-    SDL_GPUBuffer *buffers[] = { sim->positions.buffer, gfx->colors.buffer, sim->masses.buffer, sim->movable.buffer };
+    SDL_GPUBuffer *buffers[] = { sim->positions.buffer, gfx->render_data, gfx->visible };
     SDL_BindGPUVertexStorageBuffers(render_pass, 0, buffers, sizeof(buffers) / sizeof(SDL_GPUBuffer *));
-    SDL_DrawGPUPrimitives(
-        render_pass,
-        4, sim->body_count,
-        0, 0
-    );
+    SDL_DrawGPUPrimitivesIndirect(render_pass, gfx->draw_arguments, 0, 1);
 }
 
 static void graphics_ghost_draw(const Graphics *gfx, const Ghost *ghost, const GraphicsGhostDrawInfo *info) {
@@ -182,12 +490,12 @@ static void graphics_ghost_draw(const Graphics *gfx, const Ghost *ghost, const G
     struct {
         SDL_FColor color;
         HMM_Vec2 position;
-        f32 mass;
+        f32 radius;
         f32 movable;
     } ghost_info = {
         ghost->color,
         ghost->position,
-        ghost->mass,
+        SDL_powf(ghost->mass / info->sim->options.density, 1.0f / 3.0f),
         ghost->movable
     };
 
@@ -195,58 +503,287 @@ static void graphics_ghost_draw(const Graphics *gfx, const Ghost *ghost, const G
     SDL_DrawGPUPrimitives(info->render_pass, 4, 1, 0, 0);
 
     if (info->trajectories->enabled) {
-        SDL_GPUBuffer *buffers[] = { info->trajectories->positions.buffer, info->trajectories->ghost };
+        SDL_GPUBuffer *buffers[] = { info->trajectories->positions.buffer, info->trajectories->ghost, info->sim->positions.buffer, info->tracking->body_table.buffer };
         SDL_BindGPUVertexStorageBuffers(info->render_pass, 0, buffers, sizeof(buffers) / sizeof(SDL_GPUBuffer *));
-        SDL_BindGPUGraphicsPipeline(info->render_pass, gfx->ghost_trajectory_pipeline);
-        SDL_DrawGPUPrimitives(info->render_pass, PREDICTION_LENGTH, 1, 0, 0);
+        SDL_BindGPUGraphicsPipeline(info->render_pass, gfx->ghost_trajectory_pipelines[info->trajectories->compact]);
+        SDL_DrawGPUPrimitives(info->render_pass, info->trajectories->length, 1, 0, 0);
     }
 }
 
-static void graphics_trails_draw(const Graphics *gfx, const Trails *trails, SDL_GPURenderPass *render_pass) {
-    if (!trails->body_count) return;
-    SDL_BindGPUGraphicsPipeline(render_pass, gfx->trail_pipeline);
-    SDL_GPUBuffer *buffers[] = { trails->array.buffer, gfx->colors.buffer };
-    SDL_BindGPUVertexStorageBuffers(render_pass, 0, buffers, sizeof(buffers) / sizeof(SDL_GPUBuffer *));
-    SDL_DrawGPUPrimitives(
-        render_pass,
-        TRAIL_LENGTH, trails->body_count,
-        0, 0
-    );
+// keeps only the trail points that bend the line by more than `trail_tolerance` pixels, one indirect draw per slot,
+// false when there is nothing to draw or the buffers couldn't grow
+static bool graphics_trails_decimate(Graphics *gfx, const GraphicsDrawInfo *info, const GraphicsViewport viewport) {
+    const Trails *trails = info->trails;
+    if (!trails->slot_count) return false;
+
+    const u32 entries = trails->slot_count * trails->length;
+    if (gfx->trail_index_capacity < entries) {
+        const u32 capacity = entries + entries / 2;
+        SDL_GPUBuffer *indices = SDL_CreateGPUBuffer(info->gpu, &(SDL_GPUBufferCreateInfo) {
+            .size = capacity * (u32) sizeof(u32),
+            .usage = SDL_GPU_BUFFERUSAGE_COMPUTE_STORAGE_WRITE | SDL_GPU_BUFFERUSAGE_GRAPHICS_STORAGE_READ
+        });
+
+        if (!indices) {
+            SDL_LogError(SDL_LOG_CATEGORY_GPU, "SDL_CreateGPUBuffer() in graphics_trails_decimate(): %s\n", SDL_GetError());
+            return false;
+        }
+
+        SDL_ReleaseGPUBuffer(info->gpu, gfx->trail_indices);
+        gfx->trail_indices = indices;
+        gfx->trail_index_capacity = capacity;
+    }
+
+    if (gfx->trail_argument_capacity < trails->slot_count) {
+        const u32 capacity = trails->slot_count + trails->slot_count / 2;
+        SDL_GPUBuffer *arguments = SDL_CreateGPUBuffer(info->gpu, &(SDL_GPUBufferCreateInfo) {
+            .size = capacity * (u32) sizeof(SDL_GPUIndirectDrawCommand),
+            .usage = SDL_GPU_BUFFERUSAGE_INDIRECT | SDL_GPU_BUFFERUSAGE_COMPUTE_STORAGE_WRITE
+        });
+
+        if (!arguments) {
+            SDL_LogError(SDL_LOG_CATEGORY_GPU, "SDL_CreateGPUBuffer() in graphics_trails_decimate(): %s\n", SDL_GetError());
+            return false;
+        }
+
+        SDL_ReleaseGPUBuffer(info->gpu, gfx->trail_arguments);
+        gfx->trail_arguments = arguments;
+        gfx->trail_argument_capacity = capacity;
+    }
+
+    const struct {
+        HMM_Mat4 orthographic;
+        HMM_Mat4 view;
+        u32 slot_count;
+        u32 target;
+        u32 frame;
+        u32 trail_length;
+        f32 tolerance;
+        f32 width;
+        f32 height;
+        u32 _padding;
+    } constants = {
+        info->cam->orthographic, info->cam->view,
+        trails->slot_count, tracking_slot(info->tracking, info->cam->target), trails->frame, trails->length,
+        info->appearance->options.trail_tolerance, (f32) viewport.width, (f32) viewport.height, 0
+    };
+
+    SDL_PushGPUComputeUniformData(info->command_buffer, 0, &constants, sizeof(constants));
+    TRACE_SCOPE("graphics_trails_decimate") {
+        SDL_GPUComputePass *compute_pass = SDL_BeginGPUComputePass(info->command_buffer, NULL, 0, (SDL_GPUStorageBufferReadWriteBinding[]) {
+            { .buffer = gfx->trail_indices, .cycle = false },
+            { .buffer = gfx->trail_arguments, .cycle = false },
+        }, 2);
+
+        SDL_GPUBuffer *buffers[] = { trails->array.buffer, trails->anchors.buffer };
+        SDL_BindGPUComputePipeline(compute_pass, gfx->trail_decimate_pipelines[trails->compact]);
+        SDL_BindGPUComputeStorageBuffers(compute_pass, 0, buffers, SDL_arraysize(buffers));
+        SDL_DispatchGPUCompute(compute_pass, WORKGROUP_COUNT(trails->slot_count), 1, 1);
+        SDL_EndGPUComputePass(compute_pass);
+    }
+
+    return true;
 }
 
-static void graphics_trajectories_draw(const Graphics *gfx, const Trajectories *trajectories, SDL_GPURenderPass *render_pass) {
-    if (!trajectories->enabled) return;
-    SDL_BindGPUGraphicsPipeline(render_pass, gfx->trajectory_pipeline);
-    SDL_GPUBuffer *buffers[] = { trajectories->positions.buffer, gfx->colors.buffer };
+static void graphics_trails_draw(const Graphics *gfx, const GraphicsDrawInfo *info, SDL_GPURenderPass *render_pass) {
+    const Trails *trails = info->trails;
+    SDL_BindGPUGraphicsPipeline(render_pass, gfx->trail_pipelines[trails->compact]);
+    SDL_GPUBuffer *buffers[] = { trails->array.buffer, info->appearance->colors.buffer, gfx->trail_indices, trails->anchors.buffer, info->tracking->body_table.buffer };
     SDL_BindGPUVertexStorageBuffers(render_pass, 0, buffers, sizeof(buffers) / sizeof(SDL_GPUBuffer *));
+    SDL_DrawGPUPrimitivesIndirect(render_pass, gfx->trail_arguments, 0, trails->slot_count);
+}
+
+static void graphics_trajectories_draw(const Graphics *gfx, const GraphicsTrajectoriesDrawInfo *info) {
+    const Trajectories *trajectories = info->trajectories;
+    if (!trajectories->enabled || !trajectories->slot_count) return;
+    SDL_BindGPUGraphicsPipeline(info->render_pass, gfx->trajectory_pipelines[trajectories->compact]);
+    SDL_GPUBuffer *buffers[] = { trajectories->positions.buffer, info->appearance->colors.buffer, info->sim->positions.buffer, info->tracking->body_table.buffer };
+    SDL_BindGPUVertexStorageBuffers(info->render_pass, 0, buffers, sizeof(buffers) / sizeof(SDL_GPUBuffer *));
     SDL_DrawGPUPrimitives(
-        render_pass,
-        PREDICTION_LENGTH, trajectories->body_count,
+        info->render_pass,
+        trajectories->length, trajectories->slot_count,
         0, 0
     );
 }
 
-static void graphics_gui_draw(SDL_GPUCommandBuffer *command_buffer, SDL_GPUTexture *swapchain) {
-    ImDrawData *draw_data = ImGui_GetDrawData();
-    cImGui_ImplSDLGPU3_PrepareDrawData(draw_data, command_buffer);
-    SDL_GPURenderPass *render_pass = SDL_BeginGPURenderPass(command_buffer, &(SDL_GPUColorTargetInfo) {
-        .texture = swapchain,
-        .load_op =  SDL_GPU_LOADOP_LOAD,
-        .store_op = SDL_GPU_STOREOP_STORE
-    }, 1, NULL);
+// grows a field buffer, keeping the old one on failure
+static bool graphics_field_reserve(SDL_GPUDevice *gpu, SDL_GPUBuffer **buffer, u32 *capacity, const u32 count, const u32 element_size) {
+    if (*capacity >= count) return true;
+    const u32 grown = count + count / 2;
+    SDL_GPUBuffer *created = SDL_CreateGPUBuffer(gpu, &(SDL_GPUBufferCreateInfo) {
+        .size = grown * element_size,
+        .usage = SDL_GPU_BUFFERUSAGE_COMPUTE_STORAGE_READ | SDL_GPU_BUFFERUSAGE_COMPUTE_STORAGE_WRITE | SDL_GPU_BUFFERUSAGE_GRAPHICS_STORAGE_READ
+    });
 
-    cImGui_ImplSDLGPU3_RenderDrawData(draw_data, command_buffer, render_pass);
-    ImGui_UpdatePlatformWindows();
-    ImGui_RenderPlatformWindowsDefault();
-    SDL_EndGPURenderPass(render_pass);
+    if (!created) {
+        SDL_LogError(SDL_LOG_CATEGORY_GPU, "SDL_CreateGPUBuffer() in graphics_field_reserve(): %s\n", SDL_GetError());
+        return false;
+    }
+
+    SDL_ReleaseGPUBuffer(gpu, *buffer);
+    *buffer = created;
+    *capacity = grown;
+    return true;
+}
+
+// potential and acceleration over a grid a little larger than the view. it is re-evaluated only when the view leaves it,
+// the zoom drifts past FIELD_ZOOM_THRESHOLD or bodies change, which is decided here, or when any body moves more than
+// FIELD_MOVE_THRESHOLD samples, which the check stage decides on the GPU and skips the evaluation through an empty dispatch
+static bool graphics_field(Graphics *gfx, const GraphicsDrawInfo *info, const GraphicsViewport viewport) {
+    const Simulation *sim = info->sim;
+    const Camera *cam = info->cam;
+    if (!info->appearance->options.field || !sim->body_count || !viewport.width || !viewport.height) return false;
+
+    // arrows sit on world space multiples of their spacing, so panning doesn't make them shimmer
+    const f32 spacing = SDL_max(info->appearance->options.field_spacing, 8.0f) * cam->zoom;
+    const f32 cell = spacing / FIELD_SUBDIVISIONS;
+    const HMM_Vec2 half = HMM_V2(0.5f * (f32) viewport.width * cam->zoom, 0.5f * (f32) viewport.height * cam->zoom);
+    const HMM_Vec2 low = HMM_SubV2(cam->position, half), high = HMM_AddV2(cam->position, half);
+
+    const GraphicsFieldGrid *grid = &gfx->field_grid;
+    const HMM_Vec2 grid_high = HMM_V2(grid->origin.X + (f32) (grid->columns - 1) * grid->cell, grid->origin.Y + (f32) (grid->rows - 1) * grid->cell);
+    const bool covered = grid->columns && low.X >= grid->origin.X && low.Y >= grid->origin.Y && high.X <= grid_high.X && high.Y <= grid_high.Y;
+    const f32 zoom_ratio = grid->cell > 0.0f ? cell / grid->cell : 0.0f;
+    const bool force = !covered || zoom_ratio > FIELD_ZOOM_THRESHOLD || zoom_ratio < 1.0f / FIELD_ZOOM_THRESHOLD || gfx->field_revision != info->appearance->revision
+        || gfx->field_gravity != sim->options.gravity || gfx->field_softening != sim->options.softening;
+
+    GraphicsFieldGrid next = *grid;
+    if (force) {
+        // one arrow spacing of margin on every side
+        next.origin = HMM_V2(SDL_floorf(low.X / spacing - 1.0f) * spacing, SDL_floorf(low.Y / spacing - 1.0f) * spacing);
+        next.cell = cell;
+        next.columns = (u32) SDL_ceilf((high.X + spacing - next.origin.X) / spacing) * FIELD_SUBDIVISIONS + 1;
+        next.rows = (u32) SDL_ceilf((high.Y + spacing - next.origin.Y) / spacing) * FIELD_SUBDIVISIONS + 1;
+    }
+
+    const u32 samples = next.columns * next.rows;
+    if (!graphics_field_reserve(info->gpu, &gfx->field_samples, &gfx->field_sample_capacity, samples, 4 * sizeof(f32))) return false;
+    if (!graphics_field_reserve(info->gpu, &gfx->field_anchors, &gfx->field_anchor_capacity, sim->body_count, sizeof(HMM_Vec2))) return false;
+
+    const struct {
+        u32 body_count;
+        f32 threshold;
+        u32 force;
+        u32 group_count;
+        u32 parity;
+        u32 _padding[3];
+    } check = { sim->body_count, FIELD_MOVE_THRESHOLD * next.cell, force, WORKGROUP_COUNT(samples), gfx->field_parity, { 0 } };
+
+    const struct {
+        u32 body_count;
+        f32 G;
+        f32 ee;
+        u32 columns;
+        u32 rows;
+        f32 cell;
+        HMM_Vec2 origin;
+    } evaluate = { sim->body_count, sim->options.gravity, sim->options.softening, next.columns, next.rows, next.cell, next.origin };
+
+    TRACE_SCOPE("graphics_field") {
+        // every workgroup checks its own bodies, the flag they OR into is only complete once the pass ends
+        SDL_PushGPUComputeUniformData(info->command_buffer, 0, &check, sizeof(check));
+        SDL_GPUComputePass *compute_pass = SDL_BeginGPUComputePass(info->command_buffer, NULL, 0, &(SDL_GPUStorageBufferReadWriteBinding) { .buffer = gfx->field_arguments, .cycle = false }, 1);
+        SDL_GPUBuffer *check_buffers[] = { sim->positions.buffer, gfx->field_anchors };
+        SDL_BindGPUComputePipeline(compute_pass, gfx->field_pipelines[0]);
+        SDL_BindGPUComputeStorageBuffers(compute_pass, 0, check_buffers, SDL_arraysize(check_buffers));
+        SDL_DispatchGPUCompute(compute_pass, WORKGROUP_COUNT(sim->body_count), 1, 1);
+        SDL_EndGPUComputePass(compute_pass);
+
+        compute_pass = SDL_BeginGPUComputePass(info->command_buffer, NULL, 0, (SDL_GPUStorageBufferReadWriteBinding[]) {
+            { .buffer = gfx->field_anchors, .cycle = false },
+            { .buffer = gfx->field_range, .cycle = false },
+            { .buffer = gfx->field_arguments, .cycle = false },
+        }, 3);
+
+        SDL_BindGPUComputePipeline(compute_pass, gfx->field_pipelines[1]);
+        SDL_BindGPUComputeStorageBuffers(compute_pass, 0, &sim->positions.buffer, 1);
+        SDL_DispatchGPUCompute(compute_pass, WORKGROUP_COUNT(sim->body_count), 1, 1);
+        SDL_EndGPUComputePass(compute_pass);
+
+        SDL_PushGPUComputeUniformData(info->command_buffer, 0, &evaluate, sizeof(evaluate));
+        compute_pass = SDL_BeginGPUComputePass(info->command_buffer, NULL, 0, (SDL_GPUStorageBufferReadWriteBinding[]) {
+            { .buffer = gfx->field_samples, .cycle = false },
+            { .buffer = gfx->field_range, .cycle = false },
+        }, 2);
+
+        SDL_GPUBuffer *buffers[] = { sim->positions.buffer, sim->masses.buffer };
+        SDL_BindGPUComputePipeline(compute_pass, gfx->field_pipelines[2]);
+        SDL_BindGPUComputeStorageBuffers(compute_pass, 0, buffers, SDL_arraysize(buffers));
+        SDL_DispatchGPUComputeIndirect(compute_pass, gfx->field_arguments, 0);
+        SDL_EndGPUComputePass(compute_pass);
+    }
+
+    gfx->field_grid = next;
+    gfx->field_parity ^= 1;
+    gfx->field_gravity = sim->options.gravity;
+    gfx->field_softening = sim->options.softening;
+    gfx->field_revision = info->appearance->revision;
+    return true;
+}
+
+// the potential map under everything else, then the arrows
+static void graphics_field_draw(const Graphics *gfx, const GraphicsOptions *options, SDL_GPUCommandBuffer *command_buffer, SDL_GPURenderPass *render_pass) {
+    const GraphicsFieldGrid *grid = &gfx->field_grid;
+    const struct {
+        HMM_Vec2 origin;
+        f32 cell;
+        u32 columns;
+        u32 rows;
+        u32 stride;
+        f32 opacity;
+        u32 _padding;
+    } constants = { grid->origin, grid->cell, grid->columns, grid->rows, FIELD_SUBDIVISIONS, options->field_arrow_opacity, 0 };
+
+    const struct {
+        u32 columns;
+        u32 rows;
+        f32 opacity;
+        u32 _padding;
+    } map = { grid->columns, grid->rows, options->field_opacity, 0 };
+
+    SDL_GPUBuffer *buffers[] = { gfx->field_samples, gfx->field_range };
+    SDL_PushGPUVertexUniformData(command_buffer, 1, &constants, sizeof(constants));
+    if (options->field_opacity > 0.0f) {
+        SDL_BindGPUGraphicsPipeline(render_pass, gfx->field_map_pipeline);
+        SDL_PushGPUFragmentUniformData(command_buffer, 0, &map, sizeof(map));
+        SDL_BindGPUFragmentStorageBuffers(render_pass, 0, buffers, SDL_arraysize(buffers));
+        SDL_DrawGPUPrimitives(render_pass, 4, 1, 0, 0);
+    }
+
+    if (options->field_arrow_opacity > 0.0f) {
+        const u32 arrows = ((grid->columns - 1) / FIELD_SUBDIVISIONS + 1) * ((grid->rows - 1) / FIELD_SUBDIVISIONS + 1);
+        SDL_BindGPUGraphicsPipeline(render_pass, gfx->field_arrow_pipeline);
+        SDL_BindGPUVertexStorageBuffers(render_pass, 0, buffers, SDL_arraysize(buffers));
+        SDL_DrawGPUPrimitives(render_pass, 6, arrows, 0, 0);
+    }
 }
 
 void graphics_free(const Graphics *gfx, SDL_GPUDevice *gpu) {
     SDL_ReleaseGPUGraphicsPipeline(gpu, gfx->body_pipeline);
-    SDL_ReleaseGPUGraphicsPipeline(gpu, gfx->trail_pipeline);
-    SDL_ReleaseGPUGraphicsPipeline(gpu, gfx->trajectory_pipeline);
     SDL_ReleaseGPUGraphicsPipeline(gpu, gfx->ghost_body_pipeline);
-    SDL_ReleaseGPUGraphicsPipeline(gpu, gfx->ghost_trajectory_pipeline);
-    SDL_ReleaseGPUBuffer(gpu, gfx->colors.buffer);
+    for (u32 c = 0; c < 2; c++) {
+        SDL_ReleaseGPUGraphicsPipeline(gpu, gfx->trail_pipelines[c]);
+        SDL_ReleaseGPUGraphicsPipeline(gpu, gfx->trajectory_pipelines[c]);
+        SDL_ReleaseGPUGraphicsPipeline(gpu, gfx->ghost_trajectory_pipelines[c]);
+        SDL_ReleaseGPUComputePipeline(gpu, gfx->trail_decimate_pipelines[c]);
+    }
+    for (u32 i = 0; i < SDL_arraysize(gfx->cull_pipelines); i++) SDL_ReleaseGPUComputePipeline(gpu, gfx->cull_pipelines[i]);
+    SDL_ReleaseGPUBuffer(gpu, gfx->cull_groups);
+    SDL_ReleaseGPUBuffer(gpu, gfx->visible);
+    SDL_ReleaseGPUBuffer(gpu, gfx->draw_arguments);
+    SDL_ReleaseGPUGraphicsPipeline(gpu, gfx->splat_pipeline);
+    for (u32 i = 0; i < SDL_arraysize(gfx->splat_pipelines); i++) SDL_ReleaseGPUComputePipeline(gpu, gfx->splat_pipelines[i]);
+    SDL_ReleaseGPUBuffer(gpu, gfx->splat_density);
+    SDL_ReleaseGPUBuffer(gpu, gfx->trail_indices);
+    SDL_ReleaseGPUBuffer(gpu, gfx->trail_arguments);
+    SDL_ReleaseGPUComputePipeline(gpu, gfx->render_data_pipeline);
+    SDL_ReleaseGPUBuffer(gpu, gfx->render_data);
+    for (u32 i = 0; i < SDL_arraysize(gfx->field_pipelines); i++) SDL_ReleaseGPUComputePipeline(gpu, gfx->field_pipelines[i]);
+    SDL_ReleaseGPUGraphicsPipeline(gpu, gfx->field_map_pipeline);
+    SDL_ReleaseGPUGraphicsPipeline(gpu, gfx->field_arrow_pipeline);
+    SDL_ReleaseGPUBuffer(gpu, gfx->field_samples);
+    SDL_ReleaseGPUBuffer(gpu, gfx->field_anchors);
+    SDL_ReleaseGPUBuffer(gpu, gfx->field_range);
+    SDL_ReleaseGPUBuffer(gpu, gfx->field_arguments);
 }
 
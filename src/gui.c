@@ -1,10 +1,16 @@
 #include "gui.h"
+#include "constants.h"
 #include "simulation.h"
 #include "camera.h"
 #include "ghost.h"
 #include "trajectories.h"
-#include "graphics.h"
+#include "appearance.h"
+#include "recorder.h"
+#include "replay.h"
+#include "history.h"
+#include "diagnostics.h"
 
+#include <float.h>
 #include "stb_ds.h"
 #include "backends/dcimgui_impl_sdl3.h"
 #include "backends/dcimgui_impl_sdlgpu3.h"
@@ -37,7 +43,12 @@ void gui_init(Gui *gui, SDL_Window *window, SDL_GPUDevice *gpu) {
 static void HelpMarker(const char *desc);
 static void gui_create_body(Ghost *ghost);
 // static void gui_inspector(const Simulation *sim, Graphics *gfx, Camera *cam);
+static void gui_generators(ApplicationOptions *app);
 static void gui_controls(ApplicationOptions *app, SimulationOptions *sim, Trajectories *trajectories, GraphicsOptions *gfx);
+static void gui_tracking(ApplicationOptions *app, const Tracking *tracking, const Camera *cam);
+static void gui_snapshots(ApplicationOptions *app, const Recorder *rec, const Exporter *exp, Replay *replay, SimulationOptions *sim);
+static void gui_history(ApplicationOptions *app, History *history, const Simulation *sim);
+static void gui_diagnostics(Diagnostics *diag);
 void gui_update(const GuiUpdateInfo *info) {
     cImGui_ImplSDLGPU3_NewFrame();
     cImGui_ImplSDL3_NewFrame();
@@ -45,8 +56,13 @@ void gui_update(const GuiUpdateInfo *info) {
     ImGui_Begin("N-Body Simulator", NULL, ImGuiWindowFlags_AlwaysAutoResize);
 
     gui_create_body(info->ghost);
+    gui_generators(info->app);
     // gui_inspector(info->sim, info->gfx, info->cam);
-    gui_controls(info->app, &info->sim->options, info->trajectories, &info->gfx->options);
+    gui_controls(info->app, &info->sim->options, info->trajectories, &info->appearance->options);
+    gui_tracking(info->app, info->tracking, info->cam);
+    gui_snapshots(info->app, info->rec, info->exporter, info->replay, &info->sim->options);
+    gui_history(info->app, info->history, info->sim);
+    gui_diagnostics(info->diag);
 
     ImGui_End();
     ImGui_Render();
@@ -102,6 +118,41 @@ static void gui_create_body(Ghost *ghost) {
 //     }
 //
 // }
+static void gui_generators(ApplicationOptions *app) {
+    if (ImGui_CollapsingHeader("Generate Bodies", 0)) {
+        GeneratorOptions *generator = &app->generator;
+        ImGui_ComboChar("Distribution", (i32 *) &generator->type, GENERATOR_NAMES, GENERATOR_TYPE_COUNT);
+        ImGui_InputInt("Bodies", (i32 *) &generator->count);
+        generator->count = SDL_clamp((i32) generator->count, 1, 1 << 24);
+        ImGui_InputScalar("Seed", ImGuiDataType_U64, &generator->seed);
+        HelpMarker("The same seed always generates the same bodies.");
+        ImGui_DragFloat("Total Mass", &generator->mass);
+        ImGui_DragFloat("Radius", &generator->radius);
+        HelpMarker("Plummer radius, disk scale length, or the outer radius of the binaries and rings.");
+        ImGui_DragFloat("Center X", &generator->center.X);
+        ImGui_DragFloat("Center Y", &generator->center.Y);
+
+        ImGui_BeginDisabled(generator->type != GENERATOR_DISK && generator->type != GENERATOR_RINGS);
+        ImGui_DragFloat("Central Mass", &generator->central_mass);
+        HelpMarker("A static body in the middle, 0 for none.");
+        ImGui_EndDisabled();
+        ImGui_BeginDisabled(generator->type != GENERATOR_RINGS);
+        ImGui_SliderIntEx("Rings", (i32 *) &generator->rings, 1, 64, "%d", ImGuiSliderFlags_AlwaysClamp);
+        ImGui_EndDisabled();
+
+        if (ImGui_Button("Generate")) app->generate = true;
+
+        ImGui_SeparatorText("Import");
+        ImGui_InputText("CSV File", app->import_path, sizeof(app->import_path), 0);
+        HelpMarker("One body per line: x, y, vx, vy, mass, r, g, b, movable. Everything after vy is optional.");
+        if (ImGui_Button("Import")) app->import_bodies = true;
+
+        ImGui_Separator();
+        ImGui_Checkbox("Replace Bodies", &app->replace_bodies);
+        HelpMarker("Remove every existing body before generating or importing.");
+    }
+}
+
 static void gui_controls(ApplicationOptions *app, SimulationOptions *sim, Trajectories *trajectories, GraphicsOptions *gfx) {
     if (ImGui_CollapsingHeader("Controls and Options", ImGuiTreeNodeFlags_DefaultOpen)) {
         ImGui_SeparatorText("Controls");
@@ -110,6 +161,15 @@ static void gui_controls(ApplicationOptions *app, SimulationOptions *sim, Trajec
 
         ImGui_SeparatorText("Simulation Options");
         ImGui_DragFloat("Time Step", &app->fixed_delta_time);
+        const char *rates[] = { "Real Time", "Steps per Frame", "Uncapped" };
+        ImGui_ComboChar("Simulation Rate", (i32 *) &app->simulation_rate, rates, IM_COUNTOF(rates));
+        HelpMarker("Real Time keeps pace with the clock, Steps per Frame simulates a fixed number of steps for every frame drawn, and Uncapped simulates as many steps as it can while still drawing at the render rate.");
+        if (app->simulation_rate == RATE_REAL_TIME) ImGui_SliderFloatEx("Time Scale", &app->time_scale, 0.125f, 64.0f, "%.3fx", ImGuiSliderFlags_Logarithmic);
+        if (app->simulation_rate == RATE_STEPS_PER_FRAME) ImGui_SliderIntEx("Steps per Frame", (i32 *) &app->steps_per_frame, 1, 1024, "%d", ImGuiSliderFlags_AlwaysClamp | ImGuiSliderFlags_Logarithmic);
+        if (app->simulation_rate == RATE_UNCAPPED) ImGui_SliderFloatEx("Render Rate", &app->render_rate, 1.0f, 240.0f, "%.0f Hz", ImGuiSliderFlags_AlwaysClamp);
+        const char *present_modes[] = { "VSync", "Immediate", "Mailbox" }; // SDL_GPUPresentMode order
+        ImGui_ComboChar("Present Mode", (i32 *) &app->present_mode, present_modes, IM_COUNTOF(present_modes));
+        HelpMarker("VSync waits for the display, Immediate presents right away and may tear, Mailbox replaces queued frames without tearing. Falls back to VSync where unsupported.");
         ImGui_DragFloat("Gravity Coefficient", &sim->gravity);
         HelpMarker("Strength of the gravitational force between two bodies.");
         ImGui_DragFloat("Softening Coefficient", &sim->softening);
@@ -124,6 +184,8 @@ static void gui_controls(ApplicationOptions *app, SimulationOptions *sim, Trajec
 
         ImGui_Checkbox("Predict Body Motion", &trajectories->enabled);
         HelpMarker("Simulate planets into the future and draw their trajectories (expensive compute!)");
+        ImGui_SliderIntEx("Prediction Length", (i32 *) &app->prediction_length, 1, PREDICTION_LENGTH_MAX, "%d", ImGuiSliderFlags_AlwaysClamp);
+        HelpMarker("How many time steps into the future to predict each body. Compute and memory grow with the number of bodies times this length.");
 
         ImGui_SeparatorText("Drawing Options");
         ImGui_ColorEdit3("Space Color", (f32 *) &gfx->clear_color, 0);
@@ -133,6 +195,102 @@ static void gui_controls(ApplicationOptions *app, SimulationOptions *sim, Trajec
         HelpMarker("The thickness of the outline around non-movable bodies.");
         ImGui_SliderFloat("Trail brightness", &gfx->trail_brightness, 0.0f, 1.0f);
         HelpMarker("The brightness of the trail that each body leaves behind as it moves.");
+        ImGui_SliderFloat("Trail Tolerance", &gfx->trail_tolerance, 0.0f, 4.0f);
+        HelpMarker("How many pixels a trail may stray from the simplified line it is drawn as. Higher values draw fewer line segments.");
+        ImGui_SliderFloat("Splat Radius", &gfx->splat_radius, 0.0f, 4.0f);
+        HelpMarker("Bodies smaller than this many pixels are accumulated into a density image instead of drawn as circles, which keeps huge zoomed out scenes fast. 0 draws every body as a circle.");
+        ImGui_SliderFloat("Splat Exposure", &gfx->splat_exposure, 0.1f, 16.0f);
+        HelpMarker("How quickly overlapping splatted bodies saturate to full brightness.");
+        ImGui_Checkbox("Gravitational Field", &gfx->field);
+        HelpMarker("Draw the gravitational potential under the bodies and arrows along the acceleration a test mass would feel. The field is only re-evaluated when the view or the bodies change noticeably (expensive compute!)");
+        ImGui_SliderFloat("Field Arrow Spacing", &gfx->field_spacing, 20.0f, 400.0f);
+        HelpMarker("How many pixels apart the field arrows are. The potential is sampled a few times between arrows.");
+        ImGui_SliderFloat("Field Potential Opacity", &gfx->field_opacity, 0.0f, 1.0f);
+        HelpMarker("The opacity of the potential map, 0 hides it.");
+        ImGui_SliderFloat("Field Arrow Opacity", &gfx->field_arrow_opacity, 0.0f, 1.0f);
+        HelpMarker("The opacity of the field arrows, 0 hides them.");
+        ImGui_SliderIntEx("Trail Length", (i32 *) &app->trail_length, 1, TRAIL_LENGTH_MAX, "%d", ImGuiSliderFlags_AlwaysClamp);
+        HelpMarker("How many time steps of history each trail keeps. Changing it restarts every trail.");
+        ImGui_Checkbox("Compact Trails and Predictions", &app->compact_history);
+        HelpMarker("Store trail and prediction points as half precision offsets, which halves their memory at a small cost in precision when zoomed far in. Changing it restarts every trail, and snapshots skip compact trails.");
+    }
+}
+
+static void gui_tracking(ApplicationOptions *app, const Tracking *tracking, const Camera *cam) {
+    if (ImGui_CollapsingHeader("Trails and Predictions", 0)) {
+        ImGui_ComboChar("Tracked Bodies", (i32 *) &app->tracking_mode, TRACKING_MODE_NAMES, TRACKING_MODE_COUNT);
+        HelpMarker("Which bodies keep a trail and a prediction. Tracking only a few selected bodies saves most of the memory and drawing in large scenes, every body is still simulated for the predictions.");
+        ImGui_Text("%u of %u bodies tracked", tracking_slot_count(tracking), tracking->body_count);
+
+        const bool followed = cam->target < tracking->body_count;
+        ImGui_BeginDisabled(!followed || tracking->mode != TRACKING_SELECTED);
+        if (ImGui_Button(followed && tracking_slot(tracking, cam->target) != TRACKING_NONE ? "Untrack Followed Body" : "Track Followed Body")) app->toggle_tracked = true;
+        ImGui_EndDisabled();
+        HelpMarker("Adds or removes the body the camera follows, in Selected Bodies mode.");
+
+        ImGui_SliderIntEx("Heaviest Bodies", (i32 *) &app->heaviest_count, 1, 256, "%d", ImGuiSliderFlags_AlwaysClamp);
+        if (ImGui_Button("Track Heaviest")) app->track_heaviest = true;
+        HelpMarker("Switches to Selected Bodies and tracks only the heaviest bodies.");
+    }
+}
+
+static void gui_snapshots(ApplicationOptions *app, const Recorder *rec, const Exporter *exp, Replay *replay, SimulationOptions *sim) {
+    if (ImGui_CollapsingHeader("Save and Load", 0)) {
+        ImGui_InputText("Snapshot File", app->snapshot_path, sizeof(app->snapshot_path), 0);
+        HelpMarker("Snapshots store every body along with the simulation, drawing and camera options.");
+        if (ImGui_Button("Save Snapshot")) app->save_snapshot = true;
+        ImGui_SameLine();
+        ImGui_BeginDisabled(replay->open);
+        if (ImGui_Button("Load Snapshot")) app->load_snapshot = true;
+        ImGui_EndDisabled();
+
+        ImGui_SeparatorText("Recording");
+        ImGui_BeginDisabled(rec->recording);
+        ImGui_InputText("Recording File", app->recording_path, sizeof(app->recording_path), 0);
+        ImGui_SliderIntEx("Record Interval", (i32 *) &app->record_interval, 1, 100, "%d", ImGuiSliderFlags_AlwaysClamp);
+        HelpMarker("Simulation steps between recorded frames.");
+        ImGui_SliderIntEx("Keyframe Interval", (i32 *) &app->keyframe_interval, 1, 1024, "%d", ImGuiSliderFlags_AlwaysClamp);
+        HelpMarker("Recorded frames between keyframes. Every frame stores positions, keyframes store velocities as well.");
+        ImGui_EndDisabled();
+        if (ImGui_Button(rec->recording ? "Stop Recording" : "Start Recording")) app->toggle_recording = true;
+        if (rec->recording) {
+            ImGui_SameLine();
+            ImGui_Text("%llu frames, %llu dropped", (unsigned long long) rec->frames, (unsigned long long) rec->dropped);
+        }
+
+        ImGui_SeparatorText("Image Export");
+        ImGui_BeginDisabled(exp->exporting);
+        ImGui_ComboChar("Export Format", (i32 *) &app->export_format, EXPORT_FORMAT_NAMES, EXPORT_FORMAT_COUNT);
+        ImGui_InputText("Export Path", app->export_path, sizeof(app->export_path), 0);
+        HelpMarker("PPM sequences number their frames after this prefix, raw video is a single rgb24 file for ffmpeg's rawvideo input.");
+        ImGui_InputInt("Export Width", (i32 *) &app->export_width);
+        ImGui_InputInt("Export Height", (i32 *) &app->export_height);
+        ImGui_SliderIntEx("Export Interval", (i32 *) &app->export_interval, 1, 100, "%d", ImGuiSliderFlags_AlwaysClamp);
+        HelpMarker("Simulation steps between exported frames, so the output doesn't depend on the frame rate.");
+        ImGui_EndDisabled();
+        if (ImGui_Button(exp->exporting ? "Stop Export" : "Start Export")) app->toggle_export = true;
+        if (exp->exporting) {
+            ImGui_SameLine();
+            ImGui_Text("%llu frames, %llu dropped", (unsigned long long) exp->frames, (unsigned long long) exp->dropped);
+        }
+
+        ImGui_SeparatorText("Replay");
+        ImGui_BeginDisabled(replay->open);
+        ImGui_InputText("Replay File", app->replay_path, sizeof(app->replay_path), 0);
+        ImGui_EndDisabled();
+        if (ImGui_Button(replay->open ? "Close Replay" : "Open Replay")) app->toggle_replay = true;
+        HelpMarker("Plays a recording back instead of simulating. Closing it carries on simulating from the last keyframe.");
+        if (replay->open && replay->header.frame_count) {
+            ImGui_SameLine();
+            if (ImGui_Button(sim->paused ? "Play" : "Pause")) sim->paused = !sim->paused;
+            ImGui_SliderFloatEx("Speed", &replay->speed, 0.125f, 64.0f, "%.3fx", ImGuiSliderFlags_Logarithmic);
+
+            i32 frame = (i32) replay->position;
+            if (ImGui_SliderInt("Frame", &frame, 0, (i32) replay->header.frame_count - 1)) {
+                replay->position = frame;
+                replay->seek = true;
+            }
+        }
     }
 }
 
@@ -147,6 +305,22 @@ static void HelpMarker(const char *desc) {
     }
 }
 
+// over the scene graphics_draw left in the swapchain, exported frames never get it
+void gui_draw(SDL_GPUCommandBuffer *command_buffer, SDL_GPUTexture *swapchain) {
+    ImDrawData *draw_data = ImGui_GetDrawData();
+    cImGui_ImplSDLGPU3_PrepareDrawData(draw_data, command_buffer);
+    SDL_GPURenderPass *render_pass = SDL_BeginGPURenderPass(command_buffer, &(SDL_GPUColorTargetInfo) {
+        .texture = swapchain,
+        .load_op =  SDL_GPU_LOADOP_LOAD,
+        .store_op = SDL_GPU_STOREOP_STORE
+    }, 1, NULL);
+
+    cImGui_ImplSDLGPU3_RenderDrawData(draw_data, command_buffer, render_pass);
+    ImGui_UpdatePlatformWindows();
+    ImGui_RenderPlatformWindowsDefault();
+    SDL_EndGPURenderPass(render_pass);
+}
+
 void gui_event(const SDL_Event *event) {
     cImGui_ImplSDL3_ProcessEvent(event);
 }
@@ -156,3 +330,55 @@ void gui_free(void) {
     cImGui_ImplSDLGPU3_Shutdown();
     ImGui_DestroyContext(NULL);
 }
+
+static void gui_history(ApplicationOptions *app, History *history, const Simulation *sim) {
+    if (ImGui_CollapsingHeader("History", 0)) {
+        ImGui_Checkbox("Keep History", &history->enabled);
+        HelpMarker("Keeps the last few states on the GPU so the simulation can be scrubbed back.");
+        if (ImGui_SliderIntEx("History Interval", (i32 *) &history->interval, 1, 1000, "%d", ImGuiSliderFlags_AlwaysClamp)) history_clear(history);
+        HelpMarker("Simulation steps between kept states. Rewinding between two of them integrates forward from the older one.");
+
+        const u64 reach = history->count ? sim->step - history_oldest_step(history) : 0;
+        const u32 length = history->buffer ? history->length : history_length(sim->body_count);
+        if (length) ImGui_Text("%u of %u states, up to %llu steps back", history->count, length, (unsigned long long) reach);
+        else ImGui_Text("Too many bodies to keep history");
+        ImGui_BeginDisabled(history->count == 0);
+        app->rewind_steps = (u32) SDL_min(app->rewind_steps, reach);
+        ImGui_SliderIntEx("Rewind Steps", (i32 *) &app->rewind_steps, 0, (i32) SDL_min(reach, (u64) INT32_MAX), "%d", ImGuiSliderFlags_AlwaysClamp);
+        if (ImGui_Button("Rewind")) app->rewind = true;
+        ImGui_EndDisabled();
+    }
+}
+
+static void gui_diagnostics(Diagnostics *diag) {
+    if (ImGui_CollapsingHeader("Diagnostics", 0)) {
+        ImGui_Checkbox("Track Conservation", &diag->enabled);
+        HelpMarker("Sums up energy, momentum and angular momentum on the GPU. Drift shows how well the integrator and time step hold up.");
+        ImGui_SliderIntEx("Diagnostics Interval", (i32 *) &diag->interval, 1, 1000, "%d", ImGuiSliderFlags_AlwaysClamp);
+        HelpMarker("Simulation steps between samples. Each sample costs about as much as one Euler step.");
+        if (ImGui_Button("Reset Baseline")) diagnostics_reset(diag);
+        HelpMarker("Drift is measured from the first sample after a reset. Changing the body count resets it as well.");
+        if (!diag->has_baseline) return;
+
+        const DiagnosticsSample *latest = &diag->latest;
+        ImGui_Text("Step %llu, %u bodies", (unsigned long long) latest->step, latest->body_count);
+        ImGui_Text("Kinetic %.6g, Potential %.6g", latest->kinetic, latest->potential);
+        ImGui_Text("Energy %.6g", latest->energy);
+        ImGui_Text("Momentum (%.4g, %.4g)", latest->momentum.X, latest->momentum.Y);
+        ImGui_Text("Angular Momentum %.6g", latest->angular_momentum);
+        ImGui_Text("Center of Mass (%.4g, %.4g)", latest->center_of_mass.X, latest->center_of_mass.Y);
+
+        // the rings are plotted oldest first
+        const i32 offset = (i32) ((diag->head + DIAGNOSTICS_HISTORY - diag->count) % DIAGNOSTICS_HISTORY);
+        const i32 count = (i32) diag->count;
+        const ImVec2 size = { 0.0f, 60.0f };
+        char overlay[64];
+        SDL_snprintf(overlay, sizeof(overlay), "%.3e", diag->energy_drift[(diag->head + DIAGNOSTICS_HISTORY - 1) % DIAGNOSTICS_HISTORY]);
+        ImGui_PlotLinesEx("Energy Drift", diag->energy_drift, count, offset, overlay, FLT_MAX, FLT_MAX, size, sizeof(f32));
+        HelpMarker("(E - E0) / |E0| relative to the baseline.");
+        ImGui_PlotLinesEx("Momentum Drift", diag->momentum_drift, count, offset, NULL, FLT_MAX, FLT_MAX, size, sizeof(f32));
+        HelpMarker("|p - p0|, only conserved without static bodies.");
+        ImGui_PlotLinesEx("Angular Drift", diag->angular_momentum_drift, count, offset, NULL, FLT_MAX, FLT_MAX, size, sizeof(f32));
+        HelpMarker("L - L0 around the origin, only conserved without static bodies.");
+    }
+}
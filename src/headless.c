@@ -0,0 +1,401 @@
+#include "constants.h"
+#include "simulation.h"
+#include "trails.h"
+#include "tracking.h"
+#include "camera.h"
+#include "ghost.h"
+#include "trajectories.h"
+#include "appearance.h"
+#include "graphics.h"
+#include "snapshot.h"
+#include "recorder.h"
+#include "exporter.h"
+#include "diagnostics.h"
+#include "bodies.h"
+#include "importer.h"
+#include "checkpoint.h"
+#include "tracer.h"
+
+#include "SDL3/SDL_init.h"
+#include "SDL3/SDL_filesystem.h"
+#include "SDL3/SDL_gpu.h"
+#include "SDL3/SDL_timer.h"
+#include "sdl_utils.h"
+#include "types.h"
+
+// steps a snapshot or body table as fast as the GPU allows and writes the result, with no window, swapchain or gui.
+// graphics pipelines are only built when exporting frames. run it from the build directory, shaders load from ./shaders
+typedef struct {
+    u64 steps;
+    f32 delta_time;
+    const char *input;
+    const char *output;
+    const char *record;
+    u32 record_interval;
+    const char *checkpoint_path;
+    u64 checkpoint_interval;
+    bool resume;
+    u32 diagnostics_interval; // 0 to skip them
+    const char *export_path; // NULL to draw nothing
+    ExportFormat export_format;
+    u32 export_width;
+    u32 export_height;
+    u32 export_interval;
+} HeadlessOptions;
+
+typedef struct {
+    HeadlessOptions options;
+    SDL_GPUDevice *gpu;
+    u64 completed;
+    u64 resumed; // steps already done by the run a checkpoint came from
+    u64 start_tick;
+    u32 trail_length;
+    SDL_GPUFence *fence;
+
+    Simulation sim;
+    Trails trails;
+    Tracking tracking;
+    Camera cam;
+    Appearance appearance;
+    Graphics gfx; // only with `export_path`
+    Recorder rec;
+    Exporter exporter;
+    Diagnostics diag;
+    Checkpoint checkpoint;
+} Headless;
+
+static bool headless_arguments(HeadlessOptions *options, const int argc, char **argv) {
+    for (i32 i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        const char *value = i + 1 < argc ? argv[i + 1] : NULL;
+
+        if (SDL_strcmp(arg, "--steps") == 0 && value) {
+            options->steps = SDL_strtoull(value, NULL, 10);
+            i++;
+        } else if (SDL_strcmp(arg, "--dt") == 0 && value) {
+            options->delta_time = (f32) SDL_atof(value);
+            i++;
+        } else if (SDL_strcmp(arg, "--input") == 0 && value) {
+            options->input = value;
+            i++;
+        } else if (SDL_strcmp(arg, "--output") == 0 && value) {
+            options->output = value;
+            i++;
+        } else if (SDL_strcmp(arg, "--record") == 0 && value) {
+            options->record = value;
+            i++;
+        } else if (SDL_strcmp(arg, "--record-interval") == 0 && value) {
+            options->record_interval = (u32) SDL_strtoul(value, NULL, 10);
+            i++;
+        } else if (SDL_strcmp(arg, "--checkpoint") == 0 && value) {
+            options->checkpoint_path = value;
+            i++;
+        } else if (SDL_strcmp(arg, "--checkpoint-interval") == 0 && value) {
+            options->checkpoint_interval = SDL_strtoull(value, NULL, 10);
+            i++;
+        } else if (SDL_strcmp(arg, "--resume") == 0) {
+            options->resume = true;
+        } else if (SDL_strcmp(arg, "--diagnostics") == 0 && value) {
+            options->diagnostics_interval = (u32) SDL_strtoul(value, NULL, 10);
+            i++;
+        } else if (SDL_strcmp(arg, "--export") == 0 && value) {
+            options->export_path = value;
+            i++;
+        } else if (SDL_strcmp(arg, "--export-format") == 0 && value) {
+            options->export_format = SDL_strcmp(value, "raw") == 0 ? EXPORT_RAW : EXPORT_PPM;
+            i++;
+        } else if (SDL_strcmp(arg, "--export-size") == 0 && value) {
+            if (SDL_sscanf(value, "%ux%u", &options->export_width, &options->export_height) != 2) {
+                SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "headless_arguments() in main(): --export-size expects <width>x<height>.\n");
+                return false;
+            }
+            i++;
+        } else if (SDL_strcmp(arg, "--export-interval") == 0 && value) {
+            options->export_interval = (u32) SDL_strtoul(value, NULL, 10);
+            i++;
+        } else {
+            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION,
+                "headless_arguments() in main(): Unknown argument %s.\n"
+                "usage: nbody_headless --input <snapshot> --output <snapshot> --steps <n> [--dt <seconds>] [--record <file> [--record-interval <steps>]] [--checkpoint <file> [--checkpoint-interval <steps>] [--resume]] [--diagnostics <steps>] [--export <path> [--export-format ppm|raw] [--export-size <w>x<h>] [--export-interval <steps>]]\n", arg);
+            return false;
+        }
+    }
+
+    if (!options->input || !options->output) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "headless_arguments() in main(): --input and --output are required.\n");
+        return false;
+    }
+
+    if (!options->steps) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "headless_arguments() in main(): --steps must be positive.\n");
+        return false;
+    }
+
+    if (options->resume && !options->checkpoint_path) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "headless_arguments() in main(): --resume needs --checkpoint.\n");
+        return false;
+    }
+
+    // recorder_start() truncates the file, which would throw away everything recorded before the crash
+    if (options->resume && options->record) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "headless_arguments() in main(): --resume can't be combined with --record.\n");
+        return false;
+    }
+
+    if (options->delta_time <= 0.0f) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "headless_arguments() in main(): --dt must be positive.\n");
+        return false;
+    }
+
+    return true;
+}
+
+static SnapshotInfo headless_snapshot_info(Headless *headless) {
+    return (SnapshotInfo) {
+        .gpu = headless->gpu,
+        .sim = &headless->sim,
+        .appearance = &headless->appearance,
+        .trails = &headless->trails,
+        .trajectories = NULL,
+        .tracking = &headless->tracking,
+        .cam = &headless->cam,
+    };
+}
+
+static void headless_add_bodies(Headless *headless, const BodyTable *bodies) {
+    SDL_GPUCommandBuffer *command_buffer = SDL_AcquireGPUCommandBuffer(headless->gpu);
+    SDL_GPUCopyPass *copy_pass = SDL_BeginGPUCopyPass(command_buffer);
+    simulation_add_bodies(&headless->sim, headless->gpu, copy_pass, bodies);
+    trails_add_slots(&headless->trails, headless->gpu, copy_pass, tracking_add_bodies(&headless->tracking, bodies->count));
+    tracking_upload(&headless->tracking, headless->gpu, copy_pass);
+    appearance_add_bodies(&headless->appearance, headless->gpu, copy_pass, bodies->colors, bodies->count);
+    SDL_EndGPUCopyPass(copy_pass);
+    SDL_SubmitGPUCommandBuffer(command_buffer);
+}
+
+// just the compute modules the snapshot touches
+static SDL_AppResult headless_init(Headless *headless) {
+    const HeadlessOptions *options = &headless->options;
+    if (!SDL_Init(0)) panic("Failed to initialize SDL3!");
+    SDL_SetLogPriority(SDL_LOG_CATEGORY_GPU, SDL_LOG_PRIORITY_VERBOSE);
+    SDL_SetLogPriority(SDL_LOG_CATEGORY_APPLICATION, SDL_LOG_PRIORITY_VERBOSE);
+    SDL_SetLogPriority(SDL_LOG_CATEGORY_ERROR, SDL_LOG_PRIORITY_VERBOSE);
+
+    headless->gpu = SDL_CreateGPUDevice(SDL_GPU_SHADERFORMAT_SPIRV | SDL_GPU_SHADERFORMAT_MSL, true, NULL);
+    if (!headless->gpu) panic("Failed to create GPU device!");
+
+    recorder_init(&headless->rec);
+    exporter_init(&headless->exporter);
+    if (simulation_init(&headless->sim, headless->gpu) != 0) panic("Failed to initialize simulation!");
+    if (trails_init(&headless->trails, headless->gpu) != 0) panic("Failed to initialize trail module!");
+    if (tracking_init(&headless->tracking, headless->gpu) != 0) panic("Failed to initialize tracking!");
+    if (diagnostics_init(&headless->diag, headless->gpu) != 0) panic("Failed to initialize diagnostics!");
+    if (appearance_init(&headless->appearance, headless->gpu) != 0) panic("Failed to initialize appearance!");
+    if (options->export_path && graphics_init(&headless->gfx, headless->gpu, NULL) != 0) panic("Failed to initialize graphics!");
+    camera_init(&headless->cam);
+
+    // a .csv body table instead of a snapshot starts from the default options
+    const SnapshotInfo info = headless_snapshot_info(headless);
+    const char *extension = SDL_strrchr(options->input, '.');
+    const bool csv = extension && SDL_strcasecmp(extension, ".csv") == 0;
+
+    // --steps counts from the input's step, so a resumed run stops exactly where the original one would have
+    SnapshotHeader input_header = { 0 };
+    if (!csv && !snapshot_peek(options->input, &input_header)) return SDL_APP_FAILURE;
+    const bool resume = options->resume && SDL_GetPathInfo(options->checkpoint_path, NULL);
+
+    headless->trail_length = TRAIL_LENGTH_DEFAULT;
+    if (resume) {
+        if (!snapshot_load(options->checkpoint_path, &info)) return SDL_APP_FAILURE;
+        headless->trail_length = headless->trails.length;
+        SDL_Log("Headless: Resuming from %s at step %" SDL_PRIu64 ".\n", options->checkpoint_path, headless->sim.step);
+    } else if (csv) {
+        BodyTable bodies;
+        if (!import_csv(options->input, &bodies)) return SDL_APP_FAILURE;
+        headless_add_bodies(headless, &bodies);
+        body_table_free(&bodies);
+    } else if (!snapshot_load(options->input, &info)) return SDL_APP_FAILURE;
+    else headless->trail_length = headless->trails.length;
+
+    headless->completed = headless->sim.step - input_header.step;
+    headless->resumed = headless->completed;
+    if (options->checkpoint_path) checkpoint_init(&headless->checkpoint, options->checkpoint_path, options->checkpoint_interval, headless->sim.step);
+    headless->sim.options.paused = false;
+    headless->diag.enabled = options->diagnostics_interval != 0;
+    headless->diag.interval = SDL_max(options->diagnostics_interval, 1);
+
+    if (options->record && !recorder_start(&headless->rec, &(RecorderStartInfo) {
+        .path = options->record,
+        .interval = options->record_interval,
+        .keyframe_interval = RECORD_KEYFRAME_INTERVAL_DEFAULT,
+        .delta_time = options->delta_time,
+        .snapshot = &info,
+    })) return SDL_APP_FAILURE;
+
+    if (options->export_path && !exporter_start(&headless->exporter, headless->gpu, &(ExporterStartInfo) {
+        .path = options->export_path,
+        .format = options->export_format,
+        .width = options->export_width,
+        .height = options->export_height,
+        .interval = options->export_interval,
+        .texture_format = headless->gfx.format,
+        .step = headless->sim.step,
+    })) return SDL_APP_FAILURE;
+
+    headless->start_tick = SDL_GetTicksNS();
+    SDL_Log("Headless: %u bodies, %" SDL_PRIu64 " steps of %g s.\n", headless->sim.body_count, options->steps, options->delta_time);
+    return SDL_APP_CONTINUE;
+}
+
+static SDL_GPUComputePass *headless_compute_pass(const Headless *headless, SDL_GPUCommandBuffer *command_buffer) {
+    return SDL_BeginGPUComputePass(command_buffer, NULL, 0, (SDL_GPUStorageBufferReadWriteBinding[]) {
+        { .buffer = headless->sim.positions.buffer, .cycle = false },
+        { .buffer = headless->sim.velocities.buffer, .cycle = false },
+        { .buffer = headless->sim.scratch.buffer, .cycle = false },
+        { .buffer = headless->trails.array.buffer, .cycle = false },
+        { .buffer = headless->trails.anchors.buffer, .cycle = false },
+    }, 5);
+}
+
+// exported frames are drawn at the step they belong to, with no ghost and no predictions
+static void headless_export_frame(Headless *headless, SDL_GPUCommandBuffer *command_buffer) {
+    if (!exporter_begin(&headless->exporter, &headless->sim)) return;
+    Camera cam = headless->cam;
+    camera_project(&cam, (f32) headless->exporter.width, (f32) headless->exporter.height);
+    graphics_draw(&headless->gfx, &(GraphicsDrawInfo) {
+        .gpu = headless->gpu,
+        .command_buffer = command_buffer,
+        .sim = &headless->sim,
+        .ghost = &(Ghost) { .enabled = false },
+        .trails = &headless->trails,
+        .trajectories = &(Trajectories) { .enabled = false },
+        .tracking = &headless->tracking,
+        .cam = &cam,
+        .appearance = &headless->appearance,
+        .target = headless->exporter.texture,
+        .target_width = headless->exporter.width,
+        .target_height = headless->exporter.height,
+    });
+
+    exporter_capture(&headless->exporter, command_buffer);
+}
+
+// captures need a copy pass and exported frames a render pass, so the compute pass is split around them
+static SDL_GPUComputePass *headless_capture_step(Headless *headless, SDL_GPUCommandBuffer *command_buffer, SDL_GPUComputePass *compute_pass) {
+    if (!recorder_due(&headless->rec, &headless->sim) && !diagnostics_due(&headless->diag, &headless->sim)
+        && !exporter_due(&headless->exporter, &headless->sim)) return compute_pass;
+    SDL_EndGPUComputePass(compute_pass);
+    recorder_capture(&headless->rec, headless->gpu, command_buffer, &headless->sim);
+    diagnostics_capture(&headless->diag, headless->gpu, command_buffer, &headless->sim);
+    headless_export_frame(headless, command_buffer);
+    return headless_compute_pass(headless, command_buffer);
+}
+
+// records a batch of steps per command buffer and keeps at most one batch in flight
+static SDL_AppResult headless_iterate(Headless *headless) {
+    TRACE_BEGIN("headless_iterate");
+    const HeadlessOptions *options = &headless->options;
+    trails_resize(&headless->trails, headless->gpu, headless->trail_length, headless->trails.compact);
+    recorder_poll(&headless->rec, headless->gpu, !recorder_available(&headless->rec));
+    exporter_poll(&headless->exporter, headless->gpu, !exporter_available(&headless->exporter));
+    diagnostics_poll(&headless->diag, headless->gpu);
+
+    // followed bodies are read back once per batch, exporting is the only thing that needs the camera here
+    if (headless->exporter.exporting) camera_follow(&headless->cam, headless->gpu, &headless->sim);
+
+    const u64 batch = SDL_min(HEADLESS_BATCH_STEPS, options->steps - SDL_min(headless->completed, options->steps));
+    SDL_GPUCommandBuffer *command_buffer = SDL_AcquireGPUCommandBuffer(headless->gpu);
+    SDL_GPUComputePass *compute_pass = headless_compute_pass(headless, command_buffer);
+
+    // unlike interactive runs, headless recordings and exports never drop frames and end the batch early instead
+    u64 steps = 0;
+    while (steps < batch && recorder_available(&headless->rec) && exporter_available(&headless->exporter)) {
+        simulation_update(&headless->sim, command_buffer, compute_pass, options->delta_time);
+        trails_update(&headless->trails, &(TrailsUpdateInfo) { .command_buffer = command_buffer, .compute_pass = compute_pass, .sim = &headless->sim, .tracking = &headless->tracking });
+        compute_pass = headless_capture_step(headless, command_buffer, compute_pass);
+        steps++;
+    }
+
+    SDL_EndGPUComputePass(compute_pass);
+    SDL_GPUFence *fence = SDL_SubmitGPUCommandBufferAndAcquireFence(command_buffer);
+    recorder_submit(&headless->rec, headless->gpu);
+    exporter_submit(&headless->exporter, headless->gpu);
+    diagnostics_submit(&headless->diag, headless->gpu);
+    if (headless->fence) {
+        SDL_WaitForGPUFences(headless->gpu, true, &headless->fence, 1);
+        SDL_ReleaseGPUFence(headless->gpu, headless->fence);
+    }
+
+    headless->fence = fence;
+    headless->completed += steps;
+    if (checkpoint_due(&headless->checkpoint, &headless->sim) && headless->completed < options->steps) TRACE_SCOPE("checkpoint_save") {
+        const SnapshotInfo info = headless_snapshot_info(headless);
+        checkpoint_save(&headless->checkpoint, &info);
+    }
+
+    TRACE_END();
+    if (headless->completed < options->steps) return SDL_APP_CONTINUE;
+
+    SDL_WaitForGPUFences(headless->gpu, true, &headless->fence, 1);
+    SDL_ReleaseGPUFence(headless->gpu, headless->fence);
+    headless->fence = NULL;
+    recorder_stop(&headless->rec, headless->gpu);
+    exporter_stop(&headless->exporter, headless->gpu);
+    checkpoint_wait(&headless->checkpoint);
+    SDL_WaitForGPUIdle(headless->gpu);
+    diagnostics_poll(&headless->diag, headless->gpu);
+    if (headless->diag.has_baseline) {
+        const DiagnosticsSample *first = &headless->diag.baseline, *last = &headless->diag.latest;
+        SDL_Log("Headless: Energy %g -> %g (relative drift %.3e), angular momentum %g -> %g.\n",
+            first->energy, last->energy, (last->energy - first->energy) / SDL_max(SDL_fabsf(first->energy), EPSILON),
+            first->angular_momentum, last->angular_momentum);
+    }
+
+    const f64 seconds = (f64) (SDL_GetTicksNS() - headless->start_tick) / (f64) SDL_NS_PER_SECOND;
+    const u64 stepped = headless->completed - headless->resumed;
+    SDL_Log("Headless: %" SDL_PRIu64 " steps in %.3f s (%.1f steps/s).\n", stepped, seconds, (f64) stepped / seconds);
+
+    const SnapshotInfo info = headless_snapshot_info(headless);
+    return snapshot_save(options->output, &info) ? SDL_APP_SUCCESS : SDL_APP_FAILURE;
+}
+
+static void headless_free(Headless *headless) {
+    if (!headless->gpu) {
+        SDL_Quit();
+        return;
+    }
+
+    SDL_WaitForGPUIdle(headless->gpu);
+    checkpoint_wait(&headless->checkpoint);
+    recorder_free(&headless->rec, headless->gpu);
+    exporter_free(&headless->exporter, headless->gpu);
+    diagnostics_free(&headless->diag, headless->gpu);
+    if (headless->fence) SDL_ReleaseGPUFence(headless->gpu, headless->fence);
+    simulation_free(&headless->sim, headless->gpu);
+    trails_free(&headless->trails, headless->gpu);
+    tracking_free(&headless->tracking, headless->gpu);
+    appearance_free(&headless->appearance, headless->gpu);
+    if (headless->options.export_path) graphics_free(&headless->gfx, headless->gpu);
+    SDL_DestroyGPUDevice(headless->gpu);
+    SDL_Quit();
+}
+
+int main(const int argc, char **argv) {
+    Headless headless = {
+        .options = {
+            .delta_time = FIXED_DELTA_TIME_DEFAULT,
+            .record_interval = RECORD_INTERVAL_DEFAULT,
+            .checkpoint_interval = CHECKPOINT_INTERVAL_DEFAULT,
+            .export_format = EXPORT_PPM,
+            .export_width = EXPORT_WIDTH_DEFAULT,
+            .export_height = EXPORT_HEIGHT_DEFAULT,
+            .export_interval = EXPORT_INTERVAL_DEFAULT,
+        },
+    };
+
+    if (!headless_arguments(&headless.options, argc, argv)) return 1;
+    SDL_AppResult result = headless_init(&headless);
+    while (result == SDL_APP_CONTINUE) result = headless_iterate(&headless);
+    headless_free(&headless);
+    return result == SDL_APP_SUCCESS ? 0 : 1;
+}
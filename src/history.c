@@ -0,0 +1,133 @@
+#include "history.h"
+#include "simulation.h"
+
+#include "HandmadeMath.h"
+
+#define HISTORY_BODY_SIZE (2 * sizeof(HMM_Vec2) + sizeof(f32))
+
+void history_init(History *history) {
+    *history = (History) {
+        .enabled = true,
+        .interval = HISTORY_INTERVAL_DEFAULT,
+    };
+}
+
+void history_clear(History *history) {
+    history->head = 0;
+    history->count = 0;
+    history->next_step = 0;
+}
+
+bool history_due(const History *history, const Simulation *sim) {
+    return history->enabled && sim->body_count && sim->step >= history->next_step;
+}
+
+// how many states of `body_count` bodies fit in the budget, 0 when fewer than two do
+u32 history_length(const u32 body_count) {
+    if (!body_count) return HISTORY_LENGTH;
+    const u64 capacity = (u64) body_count * HISTORY_BODY_SIZE * 3 / 2;
+    const u32 length = (u32) SDL_min(HISTORY_MEMORY_BUDGET / capacity, HISTORY_LENGTH);
+    return length < 2 ? 0 : length;
+}
+
+// records the copies into `command_buffer`, which must not have a pass open
+void history_capture(History *history, SDL_GPUDevice *gpu, SDL_GPUCommandBuffer *command_buffer, const Simulation *sim) {
+    if (!history_due(history, sim)) return;
+    if (history->body_count != sim->body_count) history_clear(history);
+    history->next_step = sim->step + history->interval;
+    history->body_count = sim->body_count;
+
+    // sized in u64 since huge scenes overflow u32 long before they run out of memory, the ring is capped by the budget instead
+    const u64 slot_size = (u64) sim->body_count * HISTORY_BODY_SIZE;
+    if (history->slot_size < slot_size) {
+        if (history->buffer) SDL_ReleaseGPUBuffer(gpu, history->buffer);
+        history->buffer = NULL;
+        history->slot_size = 0;
+
+        const u64 capacity = slot_size + slot_size / 2;
+        history->length = history_length(sim->body_count);
+        if (!history->length) return;
+
+        history->buffer = SDL_CreateGPUBuffer(gpu, &(SDL_GPUBufferCreateInfo) {
+            .size = history->length * (u32) capacity,
+            .usage = SDL_GPU_BUFFERUSAGE_COMPUTE_STORAGE_READ
+        });
+
+        if (!history->buffer) {
+            SDL_LogError(SDL_LOG_CATEGORY_GPU, "SDL_CreateGPUBuffer() in history_capture(): %s\n", SDL_GetError());
+            history->length = 0;
+            history->enabled = false;
+            return;
+        }
+
+        history->slot_size = (u32) capacity;
+    }
+
+    const u32 positions_size = sim->body_count * (u32) sizeof(HMM_Vec2);
+    const u32 slot = history->head * history->slot_size;
+    SDL_GPUCopyPass *copy_pass = SDL_BeginGPUCopyPass(command_buffer);
+    SDL_CopyGPUBufferToBuffer(copy_pass,
+        &(SDL_GPUBufferLocation) { .buffer = sim->positions.buffer, .offset = 0 },
+        &(SDL_GPUBufferLocation) { .buffer = history->buffer, .offset = slot },
+        positions_size, false);
+    SDL_CopyGPUBufferToBuffer(copy_pass,
+        &(SDL_GPUBufferLocation) { .buffer = sim->velocities.buffer, .offset = 0 },
+        &(SDL_GPUBufferLocation) { .buffer = history->buffer, .offset = slot + positions_size },
+        positions_size, false);
+    SDL_CopyGPUBufferToBuffer(copy_pass,
+        &(SDL_GPUBufferLocation) { .buffer = sim->masses.buffer, .offset = 0 },
+        &(SDL_GPUBufferLocation) { .buffer = history->buffer, .offset = slot + 2 * positions_size },
+        sim->body_count * (u32) sizeof(f32), false);
+    SDL_EndGPUCopyPass(copy_pass);
+
+    history->entries[history->head] = (HistoryEntry) { .step = sim->step };
+    history->head = (history->head + 1) % history->length;
+    history->count = SDL_min(history->count + 1, history->length);
+}
+
+u64 history_oldest_step(const History *history) {
+    if (history->count == 0) return 0;
+    return history->entries[(history->head + history->length - history->count) % history->length].step;
+}
+
+// restores the newest state at or before `step` and drops everything after it,
+// returns how many steps have to be integrated again to land exactly on `step`
+u64 history_rewind(History *history, SDL_GPUCopyPass *copy_pass, Simulation *sim, const u64 step) {
+    if (history->count == 0 || history->body_count != sim->body_count) return 0;
+
+    u32 kept = history->count;
+    u32 slot = (history->head + history->length - 1) % history->length;
+    while (kept > 1 && history->entries[slot].step > step) {
+        slot = (slot + history->length - 1) % history->length;
+        kept--;
+    }
+
+    const u32 positions_size = sim->body_count * (u32) sizeof(HMM_Vec2);
+    const u32 offset = slot * history->slot_size;
+    SDL_CopyGPUBufferToBuffer(copy_pass,
+        &(SDL_GPUBufferLocation) { .buffer = history->buffer, .offset = offset },
+        &(SDL_GPUBufferLocation) { .buffer = sim->positions.buffer, .offset = 0 },
+        positions_size, false);
+    SDL_CopyGPUBufferToBuffer(copy_pass,
+        &(SDL_GPUBufferLocation) { .buffer = history->buffer, .offset = offset + positions_size },
+        &(SDL_GPUBufferLocation) { .buffer = sim->velocities.buffer, .offset = 0 },
+        positions_size, false);
+    SDL_CopyGPUBufferToBuffer(copy_pass,
+        &(SDL_GPUBufferLocation) { .buffer = history->buffer, .offset = offset + 2 * positions_size },
+        &(SDL_GPUBufferLocation) { .buffer = sim->masses.buffer, .offset = 0 },
+        sim->body_count * (u32) sizeof(f32), false);
+
+    const u64 restored = history->entries[slot].step;
+    sim->step = restored;
+    history->head = (slot + 1) % history->length;
+    history->count = kept;
+    history->next_step = restored + history->interval;
+    return step > restored ? step - restored : 0;
+}
+
+void history_free(History *history, SDL_GPUDevice *gpu) {
+    if (history->buffer) SDL_ReleaseGPUBuffer(gpu, history->buffer);
+    history->buffer = NULL;
+    history->slot_size = 0;
+    history->length = 0;
+}
@@ -0,0 +1,243 @@
+#include "importer.h"
+#include "constants.h"
+#include "tracer.h"
+
+#include "SDL3/SDL_cpuinfo.h"
+#include "SDL3/SDL_iostream.h"
+#include "SDL3/SDL_stdinc.h"
+#include "SDL3/SDL_thread.h"
+
+#define IMPORTER_COLUMNS 9
+
+static const f64 IMPORTER_POWERS[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+};
+
+static bool importer_is_space(const char c) {
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+static bool importer_is_number(const char c) {
+    return (c >= '0' && c <= '9') || c == '-' || c == '+' || c == '.';
+}
+
+// decimal and scientific notation without strtod's locale handling, exact up to 19 significant digits
+static const char *importer_parse_f32(const char *p, const char *end, f32 *value, bool *valid) {
+    bool negative = false;
+    if (p < end && (*p == '-' || *p == '+')) negative = *p++ == '-';
+
+    u64 mantissa = 0;
+    i32 exponent = 0, digits = 0;
+    const char *start = p;
+    for (; p < end && *p >= '0' && *p <= '9'; p++) {
+        if (digits == 19) {
+            exponent++;
+            continue;
+        }
+
+        mantissa = mantissa * 10 + (u64) (*p - '0');
+        digits += mantissa != 0; // leading zeros aren't significant
+    }
+
+    if (p < end && *p == '.') {
+        for (p++; p < end && *p >= '0' && *p <= '9'; p++) {
+            if (digits == 19) continue;
+            mantissa = mantissa * 10 + (u64) (*p - '0');
+            digits += mantissa != 0;
+            exponent--;
+        }
+    }
+
+    if (p == start || (p == start + 1 && *start == '.')) {
+        *valid = false;
+        *value = 0.0f;
+        return p;
+    }
+
+    if (p < end && (*p == 'e' || *p == 'E')) {
+        const char *q = p + 1;
+        bool negative_exponent = false;
+        if (q < end && (*q == '-' || *q == '+')) negative_exponent = *q++ == '-';
+        i32 e = 0;
+        const char *e_start = q;
+        for (; q < end && *q >= '0' && *q <= '9'; q++) if (e < 10000) e = e * 10 + (*q - '0');
+        if (q != e_start) {
+            exponent += negative_exponent ? -e : e;
+            p = q;
+        }
+    }
+
+    f64 result = (f64) mantissa;
+    const i32 magnitude = exponent < 0 ? -exponent : exponent;
+    const f64 scale = magnitude < (i32) SDL_arraysize(IMPORTER_POWERS) ? IMPORTER_POWERS[magnitude] : SDL_pow(10.0, magnitude);
+    result = exponent < 0 ? result / scale : result * scale;
+
+    *value = (f32) (negative ? -result : result);
+    return p;
+}
+
+// a row is any line whose first non-space character can start a number
+static const char *importer_row_start(const char *line, const char *end) {
+    while (line < end && importer_is_space(*line)) line++;
+    return line < end && importer_is_number(*line) ? line : NULL;
+}
+
+static const char *importer_line_end(const char *line, const char *end) {
+    const char *newline = SDL_memchr(line, '\n', (usize) (end - line));
+    return newline ? newline : end;
+}
+
+static u32 importer_parse_row(const char *p, const char *end, f32 columns[IMPORTER_COLUMNS], bool *valid) {
+    u32 count = 0;
+    while (p < end && count < IMPORTER_COLUMNS) {
+        p = importer_parse_f32(p, end, &columns[count++], valid);
+        while (p < end && importer_is_space(*p)) p++;
+        if (p < end && (*p == ',' || *p == ';')) p++;
+        while (p < end && importer_is_space(*p)) p++;
+        if (p < end && !importer_is_number(*p)) {
+            *valid = false;
+            break;
+        }
+    }
+
+    return count;
+}
+
+typedef struct {
+    const char *begin;
+    const char *end;
+    BodyTable *bodies;
+    u32 first; // row of the table this chunk starts at
+    u32 rows;
+    u32 kept; // rows that parsed, packed from first onward
+} ImporterChunk;
+
+static i32 importer_count(void *data) {
+    ImporterChunk *chunk = data;
+    chunk->rows = 0;
+    for (const char *line = chunk->begin; line < chunk->end;) {
+        const char *line_end = importer_line_end(line, chunk->end);
+        if (importer_row_start(line, line_end)) chunk->rows++;
+        line = line_end + 1;
+    }
+
+    return 0;
+}
+
+static bool importer_is_finite(const f32 value) {
+    return !SDL_isinff(value) && !SDL_isnanf(value);
+}
+
+// a zero, negative or infinite mass has no radius and poisons every acceleration it touches
+static bool importer_check_row(const f32 columns[IMPORTER_COLUMNS]) {
+    for (u32 i = 0; i < IMPORTER_COLUMNS; i++) if (!importer_is_finite(columns[i])) return false;
+    return columns[4] > 0.0f;
+}
+
+// writes straight into the table, no allocations. Malformed rows are dropped, so the chunk may end short of its slice
+static i32 importer_parse(void *data) {
+    ImporterChunk *chunk = data;
+    BodyTable *bodies = chunk->bodies;
+    u32 row = chunk->first;
+
+    TRACE_SCOPE("importer_parse") for (const char *line = chunk->begin; line < chunk->end;) {
+        const char *line_end = importer_line_end(line, chunk->end);
+        const char *start = importer_row_start(line, line_end);
+        line = line_end + 1;
+        if (!start) continue;
+
+        f32 columns[IMPORTER_COLUMNS] = { 0.0f, 0.0f, 0.0f, 0.0f, MASS_DEFAULT, 1.0f, 1.0f, 1.0f, 1.0f };
+        bool valid = true;
+        if (importer_parse_row(start, line_end, columns, &valid) < 4) valid = false;
+        if (!valid || !importer_check_row(columns)) continue;
+
+        bodies->positions[row] = HMM_V2(columns[0], columns[1]);
+        bodies->velocities[row] = HMM_V2(columns[2], columns[3]);
+        bodies->masses[row] = columns[4];
+        bodies->colors[row] = (SDL_FColor) { columns[5], columns[6], columns[7], 1.0f };
+        bodies->movable[row] = columns[8] != 0.0f ? 1.0f : 0.0f;
+        row++;
+    }
+
+    chunk->kept = row - chunk->first;
+    return 0;
+}
+
+// slides every chunk's parsed rows down against the previous chunk's, returns the rows kept
+static u32 importer_compact(BodyTable *bodies, const ImporterChunk *chunks, const u32 chunk_count) {
+    u32 kept = 0;
+    for (u32 i = 0; i < chunk_count; i++) {
+        const u32 from = chunks[i].first, n = chunks[i].kept;
+        if (from != kept && n) {
+            SDL_memmove(&bodies->positions[kept], &bodies->positions[from], n * sizeof(HMM_Vec2));
+            SDL_memmove(&bodies->velocities[kept], &bodies->velocities[from], n * sizeof(HMM_Vec2));
+            SDL_memmove(&bodies->masses[kept], &bodies->masses[from], n * sizeof(f32));
+            SDL_memmove(&bodies->movable[kept], &bodies->movable[from], n * sizeof(f32));
+            SDL_memmove(&bodies->colors[kept], &bodies->colors[from], n * sizeof(SDL_FColor));
+        }
+
+        kept += n;
+    }
+
+    return kept;
+}
+
+static void importer_run(SDL_ThreadFunction function, ImporterChunk *chunks, const u32 chunk_count) {
+    SDL_Thread *threads[IMPORTER_MAX_THREADS] = { 0 };
+    for (u32 i = 1; i < chunk_count; i++) {
+        threads[i] = SDL_CreateThread(function, "importer", &chunks[i]);
+        if (!threads[i]) function(&chunks[i]);
+    }
+
+    function(&chunks[0]);
+    for (u32 i = 1; i < chunk_count; i++) if (threads[i]) SDL_WaitThread(threads[i], NULL);
+}
+
+// two passes over newline-aligned chunks: count the rows, then parse each chunk into its slice of the table
+bool import_csv(const char *path, BodyTable *bodies) {
+    usize size = 0;
+    char *text = SDL_LoadFile(path, &size);
+    if (!text) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "SDL_LoadFile() in import_csv(): %s\n", SDL_GetError());
+        return false;
+    }
+
+    const char *end = text + size;
+    const u32 wanted = (u32) SDL_max(size / IMPORTER_CHUNK_MIN, 1);
+    const u32 chunk_count = SDL_min(SDL_min((u32) SDL_GetNumLogicalCPUCores(), wanted), IMPORTER_MAX_THREADS);
+
+    ImporterChunk chunks[IMPORTER_MAX_THREADS];
+    const char *begin = text;
+    for (u32 i = 0; i < chunk_count; i++) {
+        const char *split = i + 1 == chunk_count ? end : text + size / chunk_count * (i + 1);
+        if (split < begin) split = begin;
+        if (split < end) split = importer_line_end(split, end) + 1;
+        if (split > end) split = end;
+
+        chunks[i] = (ImporterChunk) { .begin = begin, .end = split, .bodies = bodies };
+        begin = split;
+    }
+
+    importer_run(importer_count, chunks, chunk_count);
+
+    u32 rows = 0;
+    for (u32 i = 0; i < chunk_count; i++) {
+        chunks[i].first = rows;
+        rows += chunks[i].rows;
+    }
+
+    if (!body_table_alloc(bodies, rows)) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "body_table_alloc() in import_csv(): Out of memory for %u bodies.\n", rows);
+        SDL_free(text);
+        return false;
+    }
+
+    importer_run(importer_parse, chunks, chunk_count);
+    SDL_free(text);
+
+    bodies->count = importer_compact(bodies, chunks, chunk_count);
+    if (bodies->count < rows) SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "import_csv(): Skipped %u of %u rows in %s, they were malformed or had a mass that isn't positive and finite.\n", rows - bodies->count, rows, path);
+
+    return true;
+}
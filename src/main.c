@@ -4,39 +4,92 @@
 #include "ghost.h"
 #include "trails.h"
 #include "trajectories.h"
+#include "tracking.h"
 #include "camera.h"
+#include "appearance.h"
 #include "graphics.h"
 #include "gui.h"
+#include "snapshot.h"
+#include "recorder.h"
+#include "exporter.h"
+#include "replay.h"
+#include "history.h"
+#include "diagnostics.h"
+#include "generators.h"
+#include "importer.h"
+#include "tracer.h"
 
 #define SDL_MAIN_USE_CALLBACKS
 #include "SDL3/SDL_main.h"
 #include "SDL3/SDL_gpu.h"
 #include "types.h"
 
-#define STB_DS_IMPLEMENTATION
-#include "stb_ds.h"
-
 #define UNUSED(x) (void)(x)
 
 typedef struct {
     ApplicationOptions options;
     SDL_Window *window;
     SDL_GPUDevice *gpu;
+    SDL_GPUPresentMode present_mode; // the one the swapchain uses
 
     Simulation sim;
     Ghost ghost;
     Trails trails;
     Trajectories trajectories;
+    Tracking tracking;
     Camera cam;
+    Appearance appearance;
     Graphics gfx;
     Gui gui;
+    Recorder rec;
+    Exporter exporter;
+    Replay replay;
+    History history;
+    Diagnostics diag;
 } Application;
 
+static bool parse_arguments(Application *app, int argc, char **argv);
+static void set_present_mode(Application *app, SDL_GPUPresentMode mode);
 SDL_AppResult SDL_AppInit(void **appstate, const int argc, char **argv) {
-    UNUSED(argc); UNUSED(argv);
     Application *app = SDL_calloc(1, sizeof(*app));
     *appstate = app;
-    app->options = (ApplicationOptions) { .fixed_delta_time = FIXED_DELTA_TIME_DEFAULT };
+    app->options = (ApplicationOptions) {
+        .fixed_delta_time = FIXED_DELTA_TIME_DEFAULT,
+        .simulation_rate = RATE_REAL_TIME,
+        .time_scale = TIME_SCALE_DEFAULT,
+        .steps_per_frame = STEPS_PER_FRAME_DEFAULT,
+        .render_rate = RENDER_RATE_DEFAULT,
+        .present_mode = PRESENT_MODE_DEFAULT,
+        .trail_length = TRAIL_LENGTH_DEFAULT,
+        .prediction_length = PREDICTION_LENGTH_DEFAULT,
+        .heaviest_count = TRACKING_HEAVIEST_DEFAULT,
+        .snapshot_path = SNAPSHOT_PATH_DEFAULT,
+        .recording_path = RECORDING_PATH_DEFAULT,
+        .record_interval = RECORD_INTERVAL_DEFAULT,
+        .keyframe_interval = RECORD_KEYFRAME_INTERVAL_DEFAULT,
+        .export_path = EXPORT_PATH_DEFAULT,
+        .export_format = EXPORT_PPM,
+        .export_width = EXPORT_WIDTH_DEFAULT,
+        .export_height = EXPORT_HEIGHT_DEFAULT,
+        .export_interval = EXPORT_INTERVAL_DEFAULT,
+        .replay_path = RECORDING_PATH_DEFAULT,
+        .import_path = IMPORT_PATH_DEFAULT,
+        .generator = {
+            .type = GENERATOR_PLUMMER,
+            .count = GENERATOR_COUNT_DEFAULT,
+            .seed = GENERATOR_SEED_DEFAULT,
+            .mass = GENERATOR_MASS_DEFAULT,
+            .radius = GENERATOR_RADIUS_DEFAULT,
+            .central_mass = GENERATOR_CENTRAL_MASS_DEFAULT,
+            .rings = GENERATOR_RINGS_DEFAULT,
+        }
+    };
+
+    recorder_init(&app->rec);
+    exporter_init(&app->exporter);
+    replay_init(&app->replay);
+    history_init(&app->history);
+    if (!parse_arguments(app, argc, argv)) return SDL_APP_FAILURE;
 
     // initialize SDL3
     if (!SDL_Init(SDL_INIT_VIDEO | SDL_INIT_GAMEPAD)) panic("Failed to initialize SDL3!");
@@ -53,74 +106,267 @@ SDL_AppResult SDL_AppInit(void **appstate, const int argc, char **argv) {
     app->gpu = SDL_CreateGPUDevice(SDL_GPU_SHADERFORMAT_SPIRV | SDL_GPU_SHADERFORMAT_MSL, true, NULL);
     if (!app->gpu) panic("Failed to create GPU device!");
     if (!SDL_ClaimWindowForGPUDevice(app->gpu, app->window)) panic("Failed to claim window for GPU!");
-    SDL_SetGPUSwapchainParameters(app->gpu, app->window, SDL_GPU_SWAPCHAINCOMPOSITION_SDR, SDL_GPU_PRESENTMODE_VSYNC);
+    set_present_mode(app, app->options.present_mode);
 
     // initialize modules
     if (simulation_init(&app->sim, app->gpu) != 0) panic("Failed to initialize simulation!");
     ghost_init(&app->ghost);
     if (trails_init(&app->trails, app->gpu) != 0) panic("Failed to initialize trail module!");
     if (trajectories_init(&app->trajectories, app->gpu) != 0) panic("Failed to initialize trajectory module!");
+    if (tracking_init(&app->tracking, app->gpu) != 0) panic("Failed to initialize tracking!");
+    if (diagnostics_init(&app->diag, app->gpu) != 0) panic("Failed to initialize diagnostics!");
     camera_init(&app->cam);
+    if (appearance_init(&app->appearance, app->gpu) != 0) panic("Failed to initialize appearance!");
     if (graphics_init(&app->gfx, app->gpu, app->window) != 0) panic("Failed to initialize graphics!");
     gui_init(&app->gui, app->window, app->gpu);
     return SDL_APP_CONTINUE;
 }
 
-SDL_AppResult SDL_AppIterate(void *appstate) {
-    Application *app = appstate;
-    static u64 last_tick = 0;
-    static f32 accumulator = 0.0f;
+static bool parse_arguments(Application *app, const int argc, char **argv) {
+    for (i32 i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        const char *value = i + 1 < argc ? argv[i + 1] : NULL;
 
-    if (last_tick == 0) last_tick = SDL_GetTicksNS();
-    const u64 current_tick = SDL_GetTicksNS();
-    const f32 delta_time = (f32)(current_tick - last_tick) / (f32) SDL_NS_PER_SECOND;
-    last_tick = current_tick;
+        if (SDL_strcmp(arg, "--record-interval") == 0 && value) {
+            app->options.record_interval = (u32) SDL_strtoul(value, NULL, 10);
+            i++;
+        } else if (SDL_strcmp(arg, "--export") == 0 && value) {
+            SDL_strlcpy(app->options.export_path, value, sizeof(app->options.export_path));
+            app->options.toggle_export = true;
+            i++;
+        } else if (SDL_strcmp(arg, "--export-format") == 0 && value) {
+            app->options.export_format = SDL_strcmp(value, "raw") == 0 ? EXPORT_RAW : EXPORT_PPM;
+            i++;
+        } else if (SDL_strcmp(arg, "--export-size") == 0 && value) {
+            if (SDL_sscanf(value, "%ux%u", &app->options.export_width, &app->options.export_height) != 2) {
+                SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "parse_arguments() in SDL_AppInit(): --export-size expects <width>x<height>.\n");
+                return false;
+            }
+            i++;
+        } else if (SDL_strcmp(arg, "--export-interval") == 0 && value) {
+            app->options.export_interval = (u32) SDL_strtoul(value, NULL, 10);
+            i++;
+        } else if (SDL_strcmp(arg, "--replay") == 0 && value) {
+            SDL_strlcpy(app->options.replay_path, value, sizeof(app->options.replay_path));
+            app->options.toggle_replay = true;
+            i++;
+        } else if (SDL_strcmp(arg, "--present-mode") == 0 && value) {
+            app->options.present_mode = SDL_strcmp(value, "mailbox") == 0 ? SDL_GPU_PRESENTMODE_MAILBOX
+                : SDL_strcmp(value, "immediate") == 0 ? SDL_GPU_PRESENTMODE_IMMEDIATE : SDL_GPU_PRESENTMODE_VSYNC;
+            i++;
+        } else if (SDL_strcmp(arg, "--time-scale") == 0 && value) {
+            app->options.simulation_rate = RATE_REAL_TIME;
+            app->options.time_scale = (f32) SDL_atof(value);
+            i++;
+        } else if (SDL_strcmp(arg, "--steps-per-frame") == 0 && value) {
+            app->options.simulation_rate = RATE_STEPS_PER_FRAME;
+            app->options.steps_per_frame = SDL_max((u32) SDL_strtoul(value, NULL, 10), 1);
+            i++;
+        } else if (SDL_strcmp(arg, "--uncapped") == 0 && value) {
+            app->options.simulation_rate = RATE_UNCAPPED;
+            app->options.render_rate = (f32) SDL_atof(value);
+            i++;
+        } else if (SDL_strcmp(arg, "--dt") == 0 && value) {
+            app->options.fixed_delta_time = (f32) SDL_atof(value);
+            i++;
+        } else {
+            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION,
+                "parse_arguments() in SDL_AppInit(): Unknown argument %s.\n"
+                "usage: n-body [--replay <recording>] [--present-mode vsync|mailbox|immediate] [--time-scale <x> | --steps-per-frame <k> | --uncapped <render hz>] [--export <path> [--export-format ppm|raw] [--export-size <w>x<h>] [--export-interval <steps>]] [--record-interval <steps>] [--dt <seconds>]\n", arg);
+            return false;
+        }
+    }
 
-    SDL_GPUCommandBuffer *command_buffer = SDL_AcquireGPUCommandBuffer(app->gpu);
+    if (app->options.time_scale <= 0.0f || app->options.render_rate <= 0.0f) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "parse_arguments() in SDL_AppInit(): --time-scale and --uncapped must be positive.\n");
+        return false;
+    }
+
+    if (app->options.fixed_delta_time <= 0.0f) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "parse_arguments() in SDL_AppInit(): --dt must be positive.\n");
+        return false;
+    }
+
+    return true;
+}
+
+static SDL_GPUComputePass *begin_compute_pass(const Application *app, SDL_GPUCommandBuffer *command_buffer) {
     const SDL_GPUStorageBufferReadWriteBinding bindings[] = {
         { .buffer = app->sim.positions.buffer, .cycle = false },
         { .buffer = app->sim.velocities.buffer, .cycle = false },
+        { .buffer = app->sim.scratch.buffer, .cycle = false },
         { .buffer = app->trails.array.buffer, .cycle = false },
+        { .buffer = app->trails.anchors.buffer, .cycle = false },
         { .buffer = app->trajectories.positions.buffer, .cycle = false },
-        { .buffer = app->trajectories.velocities.buffer, .cycle = false },
+        { .buffer = app->trajectories.state.buffer, .cycle = false },
         { .buffer = app->trajectories.ghost, .cycle = false }
     };
 
-    SDL_GPUComputePass *compute_pass = SDL_BeginGPUComputePass(
+    return SDL_BeginGPUComputePass(
         command_buffer,
         NULL, 0,
         bindings, sizeof(bindings) / sizeof(SDL_GPUStorageBufferReadWriteBinding)
     );
+}
+
+// exported frames are drawn at the step they belong to, with the camera where it was last placed and no body creation preview
+static void export_frame(Application *app, SDL_GPUCommandBuffer *command_buffer) {
+    if (!exporter_begin(&app->exporter, &app->sim)) return;
+    Camera cam = app->cam;
+    camera_project(&cam, (f32) app->exporter.width, (f32) app->exporter.height);
+    graphics_draw(&app->gfx, &(GraphicsDrawInfo) {
+        .gpu = app->gpu,
+        .command_buffer = command_buffer,
+        .sim = &app->sim,
+        .ghost = &(Ghost) { .enabled = false },
+        .trails = &app->trails,
+        .trajectories = &app->trajectories,
+        .tracking = &app->tracking,
+        .cam = &cam,
+        .appearance = &app->appearance,
+        .target = app->exporter.texture,
+        .target_width = app->exporter.width,
+        .target_height = app->exporter.height,
+    });
+
+    exporter_capture(&app->exporter, command_buffer);
+}
+
+// captures need a copy pass and exported frames a render pass, so the compute pass is split around them
+static SDL_GPUComputePass *capture_step(Application *app, SDL_GPUCommandBuffer *command_buffer, SDL_GPUComputePass *compute_pass) {
+    if (!recorder_due(&app->rec, &app->sim) && !history_due(&app->history, &app->sim) && !diagnostics_due(&app->diag, &app->sim)
+        && !exporter_due(&app->exporter, &app->sim)) return compute_pass;
+    SDL_EndGPUComputePass(compute_pass);
+    recorder_capture(&app->rec, app->gpu, command_buffer, &app->sim);
+    history_capture(&app->history, app->gpu, command_buffer, &app->sim);
+    diagnostics_capture(&app->diag, app->gpu, command_buffer, &app->sim);
+    export_frame(app, command_buffer);
+    return begin_compute_pass(app, command_buffer);
+}
+
+// how many steps this frame simulates under the chosen SimulationRate, decoupled from how often frames are drawn
+static u64 frame_steps(const Application *app, const f32 delta_time) {
+    static f32 accumulator = 0.0f;
+    static f32 uncapped = 1.0f;
+    const ApplicationOptions *options = &app->options;
+    if (app->replay.open) {
+        accumulator = 0.0f;
+        return 0;
+    }
+
+    if (options->simulation_rate == RATE_STEPS_PER_FRAME) return options->steps_per_frame;
+    if (options->simulation_rate == RATE_UNCAPPED) {
+        if (app->sim.options.paused) return 1;
+
+        // grows while frames come in faster than the render rate, and shrinks by how far behind a slow one was
+        const f32 budget = 1.0f / options->render_rate;
+        uncapped = delta_time < budget ? uncapped * 1.1f + 1.0f : uncapped * budget / delta_time;
+        uncapped = SDL_clamp(uncapped, 1.0f, (f32) UNCAPPED_STEPS_MAX);
+        return (u64) uncapped;
+    }
+
+    // a frame catches up on at most MAX_ACCUMULATOR_TIME, so one slow frame doesn't snowball into slower ones
+    const f32 step = options->fixed_delta_time;
+    accumulator = SDL_min(accumulator + delta_time * options->time_scale, (f32) MAX_ACCUMULATOR_TIME * options->time_scale);
+    const u64 steps = (u64) (accumulator / step);
+    accumulator -= (f32) steps * step;
+    return steps;
+}
+
+static void process_requests(Application *app);
+SDL_AppResult SDL_AppIterate(void *appstate) {
+    Application *app = appstate;
+    TRACE_BEGIN("SDL_AppIterate");
+    static u64 last_tick = 0;
+
+    if (last_tick == 0) last_tick = SDL_GetTicksNS();
+    const u64 current_tick = SDL_GetTicksNS();
+    const f32 delta_time = (f32)(current_tick - last_tick) / (f32) SDL_NS_PER_SECOND;
+    last_tick = current_tick;
+
+    process_requests(app);
+    trails_resize(&app->trails, app->gpu, app->options.trail_length, app->options.compact_history);
+    trajectories_resize(&app->trajectories, app->gpu, app->options.prediction_length, app->options.compact_history);
+
+    TRACE_SCOPE("recorder_poll") recorder_poll(&app->rec, app->gpu, false);
+    TRACE_SCOPE("exporter_poll") exporter_poll(&app->exporter, app->gpu, false);
+    TRACE_SCOPE("diagnostics_poll") diagnostics_poll(&app->diag, app->gpu);
+
+    SDL_GPUCommandBuffer *command_buffer = SDL_AcquireGPUCommandBuffer(app->gpu);
+    bool replayed = false;
+    if (app->replay.open) TRACE_SCOPE("replay_update") {
+        SDL_GPUCopyPass *copy_pass = SDL_BeginGPUCopyPass(command_buffer);
+        replayed = replay_update(&app->replay, app->gpu, copy_pass, &app->sim, &app->trails, delta_time);
+        SDL_EndGPUCopyPass(copy_pass);
+    }
+
+    u64 catch_up = 0;
+    if (app->options.rewind && !app->replay.open) TRACE_SCOPE("history_rewind") {
+        const u64 target = app->sim.step - SDL_min(app->sim.step, (u64) app->options.rewind_steps);
+        SDL_GPUCopyPass *copy_pass = SDL_BeginGPUCopyPass(command_buffer);
+        catch_up = history_rewind(&app->history, copy_pass, &app->sim, target);
+        SDL_EndGPUCopyPass(copy_pass);
+        app->trails.reset_from = 0;
+    }
+
+    app->options.rewind = false;
+    SDL_GPUComputePass *compute_pass = begin_compute_pass(app, command_buffer);
 
-    accumulator += delta_time;
-    while (accumulator >= app->options.fixed_delta_time) {
+    // replays feed positions in from disk instead of integrating them
+    if (replayed) trails_update(&app->trails, &(TrailsUpdateInfo) { .command_buffer = command_buffer, .compute_pass = compute_pass, .sim = &app->sim, .tracking = &app->tracking });
+
+    // a rewind between two history entries integrates forward from the older one, paused or not
+    const bool paused = app->sim.options.paused;
+    app->sim.options.paused = false;
+    for (u64 i = 0; i < catch_up; i++) {
+        simulation_update(&app->sim, command_buffer, compute_pass, app->options.fixed_delta_time);
+        trails_update(&app->trails, &(TrailsUpdateInfo) { .command_buffer = command_buffer, .compute_pass = compute_pass, .sim = &app->sim, .tracking = &app->tracking });
+        compute_pass = capture_step(app, command_buffer, compute_pass);
+    }
+
+    app->sim.options.paused = paused;
+    const u64 steps = frame_steps(app, delta_time);
+    TRACE_BEGIN("simulate");
+    for (u64 i = 0; i < steps; i++) {
         simulation_update(&app->sim, command_buffer, compute_pass, app->options.fixed_delta_time);
-        trails_update(&app->trails, command_buffer, compute_pass, &app->sim);
-        trajectories_update(&app->trajectories, &(TrajectoriesUpdateInfo) {
-            .command_buffer = command_buffer,
-            .compute_pass = compute_pass,
-            .sim = &app->sim,
-            .ghost = &app->ghost,
-            .delta_time = delta_time
-        });
+        trails_update(&app->trails, &(TrailsUpdateInfo) { .command_buffer = command_buffer, .compute_pass = compute_pass, .sim = &app->sim, .tracking = &app->tracking });
+        compute_pass = capture_step(app, command_buffer, compute_pass);
         // FIXME: why does changing this to use &info break everything?
-        accumulator -= app->options.fixed_delta_time;
     }
 
+    TRACE_END();
+
+    // predictions only matter for the frame that's drawn, so they start from the final state once instead of every step
+    TRACE_SCOPE("trajectories_update") trajectories_update(&app->trajectories, &(TrajectoriesUpdateInfo) {
+        .command_buffer = command_buffer,
+        .compute_pass = compute_pass,
+        .sim = &app->sim,
+        .ghost = &app->ghost,
+        .tracking = &app->tracking,
+        .delta_time = delta_time
+    });
+
     SDL_EndGPUComputePass(compute_pass);
-    camera_update(&app->cam, app->window, app->gpu, &app->sim);
-    ghost_update(&app->ghost, app->gpu, &app->sim, &app->cam);
+    TRACE_SCOPE("camera_update") camera_update(&app->cam, app->window, app->gpu, &app->sim);
+    TRACE_SCOPE("ghost_update") ghost_update(&app->ghost, app->gpu, &app->sim, &app->cam);
 
-    gui_update(&(GuiUpdateInfo) {
+    TRACE_SCOPE("gui_update") gui_update(&(GuiUpdateInfo) {
         .app = &app->options,
+        .rec = &app->rec,
+        .exporter = &app->exporter,
+        .replay = &app->replay,
+        .history = &app->history,
+        .diag = &app->diag,
         .sim = &app->sim,
         .ghost = &app->ghost,
         .trajectories = &app->trajectories,
+        .tracking = &app->tracking,
         .cam = &app->cam,
-        .gfx = &app->gfx,
+        .appearance = &app->appearance,
     });
 
-    graphics_draw(&app->gfx, &(GraphicsDrawInfo) {
+    SDL_GPUTexture *swapchain = NULL;
+    TRACE_SCOPE("graphics_draw") swapchain = graphics_draw(&app->gfx, &(GraphicsDrawInfo) {
         .window = app->window,
         .gpu = app->gpu,
         .command_buffer = command_buffer,
@@ -128,26 +374,33 @@ SDL_AppResult SDL_AppIterate(void *appstate) {
         .ghost = &app->ghost,
         .trails = &app->trails,
         .trajectories = &app->trajectories,
+        .tracking = &app->tracking,
         .cam = &app->cam,
+        .appearance = &app->appearance,
     });
-    
-    SDL_SubmitGPUCommandBuffer(command_buffer);
 
+    if (swapchain) TRACE_SCOPE("gui_draw") gui_draw(command_buffer, swapchain);
+    TRACE_SCOPE("SDL_SubmitGPUCommandBuffer") SDL_SubmitGPUCommandBuffer(command_buffer);
+    recorder_submit(&app->rec, app->gpu);
+    exporter_submit(&app->exporter, app->gpu);
+    diagnostics_submit(&app->diag, app->gpu);
+
+    TRACE_END();
     return SDL_APP_CONTINUE;
 }
 
 static void add_body(Application *app, const SimulationAddBodyInfo *sim_info, SDL_FColor *color);
 SDL_AppResult SDL_AppEvent(void *appstate, SDL_Event *event) {
     Application *app = appstate;
-    UNUSED(app);
 
     if (event->type == SDL_EVENT_QUIT) return SDL_APP_SUCCESS;
 
+    TRACE_BEGIN("SDL_AppEvent");
     gui_event(event);
     if (!app->gui.io->WantCaptureMouse) {
         camera_mouse(&app->cam, event, &app->ghost);
 
-        if (ghost_mouse(&app->ghost, event)) {
+        if (ghost_mouse(&app->ghost, event) && !app->replay.open) {
             add_body(app, &(SimulationAddBodyInfo) {
                 .position = app->ghost.position,
                 .velocity = app->ghost.velocity,
@@ -160,37 +413,236 @@ SDL_AppResult SDL_AppEvent(void *appstate, SDL_Event *event) {
     if (!app->gui.io->WantCaptureKeyboard) {
         camera_keyboard(&app->cam, event, &app->sim);
         ghost_keyboard(&app->ghost, event);
+        tracer_keyboard(event);
     }
 
+    TRACE_END();
     return SDL_APP_CONTINUE;
 }
 
+static void add_bodies(Application *app, const BodyTable *bodies) {
+    SDL_GPUCommandBuffer *command_buffer = SDL_AcquireGPUCommandBuffer(app->gpu);
+    SDL_GPUCopyPass *copy_pass = SDL_BeginGPUCopyPass(command_buffer);
+    simulation_add_bodies(&app->sim, app->gpu, copy_pass, bodies);
+    const u32 slots = tracking_add_bodies(&app->tracking, bodies->count);
+    trails_add_slots(&app->trails, app->gpu, copy_pass, slots);
+    trajectories_add_bodies(&app->trajectories, app->gpu, copy_pass, bodies->count);
+    trajectories_set_slots(&app->trajectories, app->gpu, copy_pass, tracking_slot_count(&app->tracking));
+    tracking_upload(&app->tracking, app->gpu, copy_pass);
+    appearance_add_bodies(&app->appearance, app->gpu, copy_pass, bodies->colors, bodies->count);
+    SDL_EndGPUCopyPass(copy_pass);
+    SDL_SubmitGPUCommandBuffer(command_buffer);
+}
+
+static void clear_bodies(Application *app) {
+    simulation_clear(&app->sim);
+    trails_clear(&app->trails);
+    trajectories_clear(&app->trajectories);
+    tracking_clear(&app->tracking);
+    appearance_clear(&app->appearance);
+    history_clear(&app->history);
+    app->cam.target = (u32) -1;
+}
+
 static void add_body(Application *app, const SimulationAddBodyInfo *sim_info, SDL_FColor *color) {
     SDL_GPUCommandBuffer *command_buffer = SDL_AcquireGPUCommandBuffer(app->gpu);
     SDL_GPUCopyPass *copy_pass = SDL_BeginGPUCopyPass(command_buffer);
     simulation_add_body(&app->sim, app->gpu, copy_pass, sim_info);
-    trails_add_body(&app->trails, app->gpu, copy_pass, sim_info->position);
-    trajectories_add_body(&app->trajectories, app->gpu, copy_pass, sim_info->position);
-    graphics_add_body(&app->gfx, app->gpu, copy_pass, color);
+    trails_add_slots(&app->trails, app->gpu, copy_pass, tracking_add_bodies(&app->tracking, 1));
+    trajectories_add_bodies(&app->trajectories, app->gpu, copy_pass, 1);
+    trajectories_set_slots(&app->trajectories, app->gpu, copy_pass, tracking_slot_count(&app->tracking));
+    tracking_upload(&app->tracking, app->gpu, copy_pass);
+    appearance_add_body(&app->appearance, app->gpu, copy_pass, *color);
     SDL_EndGPUCopyPass(copy_pass);
     SDL_SubmitGPUCommandBuffer(command_buffer);
 }
 
+static SnapshotInfo snapshot_info(Application *app) {
+    return (SnapshotInfo) {
+        .gpu = app->gpu,
+        .sim = &app->sim,
+        .appearance = &app->appearance,
+        .trails = &app->trails,
+        .trajectories = &app->trajectories,
+        .tracking = &app->tracking,
+        .cam = &app->cam,
+    };
+}
+
+// indices of the `count` heaviest bodies, heaviest first
+static i32 SDLCALL compare_masses(void *masses, const void *a, const void *b) {
+    const f32 mass_a = ((const f32 *) masses)[*(const u32 *) a], mass_b = ((const f32 *) masses)[*(const u32 *) b];
+    return (mass_a < mass_b) - (mass_a > mass_b);
+}
+
+static u32 heaviest_bodies(Application *app, u32 *bodies, const u32 count) {
+    const u32 body_count = app->sim.body_count;
+    f32 *masses = SDL_malloc(sizeof(f32) * SDL_max(body_count, 1));
+    u32 *order = SDL_malloc(sizeof(u32) * SDL_max(body_count, 1));
+    if (!masses || !order) {
+        SDL_free(masses);
+        SDL_free(order);
+        return 0;
+    }
+
+    ReadFromGPUBufferNow(app->gpu, &(ReadGPUBufferBinding) {
+        .buffer = app->sim.masses.buffer,
+        .destination = (u8 *) masses,
+        .size = body_count * (u32) sizeof(f32),
+    }, body_count ? 1 : 0);
+
+    for (u32 i = 0; i < body_count; i++) order[i] = i;
+    SDL_qsort_r(order, body_count, sizeof(u32), compare_masses, masses);
+    const u32 found = SDL_min(count, body_count);
+    SDL_memcpy(bodies, order, sizeof(u32) * found);
+    SDL_free(masses);
+    SDL_free(order);
+    return found;
+}
+
+// changing the mode rebuilds every slot, toggling a body adds a slot or swaps the last one into its place
+static void process_tracking(Application *app) {
+    const bool rebuild = app->options.tracking_mode != app->tracking.mode || app->options.track_heaviest;
+    const u32 target = app->cam.target;
+    const bool toggle = app->options.toggle_tracked && app->tracking.mode == TRACKING_SELECTED && target < app->tracking.body_count;
+    app->options.toggle_tracked = false;
+    if (!rebuild && !toggle) return;
+
+    SDL_GPUCommandBuffer *command_buffer = SDL_AcquireGPUCommandBuffer(app->gpu);
+    SDL_GPUCopyPass *copy_pass = SDL_BeginGPUCopyPass(command_buffer);
+    if (rebuild) {
+        if (app->options.track_heaviest) app->options.tracking_mode = TRACKING_SELECTED;
+        tracking_set_mode(&app->tracking, app->options.tracking_mode);
+        if (app->options.track_heaviest) {
+            u32 *bodies = SDL_malloc(sizeof(u32) * SDL_max(app->options.heaviest_count, 1));
+            const u32 count = bodies ? heaviest_bodies(app, bodies, app->options.heaviest_count) : 0;
+            for (u32 i = 0; i < count; i++) tracking_add(&app->tracking, bodies[i]);
+            SDL_free(bodies);
+        }
+
+        trails_clear(&app->trails);
+        trails_add_slots(&app->trails, app->gpu, copy_pass, tracking_slot_count(&app->tracking));
+    } else if (tracking_slot(&app->tracking, target) == TRACKING_NONE) {
+        tracking_add(&app->tracking, target);
+        trails_add_slots(&app->trails, app->gpu, copy_pass, 1);
+    } else {
+        u32 slot;
+        tracking_remove(&app->tracking, target, &slot);
+        trails_remove_slot(&app->trails, copy_pass, slot);
+    }
+
+    trajectories_set_slots(&app->trajectories, app->gpu, copy_pass, tracking_slot_count(&app->tracking));
+    tracking_upload(&app->tracking, app->gpu, copy_pass);
+    SDL_EndGPUCopyPass(copy_pass);
+    SDL_SubmitGPUCommandBuffer(command_buffer);
+    app->options.track_heaviest = false;
+}
+
+// every swapchain supports vsync, so it's the fallback
+static void set_present_mode(Application *app, SDL_GPUPresentMode mode) {
+    if (!SDL_WindowSupportsGPUPresentMode(app->gpu, app->window, mode)) {
+        SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "set_present_mode(): Present mode %d isn't supported, falling back to vsync.\n", (i32) mode);
+        mode = SDL_GPU_PRESENTMODE_VSYNC;
+    }
+
+    if (!SDL_SetGPUSwapchainParameters(app->gpu, app->window, SDL_GPU_SWAPCHAINCOMPOSITION_SDR, mode)) {
+        SDL_LogError(SDL_LOG_CATEGORY_GPU, "SDL_SetGPUSwapchainParameters() in set_present_mode(): %s\n", SDL_GetError());
+        mode = app->present_mode;
+    }
+
+    app->present_mode = mode;
+    app->options.present_mode = mode;
+}
+
+static void process_requests(Application *app) {
+    const SnapshotInfo info = snapshot_info(app);
+    if (app->options.generate && !app->replay.open) TRACE_SCOPE("generate_bodies") {
+        BodyTable bodies;
+        if (generate_bodies(&app->options.generator, &app->sim.options, &bodies)) {
+            if (app->options.replace_bodies) clear_bodies(app);
+            add_bodies(app, &bodies);
+            body_table_free(&bodies);
+        }
+    }
+
+    if (app->options.import_bodies && !app->replay.open) TRACE_SCOPE("import_csv") {
+        BodyTable bodies;
+        if (import_csv(app->options.import_path, &bodies)) {
+            if (app->options.replace_bodies) clear_bodies(app);
+            add_bodies(app, &bodies);
+            body_table_free(&bodies);
+        }
+    }
+
+    if (app->options.save_snapshot) TRACE_SCOPE("snapshot_save") snapshot_save(app->options.snapshot_path, &info);
+    // an open replay keeps uploading its own body count into the buffers and restores it on close, like generating and importing
+    app->options.load_snapshot = app->options.load_snapshot && !app->replay.open;
+    if (app->options.load_snapshot) TRACE_SCOPE("snapshot_load") snapshot_load(app->options.snapshot_path, &info);
+    if (app->options.load_snapshot || app->options.toggle_replay) history_clear(&app->history);
+    if (app->options.load_snapshot || app->options.toggle_replay || app->options.rewind) diagnostics_reset(&app->diag);
+    if (app->options.toggle_recording && app->rec.recording) TRACE_SCOPE("recorder_stop") recorder_stop(&app->rec, app->gpu);
+    else if (app->options.toggle_recording) TRACE_SCOPE("recorder_start") recorder_start(&app->rec, &(RecorderStartInfo) {
+        .path = app->options.recording_path,
+        .interval = app->options.record_interval,
+        .keyframe_interval = app->options.keyframe_interval,
+        .delta_time = app->options.fixed_delta_time,
+        .snapshot = &info,
+    });
+
+    if (app->options.toggle_export && app->exporter.exporting) TRACE_SCOPE("exporter_stop") exporter_stop(&app->exporter, app->gpu);
+    else if (app->options.toggle_export) TRACE_SCOPE("exporter_start") exporter_start(&app->exporter, app->gpu, &(ExporterStartInfo) {
+        .path = app->options.export_path,
+        .format = app->options.export_format,
+        .width = app->options.export_width,
+        .height = app->options.export_height,
+        .interval = app->options.export_interval,
+        .texture_format = app->gfx.format,
+        .step = app->sim.step,
+    });
+
+    if (app->options.present_mode != app->present_mode) set_present_mode(app, app->options.present_mode);
+    if (app->options.toggle_replay && app->replay.open) TRACE_SCOPE("replay_close") replay_close(&app->replay, &info);
+    else if (app->options.toggle_replay) TRACE_SCOPE("replay_open") replay_open(&app->replay, app->options.replay_path, &info);
+    if (app->options.load_snapshot || app->options.toggle_replay) app->options.trail_length = app->trails.length;
+    process_tracking(app);
+
+    app->options.save_snapshot = false;
+    app->options.load_snapshot = false;
+    app->options.toggle_recording = false;
+    app->options.toggle_export = false;
+    app->options.toggle_replay = false;
+    app->options.generate = false;
+    app->options.import_bodies = false;
+}
+
 void SDL_AppQuit(void *appstate, const SDL_AppResult result) {
     UNUSED(result);
-    const Application *app = appstate;
+    Application *app = appstate;
+    if (!app) return;
+    if (!app->gpu) {
+        SDL_free(app);
+        SDL_Quit();
+        return;
+    }
 
     SDL_WaitForGPUIdle(app->gpu);
-    SDL_ReleaseWindowFromGPUDevice(app->gpu, app->window);
-
+    recorder_free(&app->rec, app->gpu);
+    exporter_free(&app->exporter, app->gpu);
+    replay_free(&app->replay, app->gpu);
+    history_free(&app->history, app->gpu);
+    diagnostics_free(&app->diag, app->gpu);
     simulation_free(&app->sim, app->gpu);
     trails_free(&app->trails, app->gpu);
-    trajectories_free(&app->trajectories, app->gpu);
+    tracking_free(&app->tracking, app->gpu);
+    appearance_free(&app->appearance, app->gpu);
     graphics_free(&app->gfx, app->gpu);
+    SDL_ReleaseWindowFromGPUDevice(app->gpu, app->window);
+    trajectories_free(&app->trajectories, app->gpu);
     gui_free();
-
     SDL_DestroyWindow(app->window);
+
     SDL_DestroyGPUDevice(app->gpu);
+    SDL_free(app);
     SDL_Quit();
 }
 
@@ -0,0 +1,174 @@
+#include "readback.h"
+
+#include "sdl_utils.h"
+
+void readback_init(Readback *rb, const u32 slot_count, const ReadbackRead read, void *user) {
+    *rb = (Readback) {
+        .slot_count = SDL_clamp(slot_count, 1, READBACK_SLOTS_MAX),
+        .read = read,
+        .user = user
+    };
+}
+
+static i32 readback_writer(void *data);
+// every slot must have been released, which readback_stop makes sure of
+bool readback_start(Readback *rb, const char *thread_name) {
+    rb->captured = rb->submitted = rb->released = 0;
+    SDL_SetAtomicU32(&rb->ready, 0);
+    SDL_SetAtomicU32(&rb->written, 0);
+    SDL_SetAtomicInt(&rb->stop, 0);
+
+    rb->wake = SDL_CreateSemaphore(0);
+    rb->writer = rb->wake ? SDL_CreateThread(readback_writer, thread_name, rb) : NULL;
+    if (!rb->writer) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "SDL_CreateThread() in readback_start(): %s\n", SDL_GetError());
+        if (rb->wake) SDL_DestroySemaphore(rb->wake);
+        rb->wake = NULL;
+        return false;
+    }
+
+    return true;
+}
+
+bool readback_available(const Readback *rb) {
+    return rb->captured - rb->released < rb->slot_count;
+}
+
+// grows the slot's transfer buffer to at least `size`, the old contents are gone
+bool readback_reserve(ReadbackSlot *slot, SDL_GPUDevice *gpu, const u32 size) {
+    if (slot->capacity >= size) return true;
+    if (slot->transfer_buffer) SDL_ReleaseGPUTransferBuffer(gpu, slot->transfer_buffer);
+    slot->capacity = SDL_max(size, 2 * slot->capacity);
+    slot->transfer_buffer = SDL_CreateGPUTransferBuffer(gpu, &(SDL_GPUTransferBufferCreateInfo) {
+        .size = slot->capacity,
+        .usage = SDL_GPU_TRANSFERBUFFERUSAGE_DOWNLOAD
+    });
+
+    if (!slot->transfer_buffer) {
+        SDL_LogError(SDL_LOG_CATEGORY_GPU, "SDL_CreateGPUTransferBuffer() in readback_reserve(): %s\n", SDL_GetError());
+        slot->capacity = 0;
+        return false;
+    }
+
+    return true;
+}
+
+ReadbackSlot *readback_next(Readback *rb) {
+    return readback_available(rb) ? &rb->slots[rb->captured % rb->slot_count] : NULL;
+}
+
+// call once the download into readback_next()'s slot is recorded, returns the slot's index
+u32 readback_capture(Readback *rb, const u32 size) {
+    const u32 index = rb->captured % rb->slot_count;
+    rb->slots[index].size = size;
+    rb->captured++;
+    return index;
+}
+
+// call after the command buffer holding this frame's captures has been submitted
+void readback_submit(Readback *rb, SDL_GPUDevice *gpu) {
+    if (rb->submitted == rb->captured) return;
+
+    SDL_GPUFence *fence = AcquireGPUFenceNow(gpu);
+    if (!fence) SDL_WaitForGPUIdle(gpu);
+    for (; rb->submitted != rb->captured; rb->submitted++) rb->slots[rb->submitted % rb->slot_count].fence = fence;
+}
+
+// the last of the slots sharing a fence releases it
+static void readback_release_fence(Readback *rb, SDL_GPUDevice *gpu, const u32 sequence) {
+    ReadbackSlot *slot = &rb->slots[sequence % rb->slot_count];
+    const ReadbackSlot *next = sequence + 1 != rb->submitted ? &rb->slots[(sequence + 1) % rb->slot_count] : NULL;
+    if (slot->fence && (!next || next->fence != slot->fence)) SDL_ReleaseGPUFence(gpu, slot->fence);
+    slot->fence = NULL;
+}
+
+// hands finished downloads to the writer and recycles slots it is done with, `wait` blocks until a slot is free
+void readback_poll(Readback *rb, SDL_GPUDevice *gpu, const bool wait) {
+    u32 ready = SDL_GetAtomicU32(&rb->ready);
+    const u32 previous = ready;
+    while (ready != rb->submitted) {
+        ReadbackSlot *slot = &rb->slots[ready % rb->slot_count];
+        if (slot->fence) {
+            if (wait) SDL_WaitForGPUFences(gpu, true, &slot->fence, 1);
+            else if (!SDL_QueryGPUFence(gpu, slot->fence)) break;
+        }
+
+        readback_release_fence(rb, gpu, ready);
+        slot->data = slot->size ? SDL_MapGPUTransferBuffer(gpu, slot->transfer_buffer, false) : NULL;
+        ready++;
+    }
+
+    if (ready != previous) {
+        SDL_SetAtomicU32(&rb->ready, ready);
+        if (rb->writer) SDL_SignalSemaphore(rb->wake);
+        else {
+            for (u32 i = previous; i != ready; i++) rb->read(rb->user, i % rb->slot_count, rb->slots[i % rb->slot_count].data);
+            SDL_SetAtomicU32(&rb->written, ready);
+        }
+    }
+
+    for (;;) {
+        const u32 written = SDL_GetAtomicU32(&rb->written);
+        while (rb->released != written) {
+            ReadbackSlot *slot = &rb->slots[rb->released % rb->slot_count];
+            if (slot->data) SDL_UnmapGPUTransferBuffer(gpu, slot->transfer_buffer);
+            slot->data = NULL;
+            rb->released++;
+        }
+
+        if (!wait || readback_available(rb)) break;
+        SDL_Delay(1);
+    }
+}
+
+static i32 readback_writer(void *data) {
+    Readback *rb = data;
+    u32 written = SDL_GetAtomicU32(&rb->written);
+    for (;;) {
+        // `stop` is only set after the final `ready`, so read it first
+        const bool stopping = SDL_GetAtomicInt(&rb->stop);
+        const u32 ready = SDL_GetAtomicU32(&rb->ready);
+        if (written == ready) {
+            if (stopping) break;
+            SDL_WaitSemaphoreTimeout(rb->wake, 100);
+            continue;
+        }
+
+        const u32 index = written % rb->slot_count;
+        rb->read(rb->user, index, rb->slots[index].data);
+        SDL_SetAtomicU32(&rb->written, ++written);
+    }
+
+    return 0;
+}
+
+// reads everything still in flight and joins the writer, the transfer buffers are kept for the next start
+void readback_stop(Readback *rb, SDL_GPUDevice *gpu) {
+    readback_submit(rb, gpu);
+    readback_poll(rb, gpu, true);
+    if (rb->writer) {
+        SDL_SetAtomicInt(&rb->stop, 1);
+        SDL_SignalSemaphore(rb->wake);
+        SDL_WaitThread(rb->writer, NULL);
+        readback_poll(rb, gpu, false);
+    }
+
+    if (rb->wake) SDL_DestroySemaphore(rb->wake);
+    rb->wake = NULL;
+    rb->writer = NULL;
+}
+
+// drops whatever is still in flight unread, the writer must already be stopped
+void readback_free(Readback *rb, SDL_GPUDevice *gpu) {
+    for (u32 i = SDL_GetAtomicU32(&rb->ready); i != rb->submitted; i++) readback_release_fence(rb, gpu, i);
+    for (u32 i = 0; i < rb->slot_count; i++) {
+        ReadbackSlot *slot = &rb->slots[i];
+        if (slot->data) SDL_UnmapGPUTransferBuffer(gpu, slot->transfer_buffer);
+        if (slot->transfer_buffer) SDL_ReleaseGPUTransferBuffer(gpu, slot->transfer_buffer);
+        *slot = (ReadbackSlot) { 0 };
+    }
+
+    rb->captured = rb->submitted = rb->released = 0;
+    SDL_SetAtomicU32(&rb->ready, 0);
+    SDL_SetAtomicU32(&rb->written, 0);
+}
@@ -0,0 +1,171 @@
+#include "recorder.h"
+#include "tracer.h"
+
+#include "sdl_utils.h"
+#include "stb_ds.h"
+
+static void recorder_write_frame(void *data, u32 index, const u8 *frame_data);
+void recorder_init(Recorder *rec) {
+    *rec = (Recorder) { 0 };
+    readback_init(&rec->readback, RECORDER_SLOTS, recorder_write_frame, rec);
+}
+
+bool recorder_start(Recorder *rec, const RecorderStartInfo *info) {
+    if (rec->recording) return false;
+
+    rec->io = SDL_IOFromFile(info->path, "wb");
+    if (!rec->io) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "SDL_IOFromFile() in recorder_start(): Couldn't open %s.\n", info->path);
+        return false;
+    }
+
+    rec->header = (RecordingHeader) {
+        .magic = RECORDING_MAGIC,
+        .version = RECORDING_VERSION,
+        .header_size = sizeof(RecordingHeader),
+        .interval = SDL_max(info->interval, 1),
+        .keyframe_interval = SDL_max(info->keyframe_interval, 1),
+        .delta_time = info->delta_time,
+        .snapshot_offset = sizeof(RecordingHeader),
+    };
+
+    // the starting state is a regular snapshot, so a recording can be loaded like one
+    const bool written = SDL_WriteIO(rec->io, &rec->header, sizeof(rec->header)) == sizeof(rec->header)
+        && snapshot_write(rec->io, info->snapshot);
+
+    if (!written) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "SDL_WriteIO() in recorder_start(): %s\n", SDL_GetError());
+        SDL_CloseIO(rec->io);
+        rec->io = NULL;
+        return false;
+    }
+
+    rec->offset = (u64) SDL_TellIO(rec->io);
+    rec->header.snapshot_size = rec->offset - rec->header.snapshot_offset;
+    rec->interval = rec->header.interval;
+    rec->keyframe_interval = rec->header.keyframe_interval;
+    rec->next_step = info->snapshot->sim->step + rec->interval;
+    rec->frames = 0;
+    rec->dropped = 0;
+    rec->index = NULL;
+    SDL_SetAtomicInt(&rec->failed, 0);
+
+    if (!readback_start(&rec->readback, "recorder")) {
+        SDL_CloseIO(rec->io);
+        rec->io = NULL;
+        return false;
+    }
+
+    rec->recording = true;
+    return true;
+}
+
+bool recorder_due(const Recorder *rec, const Simulation *sim) {
+    return rec->recording && sim->step >= rec->next_step;
+}
+
+bool recorder_available(const Recorder *rec) {
+    return !rec->recording || readback_available(&rec->readback);
+}
+
+// records the download into `command_buffer`, which must not have a pass open
+void recorder_capture(Recorder *rec, SDL_GPUDevice *gpu, SDL_GPUCommandBuffer *command_buffer, const Simulation *sim) {
+    if (!recorder_due(rec, sim)) return;
+    rec->next_step = sim->step + rec->interval;
+
+    // never wait on the writer here, a full ring means the disk can't keep up
+    if (!recorder_available(rec)) {
+        rec->dropped++;
+        return;
+    }
+
+    const bool keyframe = rec->frames % rec->keyframe_interval == 0;
+    const u32 positions_size = sim->body_count * (u32) sizeof(HMM_Vec2);
+    const u32 size = keyframe ? 2 * positions_size : positions_size;
+
+    ReadbackSlot *slot = readback_next(&rec->readback);
+    if (!readback_reserve(slot, gpu, size)) {
+        rec->dropped++;
+        return;
+    }
+
+    if (size) {
+        SDL_GPUCopyPass *copy_pass = SDL_BeginGPUCopyPass(command_buffer);
+        DownloadFromGPUBuffers(copy_pass, slot->transfer_buffer, (ReadGPUBufferBinding[]) {
+            { .buffer = sim->positions.buffer, .size = positions_size, .destination_offset = 0 },
+            { .buffer = sim->velocities.buffer, .size = positions_size, .destination_offset = positions_size },
+        }, keyframe ? 2 : 1);
+        SDL_EndGPUCopyPass(copy_pass);
+    }
+
+    const u32 index = readback_capture(&rec->readback, size);
+    rec->captures[index] = (RecordingFrame) {
+        .step = sim->step,
+        .body_count = sim->body_count,
+        .flags = keyframe ? RECORDING_FRAME_KEYFRAME : 0
+    };
+
+    rec->frames++;
+}
+
+void recorder_submit(Recorder *rec, SDL_GPUDevice *gpu) {
+    readback_submit(&rec->readback, gpu);
+}
+
+void recorder_poll(Recorder *rec, SDL_GPUDevice *gpu, const bool wait) {
+    readback_poll(&rec->readback, gpu, wait);
+}
+
+// on the writer thread
+static void recorder_write_frame(void *data, const u32 index, const u8 *frame_data) {
+    Recorder *rec = data;
+    const RecordingFrame *frame = &rec->captures[index];
+    const usize positions_size = frame->body_count * sizeof(HMM_Vec2);
+    const usize data_size = frame->flags & RECORDING_FRAME_KEYFRAME ? 2 * positions_size : positions_size;
+
+    bool written = false;
+    TRACE_SCOPE("recorder_write_frame") written = (data_size == 0 || frame_data)
+        && SDL_WriteIO(rec->io, frame, sizeof(*frame)) == sizeof(*frame)
+        && (data_size == 0 || SDL_WriteIO(rec->io, frame_data, data_size) == data_size);
+
+    if (!written) {
+        if (!SDL_GetAtomicInt(&rec->failed)) SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "SDL_WriteIO() in recorder_write_frame(): %s\n", SDL_GetError());
+        SDL_SetAtomicInt(&rec->failed, 1);
+        return;
+    }
+
+    arrput(rec->index, ((RecordingIndexEntry) {
+        .step = frame->step,
+        .offset = rec->offset,
+        .body_count = frame->body_count,
+        .flags = frame->flags
+    }));
+
+    rec->offset += sizeof(*frame) + data_size;
+}
+
+void recorder_stop(Recorder *rec, SDL_GPUDevice *gpu) {
+    if (!rec->recording) return;
+
+    readback_stop(&rec->readback, gpu);
+    rec->header.index_offset = rec->offset;
+    rec->header.frame_count = (u64) arrlen(rec->index);
+    const usize index_size = sizeof(RecordingIndexEntry) * arrlen(rec->index);
+    const bool finished = !SDL_GetAtomicInt(&rec->failed)
+        && (index_size == 0 || SDL_WriteIO(rec->io, rec->index, index_size) == index_size)
+        && SDL_SeekIO(rec->io, 0, SDL_IO_SEEK_SET) == 0
+        && SDL_WriteIO(rec->io, &rec->header, sizeof(rec->header)) == sizeof(rec->header);
+
+    if (!finished) SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "recorder_stop(): Couldn't finish the recording, it has no index.\n");
+    else SDL_Log("Recorded %" SDL_PRIu64 " frames (%" SDL_PRIu64 " dropped).\n", rec->header.frame_count, rec->dropped);
+
+    SDL_CloseIO(rec->io);
+    arrfree(rec->index);
+    rec->io = NULL;
+    rec->recording = false;
+}
+
+void recorder_free(Recorder *rec, SDL_GPUDevice *gpu) {
+    recorder_stop(rec, gpu);
+    readback_free(&rec->readback, gpu);
+}
@@ -0,0 +1,311 @@
+#include "replay.h"
+#include "trails.h"
+#include "trajectories.h"
+#include "tracer.h"
+
+#include "sdl_utils.h"
+#include "stb_ds.h"
+
+void replay_init(Replay *replay) {
+    *replay = (Replay) { .speed = 1.0f };
+}
+
+// recordings that were not stopped cleanly have no index, rebuild it from the frame headers
+static bool replay_scan_index(Replay *replay) {
+    const i64 file_size = SDL_GetIOSize(replay->io);
+    u64 offset = replay->header.snapshot_offset + replay->header.snapshot_size;
+    RecordingFrame frame;
+    while (SDL_SeekIO(replay->io, (i64) offset, SDL_IO_SEEK_SET) >= 0 && SDL_ReadIO(replay->io, &frame, sizeof(frame)) == sizeof(frame)) {
+        const u64 size = sizeof(frame) + (u64) frame.body_count * sizeof(HMM_Vec2) * (frame.flags & RECORDING_FRAME_KEYFRAME ? 2 : 1);
+        if (file_size >= 0 && offset + size > (u64) file_size) break;
+
+        arrput(replay->index, ((RecordingIndexEntry) {
+            .step = frame.step,
+            .offset = offset,
+            .body_count = frame.body_count,
+            .flags = frame.flags
+        }));
+
+        offset += size;
+    }
+
+    replay->header.frame_count = (u64) arrlen(replay->index);
+    return true;
+}
+
+// an index that doesn't fit in the file is treated like a missing one
+static bool replay_read_index(Replay *replay) {
+    const i64 file_size = SDL_GetIOSize(replay->io);
+    const u64 offset = replay->header.index_offset, count = replay->header.frame_count;
+    const bool fits = file_size >= 0 && offset <= (u64) file_size
+        && count <= ((u64) file_size - offset) / sizeof(RecordingIndexEntry);
+
+    if (offset == 0 || !fits) {
+        if (offset != 0) SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "replay_read_index(): The index is damaged, rebuilding it.\n");
+        return replay_scan_index(replay);
+    }
+
+    arrsetlen(replay->index, count);
+    const usize size = sizeof(RecordingIndexEntry) * count;
+    if (SDL_SeekIO(replay->io, (i64) offset, SDL_IO_SEEK_SET) >= 0 && (size == 0 || SDL_ReadIO(replay->io, replay->index, size) == size)) return true;
+
+    arrfree(replay->index);
+    return replay_scan_index(replay);
+}
+
+static i32 replay_loader(void *data);
+bool replay_open(Replay *replay, const char *path, const SnapshotInfo *info) {
+    if (replay->open) return false;
+
+    replay->io = SDL_IOFromFile(path, "rb");
+    if (!replay->io) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "SDL_IOFromFile() in replay_open(): Couldn't open %s.\n", path);
+        return false;
+    }
+
+    const bool valid = SDL_ReadIO(replay->io, &replay->header, sizeof(replay->header)) == sizeof(replay->header)
+        && replay->header.magic == RECORDING_MAGIC
+        && replay->header.version == RECORDING_VERSION
+        && replay->header.header_size == sizeof(RecordingHeader)
+        && replay->header.interval > 0
+        && replay->header.delta_time > 0.0f;
+
+    if (!valid) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "replay_open(): %s is not a version %d recording.\n", path, RECORDING_VERSION);
+        SDL_CloseIO(replay->io);
+        replay->io = NULL;
+        return false;
+    }
+
+    // the starting state brings masses, colors and options along with it
+    const bool loaded = SDL_SeekIO(replay->io, (i64) replay->header.snapshot_offset, SDL_IO_SEEK_SET) >= 0
+        && snapshot_read(replay->io, info)
+        && replay_read_index(replay);
+
+    if (!loaded) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "replay_open(): Couldn't read %s.\n", path);
+        SDL_CloseIO(replay->io);
+        arrfree(replay->index);
+        replay->io = NULL;
+        return false;
+    }
+
+    replay->body_count = info->sim->body_count;
+    replay->position = 0.0;
+    replay->shown = (u64) -1;
+    replay->seek = true;
+    for (u32 i = 0; i < REPLAY_BUFFERS; i++) SDL_SetAtomicInt(&replay->buffers[i].state, REPLAY_BUFFER_EMPTY);
+
+    // predictions need velocities, which only keyframes have
+    replay->trajectories_enabled = info->trajectories->enabled;
+    info->trajectories->enabled = false;
+
+    SDL_SetAtomicInt(&replay->stop, 0);
+    replay->wake = SDL_CreateSemaphore(0);
+    replay->loader = replay->wake ? SDL_CreateThread(replay_loader, "replay", replay) : NULL;
+    if (!replay->loader) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "SDL_CreateThread() in replay_open(): %s\n", SDL_GetError());
+        if (replay->wake) SDL_DestroySemaphore(replay->wake);
+        SDL_CloseIO(replay->io);
+        arrfree(replay->index);
+        replay->wake = NULL;
+        replay->io = NULL;
+        info->trajectories->enabled = replay->trajectories_enabled;
+        return false;
+    }
+
+    replay->open = true;
+    return true;
+}
+
+static bool replay_read_frame(Replay *replay, ReplayBuffer *buffer) {
+    const RecordingIndexEntry *entry = &replay->index[buffer->frame];
+    buffer->size = (usize) entry->body_count * sizeof(HMM_Vec2);
+    if (buffer->capacity < buffer->size) {
+        SDL_free(buffer->data);
+        buffer->capacity = buffer->size;
+        buffer->data = SDL_malloc(buffer->capacity);
+        if (!buffer->data) buffer->capacity = 0;
+    }
+
+    if (!buffer->data && buffer->size) return false;
+    return SDL_SeekIO(replay->io, (i64) (entry->offset + sizeof(RecordingFrame)), SDL_IO_SEEK_SET) >= 0
+        && (buffer->size == 0 || SDL_ReadIO(replay->io, buffer->data, buffer->size) == buffer->size);
+}
+
+static i32 replay_loader(void *data) {
+    Replay *replay = data;
+    while (!SDL_GetAtomicInt(&replay->stop)) {
+        bool idle = true;
+        for (u32 i = 0; i < REPLAY_BUFFERS; i++) {
+            ReplayBuffer *buffer = &replay->buffers[i];
+            if (SDL_GetAtomicInt(&buffer->state) != REPLAY_BUFFER_REQUESTED) continue;
+
+            bool read = false;
+            TRACE_SCOPE("replay_read_frame") read = replay_read_frame(replay, buffer);
+            if (!read) {
+                SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "SDL_ReadIO() in replay_loader(): Couldn't read frame %" SDL_PRIu64 ".\n", buffer->frame);
+                buffer->size = 0;
+            }
+
+            SDL_SetAtomicInt(&buffer->state, REPLAY_BUFFER_READY);
+            idle = false;
+        }
+
+        if (idle) SDL_WaitSemaphoreTimeout(replay->wake, 100);
+    }
+
+    return 0;
+}
+
+static ReplayBuffer *replay_find_buffer(Replay *replay, const u64 frame) {
+    for (u32 i = 0; i < REPLAY_BUFFERS; i++) {
+        ReplayBuffer *buffer = &replay->buffers[i];
+        if (SDL_GetAtomicInt(&buffer->state) != REPLAY_BUFFER_EMPTY && buffer->frame == frame) return buffer;
+    }
+
+    return NULL;
+}
+
+static void replay_request(Replay *replay, const u64 frame) {
+    if (frame >= replay->header.frame_count || frame == replay->shown || replay_find_buffer(replay, frame)) return;
+    for (u32 i = 0; i < REPLAY_BUFFERS; i++) {
+        ReplayBuffer *buffer = &replay->buffers[i];
+        if (SDL_GetAtomicInt(&buffer->state) != REPLAY_BUFFER_EMPTY) continue;
+
+        buffer->frame = frame;
+        SDL_SetAtomicInt(&buffer->state, REPLAY_BUFFER_REQUESTED);
+        SDL_SignalSemaphore(replay->wake);
+        return;
+    }
+}
+
+static void replay_upload(Replay *replay, SDL_GPUDevice *gpu, SDL_GPUCopyPass *copy_pass, const Simulation *sim, const ReplayBuffer *buffer) {
+    // bodies added while recording have no masses or colors in the starting snapshot, so they are left out
+    const u32 size = (u32) SDL_min(buffer->size, (usize) replay->body_count * sizeof(HMM_Vec2));
+    if (size == 0) return;
+
+    if (replay->transfer_capacity < size) {
+        if (replay->transfer_buffer) SDL_ReleaseGPUTransferBuffer(gpu, replay->transfer_buffer);
+        replay->transfer_capacity = size;
+        replay->transfer_buffer = SDL_CreateGPUTransferBuffer(gpu, &(SDL_GPUTransferBufferCreateInfo) {
+            .size = size,
+            .usage = SDL_GPU_TRANSFERBUFFERUSAGE_UPLOAD
+        });
+    }
+
+    u8 *data_map = SDL_MapGPUTransferBuffer(gpu, replay->transfer_buffer, true);
+    if (!data_map) return;
+    SDL_memcpy(data_map, buffer->data, size);
+    SDL_UnmapGPUTransferBuffer(gpu, replay->transfer_buffer);
+
+    SDL_UploadToGPUBuffer(
+        copy_pass,
+        &(SDL_GPUTransferBufferLocation) { .transfer_buffer = replay->transfer_buffer, .offset = 0 },
+        &(SDL_GPUBufferRegion) { .buffer = sim->positions.buffer, .offset = 0, .size = size },
+        false
+    );
+}
+
+// plays back at the rate the recording was simulated, returns whether a new frame was uploaded
+bool replay_update(Replay *replay, SDL_GPUDevice *gpu, SDL_GPUCopyPass *copy_pass, Simulation *sim, Trails *trails, const f32 delta_time) {
+    if (!replay->open || replay->header.frame_count == 0) return false;
+
+    const f64 last = (f64) (replay->header.frame_count - 1);
+    if (!sim->options.paused) replay->position += delta_time / (replay->header.interval * replay->header.delta_time) * replay->speed;
+    if (replay->position >= last) sim->options.paused = true;
+    replay->position = SDL_clamp(replay->position, 0.0, last);
+    const u64 target = (u64) replay->position;
+
+    // drop frames that were prefetched for a position we seeked away from
+    for (u32 i = 0; i < REPLAY_BUFFERS; i++) {
+        ReplayBuffer *buffer = &replay->buffers[i];
+        if (SDL_GetAtomicInt(&buffer->state) == REPLAY_BUFFER_READY && buffer->frame != target && buffer->frame != target + 1) {
+            SDL_SetAtomicInt(&buffer->state, REPLAY_BUFFER_EMPTY);
+        }
+    }
+
+    bool uploaded = false;
+    ReplayBuffer *buffer = replay_find_buffer(replay, target);
+    if (target != replay->shown && buffer && SDL_GetAtomicInt(&buffer->state) == REPLAY_BUFFER_READY) {
+        replay_upload(replay, gpu, copy_pass, sim, buffer);
+        SDL_SetAtomicInt(&buffer->state, REPLAY_BUFFER_EMPTY);
+        sim->step = replay->index[target].step;
+        replay->shown = target;
+        uploaded = true;
+
+        if (replay->seek) trails->reset_from = 0;
+        replay->seek = false;
+    }
+
+    replay_request(replay, target);
+    replay_request(replay, target + 1);
+    return uploaded;
+}
+
+// leaves the simulation at the last keyframe at or before the shown frame, so it can carry on from there
+void replay_close(Replay *replay, const SnapshotInfo *info) {
+    if (!replay->open) return;
+
+    SDL_SetAtomicInt(&replay->stop, 1);
+    SDL_SignalSemaphore(replay->wake);
+    SDL_WaitThread(replay->loader, NULL);
+
+    u64 keyframe = replay->shown < replay->header.frame_count ? replay->shown : 0;
+    while (keyframe > 0 && !(replay->index[keyframe].flags & RECORDING_FRAME_KEYFRAME)) keyframe--;
+
+    if (replay->header.frame_count && replay->index[keyframe].flags & RECORDING_FRAME_KEYFRAME) {
+        const RecordingIndexEntry *entry = &replay->index[keyframe];
+        const u32 body_count = SDL_min(entry->body_count, replay->body_count);
+        const usize stride = (usize) entry->body_count * sizeof(HMM_Vec2);
+        u8 *data = SDL_malloc(2 * stride + 1);
+
+        if (data && SDL_SeekIO(replay->io, (i64) (entry->offset + sizeof(RecordingFrame)), SDL_IO_SEEK_SET) >= 0 && SDL_ReadIO(replay->io, data, 2 * stride) == 2 * stride) {
+            SDL_GPUCommandBuffer *command_buffer = SDL_AcquireGPUCommandBuffer(info->gpu);
+            SDL_GPUCopyPass *copy_pass = SDL_BeginGPUCopyPass(command_buffer);
+            WriteToGPUBuffers(info->gpu, copy_pass, (WriteGPUBufferBinding[]) {
+                { .buffer = info->sim->positions.buffer, .source = data, .size = body_count * (u32) sizeof(HMM_Vec2) },
+                { .buffer = info->sim->velocities.buffer, .source = data + stride, .size = body_count * (u32) sizeof(HMM_Vec2) },
+            }, body_count ? 2 : 0);
+            SDL_EndGPUCopyPass(copy_pass);
+            SDL_SubmitGPUCommandBuffer(command_buffer);
+
+            info->sim->step = entry->step;
+            info->trails->reset_from = 0;
+        }
+
+        SDL_free(data);
+    }
+
+    info->trajectories->enabled = replay->trajectories_enabled;
+    info->sim->options.paused = true;
+
+    SDL_CloseIO(replay->io);
+    SDL_DestroySemaphore(replay->wake);
+    arrfree(replay->index);
+    replay->io = NULL;
+    replay->wake = NULL;
+    replay->loader = NULL;
+    replay->open = false;
+}
+
+void replay_free(Replay *replay, SDL_GPUDevice *gpu) {
+    if (replay->open) {
+        SDL_SetAtomicInt(&replay->stop, 1);
+        SDL_SignalSemaphore(replay->wake);
+        SDL_WaitThread(replay->loader, NULL);
+        SDL_CloseIO(replay->io);
+        SDL_DestroySemaphore(replay->wake);
+        arrfree(replay->index);
+        replay->open = false;
+    }
+
+    for (u32 i = 0; i < REPLAY_BUFFERS; i++) {
+        SDL_free(replay->buffers[i].data);
+        replay->buffers[i] = (ReplayBuffer) { 0 };
+    }
+
+    if (replay->transfer_buffer) SDL_ReleaseGPUTransferBuffer(gpu, replay->transfer_buffer);
+    replay->transfer_buffer = NULL;
+    replay->transfer_capacity = 0;
+}
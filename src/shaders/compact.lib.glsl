@@ -0,0 +1,16 @@
+// Trail and prediction point storage. COMPACT keeps each point as a half precision offset from a full precision
+// anchor stored elsewhere, which halves their memory. Declare the point buffers with POINT as the element type.
+
+#ifndef COMPACT
+#define COMPACT 0
+#endif
+
+#if COMPACT
+#define POINT uint
+#define ENCODE_POINT(position, anchor) packHalf2x16((position) - (anchor))
+#define DECODE_POINT(point, anchor) ((anchor) + unpackHalf2x16(point))
+#else
+#define POINT vec2
+#define ENCODE_POINT(position, anchor) (position)
+#define DECODE_POINT(point, anchor) (point)
+#endif
@@ -0,0 +1,102 @@
+#version 460
+#extension GL_GOOGLE_include_directive : require
+
+#ifndef WORKGROUP_SIZE
+#define WORKGROUP_SIZE 64
+#endif
+
+// body culling as a stable stream compaction, so visible bodies keep their draw order and overlaps don't flicker:
+// CULL_STAGE 0 counts the visible bodies of each workgroup, 1 turns the counts into offsets and writes the
+// indirect draw arguments, 2 scatters the visible indices to their offsets
+#ifndef CULL_STAGE
+#define CULL_STAGE 0
+#endif
+
+#if CULL_STAGE != 1
+#include "render.lib.glsl"
+layout (std430, set = 0, binding = 0) readonly buffer Positions { vec2 positions[]; };
+layout (std430, set = 0, binding = 1) readonly buffer Render { uvec2 render[]; };
+#endif
+
+layout (std430, set = 1, binding = 0) buffer Groups { uint groups[]; };
+#if CULL_STAGE == 1
+layout (std430, set = 1, binding = 1) writeonly buffer Arguments {
+    uint vertex_count;
+    uint instance_count;
+    uint first_vertex;
+    uint first_instance;
+};
+#elif CULL_STAGE == 2
+layout (std430, set = 1, binding = 1) writeonly buffer Visible { uint visible[]; };
+#endif
+
+layout (std140, set = 2, binding = 0) uniform Constants {
+    mat4 orthographic;
+    mat4 view;
+    uint body_count;
+    float splat_radius; // pixels, smaller bodies are left to splat.comp.glsl
+    float viewport_width;
+};
+
+shared uint scan[WORKGROUP_SIZE];
+
+// inclusive prefix sum over the workgroup, returns it for this invocation
+uint workgroup_scan(uint value) {
+    uint local = gl_LocalInvocationID.x;
+    scan[local] = value;
+    barrier();
+
+    for (uint offset = 1; offset < WORKGROUP_SIZE; offset *= 2) {
+        uint other = local >= offset ? scan[local - offset] : 0;
+        barrier();
+        scan[local] += other;
+        barrier();
+    }
+
+    return scan[local];
+}
+
+#if CULL_STAGE != 1
+// the quad body.vert.glsl would emit, tested against the clip volume
+bool body_visible(uint i) {
+    if (i >= body_count) return false;
+    mat4 transform = orthographic * view;
+    float radius = unpack_render(render[i]).radius;
+    vec2 center = (transform * vec4(positions[i], 0.0, 1.0)).xy;
+    vec2 extent = radius * (abs(transform[0].xy) + abs(transform[1].xy));
+    float pixels = radius * length(transform[0].xy) * 0.5 * viewport_width;
+    return pixels >= splat_radius && all(lessThanEqual(abs(center), vec2(1.0) + extent));
+}
+#endif
+
+layout (local_size_x = WORKGROUP_SIZE, local_size_y = 1, local_size_z = 1) in;
+void main() {
+#if CULL_STAGE == 0
+    uint total = workgroup_scan(body_visible(gl_GlobalInvocationID.x) ? 1 : 0);
+    if (gl_LocalInvocationID.x == WORKGROUP_SIZE - 1) groups[gl_WorkGroupID.x] = total;
+#elif CULL_STAGE == 1
+    // a single workgroup walks the counts in chunks, carrying the running total
+    uint group_count = (body_count + WORKGROUP_SIZE - 1) / WORKGROUP_SIZE;
+    uint carry = 0;
+    for (uint base = 0; base < group_count; base += WORKGROUP_SIZE) {
+        uint i = base + gl_LocalInvocationID.x;
+        uint count = i < group_count ? groups[i] : 0;
+        uint inclusive = workgroup_scan(count);
+        if (i < group_count) groups[i] = carry + inclusive - count;
+        carry += scan[WORKGROUP_SIZE - 1];
+        barrier();
+    }
+
+    if (gl_LocalInvocationID.x == 0) {
+        vertex_count = 4;
+        instance_count = carry;
+        first_vertex = 0;
+        first_instance = 0;
+    }
+#else
+    uint i = gl_GlobalInvocationID.x;
+    bool keep = body_visible(i);
+    uint inclusive = workgroup_scan(keep ? 1 : 0);
+    if (keep) visible[groups[gl_WorkGroupID.x] + inclusive - 1] = i;
+#endif
+}
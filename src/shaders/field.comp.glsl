@@ -0,0 +1,120 @@
+#version 460
+#extension GL_GOOGLE_include_directive : require
+
+#ifndef WORKGROUP_SIZE
+#define WORKGROUP_SIZE 64
+#endif
+
+// the gravitational field on a screen aligned grid: FIELD_STAGE 0 has every workgroup check its bodies against the
+// positions the grid was evaluated with and OR into this frame's stale flag, 1 re-anchors the bodies if any moved too far
+// and writes the indirect dispatch for 2, which evaluates potential and acceleration at every point
+#ifndef FIELD_STAGE
+#define FIELD_STAGE 0
+#endif
+
+layout (std430, set = 0, binding = 0) readonly buffer Positions { vec2 r[]; };
+#if FIELD_STAGE < 2
+#if FIELD_STAGE == 0
+layout (std430, set = 0, binding = 1) readonly buffer Anchors { vec2 anchors[]; }; // positions the grid was last evaluated with
+layout (std430, set = 1, binding = 0) buffer Arguments { uint groups[3]; uint stale[2]; };
+#else
+layout (std430, set = 1, binding = 0) buffer Anchors { vec2 anchors[]; };
+layout (std430, set = 1, binding = 1) writeonly buffer Range { uint range[2]; };
+layout (std430, set = 1, binding = 2) buffer Arguments { uint groups[3]; uint stale[2]; }; // SDL_GPUIndirectDispatchCommand, then the flags
+#endif
+
+// the flags alternate between frames, so the one a frame ORs into was cleared by the frame before it
+layout (std140, set = 2, binding = 0) uniform Constants {
+    uint body_count;
+    float threshold; // world units a body may move before the grid is re-evaluated
+    uint force; // the grid itself changed
+    uint group_count;
+    uint parity;
+};
+
+#if FIELD_STAGE == 0
+shared float moved[WORKGROUP_SIZE];
+#endif
+#else
+layout (std430, set = 0, binding = 1) readonly buffer Masses { float m[]; };
+layout (std430, set = 1, binding = 0) writeonly buffer Samples { vec4 samples[]; }; // acceleration, potential
+layout (std430, set = 1, binding = 1) buffer Range { uint range[2]; }; // max |potential| and |acceleration| as float bits
+
+layout (std140, set = 2, binding = 0) uniform Constants {
+    uint body_count;
+    float G;
+    float ee;
+    uint columns;
+    uint rows;
+    float cell;
+    vec2 origin;
+};
+
+#define SOURCE_POSITION(i) r[i]
+#include "gravity.lib.glsl"
+
+shared vec2 tile_r[WORKGROUP_SIZE];
+shared float tile_m[WORKGROUP_SIZE];
+#endif
+
+layout (local_size_x = WORKGROUP_SIZE, local_size_y = 1, local_size_z = 1) in;
+void main() {
+    uint local = gl_LocalInvocationID.x;
+#if FIELD_STAGE == 0
+    uint i = gl_GlobalInvocationID.x;
+    moved[local] = i < body_count ? distance(r[i], anchors[i]) : 0.0;
+    barrier();
+
+    for (uint stride = WORKGROUP_SIZE / 2; stride > 0; stride /= 2) {
+        if (local < stride) moved[local] = max(moved[local], moved[local + stride]);
+        barrier();
+    }
+
+    if (local == 0 && (force != 0 || moved[0] > threshold)) atomicOr(stale[parity], 1u);
+#elif FIELD_STAGE == 1
+    uint i = gl_GlobalInvocationID.x;
+    bool refresh = stale[parity] != 0;
+    if (refresh && i < body_count) anchors[i] = r[i];
+    if (i == 0) {
+        groups[0] = refresh ? group_count : 0;
+        groups[1] = 1;
+        groups[2] = 1;
+        stale[1 - parity] = 0;
+        if (refresh) {
+            range[0] = 0;
+            range[1] = 0;
+        }
+    }
+#else
+    // the same tiles as the diagnostics, every body is staged in shared memory once per workgroup
+    uint i = gl_GlobalInvocationID.x;
+    bool active = i < columns * rows;
+    vec2 point = origin + vec2(i % columns, i / columns) * cell;
+
+    vec2 a = vec2(0.0);
+    float potential = 0.0;
+    for (uint tile = 0; tile < body_count; tile += WORKGROUP_SIZE) {
+        uint j = tile + local;
+        tile_r[local] = j < body_count ? r[j] : vec2(0.0);
+        tile_m[local] = j < body_count ? m[j] : 0.0;
+        barrier();
+
+        for (uint k = 0; k < WORKGROUP_SIZE; k++) {
+            vec2 R = tile_r[k] - point;
+            if (tile_m[k] == 0.0 || R == vec2(0.0)) continue;
+            a += pair_acceleration(R, tile_m[k]);
+            potential += tile_m[k] * pair_potential(length(R));
+        }
+
+        barrier();
+    }
+
+    if (!active) return;
+    potential *= G;
+    samples[i] = vec4(a, potential, 0.0);
+
+    // non-negative floats order like their bits, so the ranges can use integer atomics
+    atomicMax(range[0], floatBitsToUint(abs(potential)));
+    atomicMax(range[1], floatBitsToUint(length(a)));
+#endif
+}
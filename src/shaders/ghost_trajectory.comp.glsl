@@ -1,24 +1,24 @@
 #version 460
+#extension GL_GOOGLE_include_directive : require
 
-const uint PREDICTION_LENGTH = 2048;
-layout (std430, set = 0, binding = 0) buffer TrajectoryPositions { vec2 r[][PREDICTION_LENGTH]; };
-layout (std430, set = 0, binding = 1) buffer TrajectoryVelocities { vec2 v[]; };
-layout (std430, set = 0, binding = 2) buffer TrajectoryGhost { vec2 v_g; vec2 r_g[PREDICTION_LENGTH]; };
+#include "compact.lib.glsl"
+
+layout (std430, set = 0, binding = 0) buffer TrajectoryPositions { POINT r[]; };
+layout (std430, set = 0, binding = 1) buffer TrajectoryState { vec2 s[]; };
+layout (std430, set = 0, binding = 2) buffer TrajectoryGhost { vec2 v_g; vec2 r_g[]; };
 layout (std430, set = 0, binding = 3) readonly buffer Positions { vec2 r_0[]; };
 layout (std430, set = 0, binding = 4) readonly buffer Velocities { vec2 v_0[]; };
 layout (std430, set = 0, binding = 5) readonly buffer Masses { float m[]; };
 layout (std430, set = 0, binding = 6) readonly buffer Movable { float mov[]; };
-
-const uint EULER = 0;
-const uint VERLET = 1;
-const uint RK4 = 2;
+layout (std430, set = 0, binding = 7) readonly buffer Slots { uint slots[]; }; // body -> slot, see tracking.h
+layout (std430, set = 0, binding = 8) buffer Scratch { vec4 scratch[]; }; // Simulation.scratch, the ghost's is the last
 
 layout (std140, set = 2, binding = 0) uniform Constants {
     uint body_count;
-    uint integrator;
     float G;
     float ee;
     float dt;
+    uint prediction_length;
 };
 
 layout (std140, set = 2, binding = 1) uniform Ghost {
@@ -30,63 +30,29 @@ layout (std140, set = 2, binding = 1) uniform Ghost {
 
 layout (std140, set = 2, binding = 2) uniform Frame { uint frame; };
 
-vec2 gravity(vec2 r_self, uint frame) {
-    vec2 net_a = vec2(0.0);
-    for (uint i = 0; i < body_count; i++) {
-        vec2 R = r[i][frame] - r_self;
-        float R2 = dot(R, R) + ee * ee;
-        net_a += (G * m[i] / R2) * normalize(R);
-    }
-
-    return net_a;
-}
+#define SCRATCH(i, k) scratch[3 * (i) + (k)]
+#include "integrators.lib.glsl"
 
-struct State {
-    vec2 r;
-    vec2 v;
-};
+#if INTEGRATOR_STAGE == 0
+#define SOURCE_POSITION(i) s[3 * (i) + ((frame - 1) & 1)]
+#else
+#define SOURCE_POSITION(i) SCRATCH(i, INTEGRATOR_SOURCE).xy
+#endif
+#include "gravity.lib.glsl"
 
-State add(State a, State b) { return State(a.r + b.r, a.v + b.v); }
-State scale(State y, float a) { return State(a * y.r, a * y.v); }
-State f(State y) { return State(y.v, gravity(y.r, frame - 1)); }
+vec2 acceleration(uint self, vec2 r_self) { return gravity(self, r_self); }
 
+// runs after the bodies' dispatch of the same stage, which left the positions this one reads in place
 layout (local_size_x = 1, local_size_y = 1, local_size_z = 1) in;
 void main() {
     if (frame == 0) {
         r_g[frame] = r_g0;
         v_g = v_g0;
     } else {
-        switch (integrator) {
-            case EULER:
-                v_g += gravity(r_g[frame - 1], frame - 1) * dt;
-                r_g[frame] = r_g[frame - 1] + v_g * dt;
-                break;
-
-            case VERLET:
-                vec2 a = gravity(r_g[frame - 1], frame - 1);
-                r_g[frame] = r_g[frame - 1] + v_g * dt + a * (dt * dt) / 2;
-                vec2 a_next = gravity(r_g[frame], frame - 1);
-                v_g += (a + a_next) * (dt / 2);
-                break;
-
-            case RK4:
-                State y = State(r_g[frame - 1], v_g);
-                State k_1 = f(y);
-                State k_2 = f(add(y, scale(k_1, dt / 2)));
-                State k_3 = f(add(y, scale(k_2, dt / 2)));
-                State k_4 = f(add(y, scale(k_3, dt)));
-
-                State k_sum = add(
-                    k_1, add(
-                        scale(k_2, 2),
-                        add(scale(k_3, 2), k_4)
-                    )
-                );
-
-                State y_next = add(y, scale(k_sum, dt / 6));
-                r_g[frame] = y_next.r;
-                v_g = y_next.v;
-                break;
-        }
+        // indexed past the bodies so gravity() skips none of them
+        State y_next;
+        if (!integrate(State(r_g[frame - 1], v_g), body_count, 1.0, y_next)) return;
+        r_g[frame] = y_next.r;
+        v_g = y_next.v;
     }
 }
@@ -1,4 +1,7 @@
 #version 460
+#extension GL_GOOGLE_include_directive : require
+
+#include "render.lib.glsl"
 
 struct VertexOut {
     vec4 color;
@@ -9,9 +12,8 @@ struct VertexOut {
 layout (location = 0) out VertexOut frag;
 
 layout (std430, set = 0, binding = 0) readonly buffer Positions { vec2 positions[]; };
-layout (std430, set = 0, binding = 1) readonly buffer Colors { vec4 colors[]; };
-layout (std430, set = 0, binding = 2) readonly buffer Masses { float masses[]; };
-layout (std430, set = 0, binding = 3) readonly buffer Movables { float movable[]; };
+layout (std430, set = 0, binding = 1) readonly buffer Render { uvec2 render[]; }; // see render.lib.glsl
+layout (std430, set = 0, binding = 2) readonly buffer Visible { uint visible[]; }; // written by cull.comp.glsl
 
 layout (std140, set = 1, binding = 0) uniform Camera {
     mat4 orthographic;
@@ -24,14 +26,14 @@ layout (std140, set = 1, binding = 1) uniform Constants {
     float static_outline;
 };
 
-float compute_radius(float mass) { return pow(mass / density, 1.0 / 3.0); }
 void main() {
-    frag.color = colors[gl_InstanceIndex];
+    uint body = visible[gl_InstanceIndex];
+    BodyRender data = unpack_render(render[body]);
+    frag.color = data.color;
     frag.position.x = 2.0 * floor(gl_VertexIndex / 2.0) - 1.0;
     frag.position.y = 2.0 * mod(gl_VertexIndex, 2.0) - 1.0;
-    frag.outline = movable[gl_InstanceIndex] == 1.0 ? movable_outline : static_outline;
+    frag.outline = data.movable ? movable_outline : static_outline;
 
-    float radius = compute_radius(masses[gl_InstanceIndex]);
-    vec2 position = positions[gl_InstanceIndex];
-    gl_Position = orthographic * view * vec4(radius * frag.position + position, 0.0, 1.0);
+    vec2 position = positions[body];
+    gl_Position = orthographic * view * vec4(data.radius * frag.position + position, 0.0, 1.0);
 }
@@ -0,0 +1,44 @@
+#version 460
+
+layout (location = 0) in vec2 grid;
+layout (location = 0) out vec4 out_color;
+
+layout (std430, set = 2, binding = 0) readonly buffer Samples { vec4 samples[]; }; // acceleration, potential
+layout (std430, set = 2, binding = 1) readonly buffer Range { uint range[2]; }; // as float bits
+
+layout (std140, set = 3, binding = 0) uniform Constants {
+    uint columns;
+    uint rows;
+    float opacity;
+};
+
+float depth(uvec2 point) {
+    return abs(samples[point.y * columns + point.x].z);
+}
+
+// dark blue for shallow potential through magenta to pale yellow at the bottom of the deepest wells
+vec3 ramp(float t) {
+    vec3 shallow = vec3(0.02, 0.03, 0.15), middle = vec3(0.55, 0.1, 0.5), deep = vec3(1.0, 0.9, 0.45);
+    return t < 0.5 ? mix(shallow, middle, 2.0 * t) : mix(middle, deep, 2.0 * t - 1.0);
+}
+
+void main() {
+    float deepest = uintBitsToFloat(range[0]);
+    if (deepest <= 0.0) discard;
+
+    // bilinear between the four samples around the fragment
+    vec2 last = vec2(columns - 1, rows - 1);
+    vec2 clamped = clamp(grid, vec2(0.0), last);
+    uvec2 low = uvec2(floor(clamped));
+    uvec2 high = min(low + 1, uvec2(last));
+    vec2 f = clamped - vec2(low);
+    float potential = mix(
+        mix(depth(low), depth(uvec2(high.x, low.y)), f.x),
+        mix(depth(uvec2(low.x, high.y)), depth(high), f.x),
+        f.y
+    );
+
+    // wells span orders of magnitude, so the map is log scaled against the deepest point on the grid
+    float t = log(1.0 + 1000.0 * potential / deepest) / log(1001.0);
+    out_color = vec4(ramp(t), opacity);
+}
@@ -0,0 +1,58 @@
+#version 460
+
+// FIELD_ARROWS 0 is one quad over the evaluated grid for field.frag.glsl, 1 is an arrow per `stride` grid points
+#ifndef FIELD_ARROWS
+#define FIELD_ARROWS 0
+#endif
+
+#if FIELD_ARROWS
+layout (location = 0) out vec4 out_color;
+
+layout (std430, set = 0, binding = 0) readonly buffer Samples { vec4 samples[]; }; // acceleration, potential
+layout (std430, set = 0, binding = 1) readonly buffer Range { uint range[2]; }; // as float bits
+#else
+layout (location = 0) out vec2 grid; // position in cells
+#endif
+
+layout (std140, set = 1, binding = 0) uniform Camera {
+    mat4 orthographic;
+    mat4 view;
+};
+
+layout (std140, set = 1, binding = 1) uniform Constants {
+    vec2 origin;
+    float cell;
+    uint columns;
+    uint rows;
+    uint stride;
+    float opacity;
+};
+
+void main() {
+#if FIELD_ARROWS
+    uint arrow_columns = (columns - 1) / stride + 1;
+    uvec2 point = uvec2(gl_InstanceIndex % arrow_columns, gl_InstanceIndex / arrow_columns) * stride;
+    vec2 a = samples[point.y * columns + point.x].xy;
+    float magnitude = length(a);
+    float strongest = uintBitsToFloat(range[1]);
+
+    // log scaled so weak regions still show their direction, the strongest arrow spans 80% of the spacing
+    float t = strongest > 0.0 ? log(1.0 + 1000.0 * magnitude / strongest) / log(1001.0) : 0.0;
+    vec2 direction = magnitude > 0.0 ? a / magnitude : vec2(0.0);
+    vec2 side = vec2(-direction.y, direction.x);
+    vec2 tip = 0.8 * t * float(stride) * cell * direction;
+    vec2 back = -0.3 * length(tip) * direction;
+    vec2 spread = 0.15 * length(tip) * side;
+
+    // line list: the shaft, then the two barbs of the head
+    vec2 ends[6] = vec2[6](vec2(0.0), tip, tip, tip + back + spread, tip, tip + back - spread);
+    vec2 position = origin + vec2(point) * cell - 0.5 * tip + ends[gl_VertexIndex];
+    out_color = vec4(1.0, 1.0, 1.0, opacity * (0.25 + 0.75 * t));
+#else
+    vec2 corner = vec2(gl_VertexIndex & 1, gl_VertexIndex >> 1);
+    grid = corner * vec2(columns - 1, rows - 1);
+    vec2 position = origin + grid * cell;
+#endif
+
+    gl_Position = orthographic * view * vec4(position, 0.0, 1.0);
+}
@@ -1,10 +1,14 @@
 #version 460
+#extension GL_GOOGLE_include_directive : require
+
+#include "compact.lib.glsl"
 
 layout (location = 0) out vec4 out_color;
 
-const uint PREDICTION_LENGTH = 2048;
-layout (std430, set = 0, binding = 0) readonly buffer Positions { vec2 positions[][PREDICTION_LENGTH]; };
-layout (std430, set = 0, binding = 1) readonly buffer GhostPositions { vec2 _padding1; vec2 ghost[PREDICTION_LENGTH]; };
+layout (std430, set = 0, binding = 0) readonly buffer Positions { POINT positions[]; };
+layout (std430, set = 0, binding = 1) readonly buffer GhostPositions { vec2 _padding1; vec2 ghost[]; };
+layout (std430, set = 0, binding = 2) readonly buffer Anchors { vec2 anchors[]; }; // the bodies' current positions
+layout (std430, set = 0, binding = 3) readonly buffer Bodies { uint bodies[]; }; // slot -> body, see tracking.h
 
 layout (std140, set = 1, binding = 0) uniform Camera {
     mat4 orthographic;
@@ -13,8 +17,11 @@ layout (std140, set = 1, binding = 0) uniform Camera {
 
 layout (std140, set = 1, binding = 1) uniform Constants {
     vec3 _padding2;
-    uint target;
+    uint target; // the followed body's slot
     float brightness;
+    uint _frame;
+    uint _trail_length;
+    uint prediction_length;
 };
 
 layout (std140, set = 1, binding = 2) uniform Ghost { vec4 color; };
@@ -22,13 +29,14 @@ layout (std140, set = 1, binding = 2) uniform Ghost { vec4 color; };
 void main() {
     vec2 position = ghost[gl_VertexIndex];
     if (target != uint(-1)) {
-        position += positions[target][0]
-            - positions[target][gl_VertexIndex];
+        vec2 anchor = anchors[bodies[target]];
+        position += DECODE_POINT(positions[target * prediction_length], anchor)
+            - DECODE_POINT(positions[target * prediction_length + uint(gl_VertexIndex)], anchor);
     }
 
     gl_Position = orthographic * view * vec4(position, 0.0, 1.0);
 
-    float alpha = (brightness / 2.0) * (1.0 - float(gl_VertexIndex) / float(PREDICTION_LENGTH));
+    float alpha = (brightness / 2.0) * (1.0 - float(gl_VertexIndex) / float(prediction_length));
     out_color = vec4(color.rgb, alpha);
 }
 
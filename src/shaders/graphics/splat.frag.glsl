@@ -0,0 +1,26 @@
+#version 460
+
+#define SPLAT_SCALE 1024.0 // must match splat.comp.glsl
+
+layout (location = 0) out vec4 out_color;
+
+layout (std430, set = 2, binding = 0) readonly buffer Density { uint density_rgb[]; };
+
+layout (std140, set = 3, binding = 0) uniform Constants {
+    uint width;
+    uint height;
+    float exposure;
+};
+
+void main() {
+    uvec2 pixel = uvec2(gl_FragCoord.xy);
+    if (pixel.x >= width || pixel.y >= height) discard;
+    uint index = 3 * (pixel.y * width + pixel.x);
+    vec3 covered = vec3(density_rgb[index], density_rgb[index + 1], density_rgb[index + 2]) / SPLAT_SCALE;
+    if (covered == vec3(0.0)) discard;
+
+    // saturates smoothly where many bodies overlap, the alpha lets the clear colour through sparse pixels
+    vec3 mapped = 1.0 - exp(-exposure * covered);
+    float alpha = max(max(mapped.r, mapped.g), mapped.b);
+    out_color = vec4(mapped / alpha, alpha);
+}
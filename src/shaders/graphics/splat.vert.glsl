@@ -0,0 +1,7 @@
+#version 460
+
+// one triangle covering the screen
+void main() {
+    vec2 position = vec2((gl_VertexIndex << 1) & 2, gl_VertexIndex & 2);
+    gl_Position = vec4(2.0 * position - 1.0, 0.0, 1.0);
+}
@@ -1,10 +1,15 @@
 #version 460
+#extension GL_GOOGLE_include_directive : require
+
+#include "compact.lib.glsl"
 
 layout (location = 0) out vec4 out_color;
 
-const uint TRAIL_LENGTH = 512;
-layout (std430, set = 0, binding = 0) readonly buffer Positions { vec2 positions[][TRAIL_LENGTH]; };
-layout (std430, set = 0, binding = 1) readonly buffer Colors { vec4 colors[]; };
+layout (std430, set = 0, binding = 0) readonly buffer Trails { POINT trails[]; };
+layout (std430, set = 0, binding = 1) readonly buffer Colors { uint colors[]; }; // RGBA8
+layout (std430, set = 0, binding = 2) readonly buffer Indices { uint indices[]; }; // kept by trail_decimate.comp.glsl
+layout (std430, set = 0, binding = 3) readonly buffer Anchors { vec2 anchors[]; };
+layout (std430, set = 0, binding = 4) readonly buffer Bodies { uint bodies[]; }; // slot -> body, see tracking.h
 
 layout (std140, set = 1, binding = 0) uniform Camera {
     mat4 orthographic;
@@ -13,20 +18,25 @@ layout (std140, set = 1, binding = 0) uniform Camera {
 
 layout (std140, set = 1, binding = 1) uniform Constants {
     vec3 _padding;
-    uint target;
+    uint target; // the followed body's slot
     float brightness;
     uint frame;
+    uint trail_length;
 };
 
 void main() {
-    vec2 position = positions[gl_InstanceIndex][(frame - gl_VertexIndex) % TRAIL_LENGTH];
+    uint entry = indices[gl_VertexIndex];
+    uint slot = entry / trail_length;
+    uint index = entry % trail_length;
+    uint age = (frame + trail_length - index) % trail_length;
+    vec2 position = DECODE_POINT(trails[entry], anchors[slot]);
     if (target != uint(-1)) {
-        position += positions[target][frame]
-            - positions[target][(frame - gl_VertexIndex) % TRAIL_LENGTH];
+        position += DECODE_POINT(trails[target * trail_length + frame], anchors[target])
+            - DECODE_POINT(trails[target * trail_length + index], anchors[target]);
     }
 
     gl_Position = orthographic * view * vec4(position, 0.0, 1.0);
 
-    float alpha = brightness * (1.0 - float(gl_VertexIndex) / float(TRAIL_LENGTH));
-    out_color = vec4(colors[gl_InstanceIndex].rgb, alpha);
+    float alpha = brightness * (1.0 - float(age) / float(trail_length));
+    out_color = vec4(unpackUnorm4x8(colors[bodies[slot]]).rgb, alpha);
 }
@@ -0,0 +1,30 @@
+// Shared Newtonian gravity, include after declaring `body_count`, `G`, `ee`, `m[]`
+// and defining SOURCE_POSITION(i) as the position of source body i.
+
+#ifndef WORKGROUP_SIZE
+#define WORKGROUP_SIZE 64
+#endif
+
+const uint NO_SELF = uint(-1);
+
+// softened acceleration towards a mass `m_j` at offset R
+vec2 pair_acceleration(vec2 R, float m_j) {
+    float R2 = dot(R, R) + ee * ee;
+    return (G * m_j / R2) * normalize(R);
+}
+
+// potential of that force per unit G m_i m_j, ∫ dR / (R² + ε²), so that K + U is what it conserves
+float pair_potential(float R) {
+    if (ee == 0.0) return -1.0 / R;
+    return -(1.57079633 - atan(R / ee)) / ee;
+}
+
+uint when_neq(uint a, uint b) { return uint(a != b); }
+vec2 gravity(uint self, vec2 r_self) {
+    vec2 net_a = vec2(0.0);
+    for (uint i = 0; i < body_count; i++) {
+        net_a += pair_acceleration(SOURCE_POSITION(i) - r_self, m[i]) * when_neq(i, self);
+    }
+
+    return net_a;
+}
@@ -0,0 +1,90 @@
+// Shared integrators, INTEGRATOR and INTEGRATOR_STAGE are set per variant by compile_shaders.py.
+// Every stage is its own dispatch over all bodies, so forces are always evaluated against where every other body
+// is in that stage rather than where it started the step. Include after declaring `dt` and defining
+// SCRATCH(self, k), three vec4 per body that hand a stage's results to the next one. acceleration(uint self, vec2 r)
+// may be defined later and has to take body positions from `SCRATCH(i, INTEGRATOR_SOURCE).xy` in stages past the first.
+
+// must match the integrator enum and INTEGRATOR_STAGES in simulation.h
+#define INTEGRATOR_EULER 0
+#define INTEGRATOR_VERLET 1
+#define INTEGRATOR_RUNGE_KUTTA_4 2
+
+#if INTEGRATOR == INTEGRATOR_EULER
+#define INTEGRATOR_STAGES 1
+#elif INTEGRATOR == INTEGRATOR_VERLET
+#define INTEGRATOR_STAGES 2
+#elif INTEGRATOR == INTEGRATOR_RUNGE_KUTTA_4
+#define INTEGRATOR_STAGES 4
+#else
+#error "INTEGRATOR must be defined"
+#endif
+
+#ifndef INTEGRATOR_STAGE
+#define INTEGRATOR_STAGE 0
+#endif
+
+// the scratch slot holding the positions this stage evaluates forces at
+#if INTEGRATOR == INTEGRATOR_RUNGE_KUTTA_4 && INTEGRATOR_STAGE == 2
+#define INTEGRATOR_SOURCE 1
+#else
+#define INTEGRATOR_SOURCE 0
+#endif
+
+struct State {
+    vec2 r;
+    vec2 v;
+};
+
+vec2 acceleration(uint self, vec2 r_self);
+
+State add(State a, State b) { return State(a.r + b.r, a.v + b.v); }
+State scale(State y, float a) { return State(a * y.r, a * y.v); }
+State f(State y, uint self) { return State(y.v, acceleration(self, y.r)); }
+State load(vec4 s) { return State(s.xy, s.zw); }
+vec4 store(State y) { return vec4(y.r, y.v); }
+
+// runs stage INTEGRATOR_STAGE of the step that starts at `y` and returns true with the new state in `y_next` on the
+// last one. bodies that aren't `movable` stay put in the intermediate stages too, so the others feel them where they are
+bool integrate(State y, uint self, float movable, out State y_next) {
+    y_next = y;
+#if INTEGRATOR == INTEGRATOR_EULER
+    // https://en.wikipedia.org/wiki/Semi-implicit_Euler_method#The_method
+    y_next.v = y.v + acceleration(self, y.r) * dt;
+    y_next.r = y.r + y_next.v * dt;
+    return true;
+#elif INTEGRATOR == INTEGRATOR_VERLET
+    // https://en.wikipedia.org/wiki/Verlet_integration#Velocity_Verlet, the first stage leaves (r_next, a) behind
+#if INTEGRATOR_STAGE == 0
+    vec2 a = acceleration(self, y.r);
+    vec2 r_next = y.r + (y.v * dt + a * (dt * dt) / 2) * movable;
+    SCRATCH(self, 0) = vec4(r_next, a);
+    return false;
+#else
+    vec4 s = SCRATCH(self, 0);
+    vec2 a_next = acceleration(self, s.xy);
+    y_next = State(s.xy, y.v + (s.zw + a_next) * (dt / 2));
+    return true;
+#endif
+#else
+    // https://en.wikipedia.org/wiki/Runge–Kutta_methods, k_1 + 2 k_2 + 2 k_3 + k_4 builds up in SCRATCH(self, 2)
+    // while the stage states alternate between slots 0 and 1
+#if INTEGRATOR_STAGE == 0
+    State k = f(y, self);
+    SCRATCH(self, 2) = store(k);
+    SCRATCH(self, 0) = store(add(y, scale(k, dt / 2 * movable)));
+#elif INTEGRATOR_STAGE == 1
+    State k = f(load(SCRATCH(self, 0)), self);
+    SCRATCH(self, 2) += store(scale(k, 2));
+    SCRATCH(self, 1) = store(add(y, scale(k, dt / 2 * movable)));
+#elif INTEGRATOR_STAGE == 2
+    State k = f(load(SCRATCH(self, 1)), self);
+    SCRATCH(self, 2) += store(scale(k, 2));
+    SCRATCH(self, 0) = store(add(y, scale(k, dt * movable)));
+#else
+    State k = f(load(SCRATCH(self, 0)), self);
+    y_next = add(y, scale(add(load(SCRATCH(self, 2)), k), dt / 6));
+    return true;
+#endif
+    return false;
+#endif
+}
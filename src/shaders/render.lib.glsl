@@ -0,0 +1,12 @@
+// Per body draw data written by render_data.comp.glsl, one uvec2 per body: the radius with the sign bit set for
+// static bodies, and the colour packed as RGBA8 like Graphics.colors.
+
+struct BodyRender {
+    float radius;
+    bool movable;
+    vec4 color;
+};
+
+BodyRender unpack_render(uvec2 data) {
+    return BodyRender(uintBitsToFloat(data.x & 0x7FFFFFFFu), (data.x & 0x80000000u) == 0u, unpackUnorm4x8(data.y));
+}
@@ -0,0 +1,26 @@
+#version 460
+
+#ifndef WORKGROUP_SIZE
+#define WORKGROUP_SIZE 64
+#endif
+
+// rebuilds the per body draw data read through render.lib.glsl, only when bodies or the density change,
+// so drawing fetches 8 bytes per body instead of a float colour, mass and movable flag and a pow per vertex
+layout (std430, set = 0, binding = 0) readonly buffer Masses { float masses[]; };
+layout (std430, set = 0, binding = 1) readonly buffer Movables { float movable[]; };
+layout (std430, set = 0, binding = 2) readonly buffer Colors { uint colors[]; };
+
+layout (std430, set = 1, binding = 0) writeonly buffer Render { uvec2 render[]; };
+
+layout (std140, set = 2, binding = 0) uniform Constants {
+    uint body_count;
+    float density;
+};
+
+layout (local_size_x = WORKGROUP_SIZE, local_size_y = 1, local_size_z = 1) in;
+void main() {
+    uint i = gl_GlobalInvocationID.x;
+    if (i >= body_count) return;
+    float radius = pow(masses[i] / density, 1.0 / 3.0);
+    render[i] = uvec2(floatBitsToUint(radius) | (movable[i] == 1.0 ? 0u : 0x80000000u), colors[i]);
+}
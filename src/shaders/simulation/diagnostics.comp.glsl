@@ -0,0 +1,76 @@
+#version 460
+#extension GL_GOOGLE_include_directive : require
+
+#ifndef WORKGROUP_SIZE
+#define WORKGROUP_SIZE 64
+#endif
+
+// first stage of the conservation diagnostics, one pair of partial sums per workgroup:
+// (kinetic, potential, momentum) and (angular momentum, mass, mass weighted position)
+layout (std430, set = 0, binding = 0) readonly buffer Positions { vec2 r[]; };
+layout (std430, set = 0, binding = 1) readonly buffer Velocities { vec2 v[]; };
+layout (std430, set = 0, binding = 2) readonly buffer Masses { float m[]; };
+layout (std430, set = 0, binding = 3) readonly buffer Movable { float mov[]; };
+layout (std430, set = 1, binding = 0) writeonly buffer Partials { vec4 partials[]; };
+
+layout (std140, set = 2, binding = 0) uniform Constants {
+    uint body_count;
+    float G;
+    float ee;
+};
+
+shared vec2 tile_r[WORKGROUP_SIZE];
+shared float tile_m[WORKGROUP_SIZE];
+shared vec4 sums_a[WORKGROUP_SIZE];
+shared vec4 sums_b[WORKGROUP_SIZE];
+
+#define SOURCE_POSITION(i) r[i]
+#include "gravity.lib.glsl"
+
+layout (local_size_x = WORKGROUP_SIZE, local_size_y = 1, local_size_z = 1) in;
+void main() {
+    uint i = gl_GlobalInvocationID.x;
+    uint local = gl_LocalInvocationID.x;
+    bool active = i < body_count;
+    vec2 r_i = active ? r[i] : vec2(0.0);
+    float m_i = active ? m[i] : 0.0;
+
+    // O(N²) over tiles staged in shared memory, each tile is summed on its own to keep the float error down
+    float potential = 0.0;
+    for (uint tile = 0; tile < body_count; tile += WORKGROUP_SIZE) {
+        uint j = tile + local;
+        tile_r[local] = j < body_count ? r[j] : vec2(0.0);
+        tile_m[local] = j < body_count ? m[j] : 0.0;
+        barrier();
+
+        float tile_sum = 0.0;
+        for (uint k = 0; k < WORKGROUP_SIZE; k++) {
+            if (tile + k == i || tile_m[k] == 0.0) continue;
+            tile_sum += tile_m[k] * pair_potential(length(tile_r[k] - r_i));
+        }
+
+        potential += tile_sum;
+        barrier();
+    }
+
+    // static bodies keep their velocity but never move, so they carry no kinetic energy or momentum
+    vec2 v_i = active ? v[i] * mov[i] : vec2(0.0);
+    vec2 p = m_i * v_i;
+    sums_a[local] = vec4(0.5 * m_i * dot(v_i, v_i), 0.5 * G * m_i * potential, p); // every pair is seen from both ends
+    sums_b[local] = vec4(r_i.x * p.y - r_i.y * p.x, m_i, m_i * r_i);
+    barrier();
+
+    for (uint stride = WORKGROUP_SIZE / 2; stride > 0; stride /= 2) {
+        if (local < stride) {
+            sums_a[local] += sums_a[local + stride];
+            sums_b[local] += sums_b[local + stride];
+        }
+
+        barrier();
+    }
+
+    if (local == 0) {
+        partials[2 * gl_WorkGroupID.x] = sums_a[0];
+        partials[2 * gl_WorkGroupID.x + 1] = sums_b[0];
+    }
+}
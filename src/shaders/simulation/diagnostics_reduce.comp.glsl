@@ -0,0 +1,44 @@
+#version 460
+
+#ifndef WORKGROUP_SIZE
+#define WORKGROUP_SIZE 64
+#endif
+
+// second stage of the conservation diagnostics, a single workgroup folds every partial pair into `result`
+layout (std430, set = 1, binding = 0) readonly buffer Partials { vec4 partials[]; };
+layout (std430, set = 1, binding = 1) writeonly buffer Result { vec4 result[2]; };
+
+layout (std140, set = 2, binding = 0) uniform Constants {
+    uint partial_count;
+};
+
+shared vec4 sums_a[WORKGROUP_SIZE];
+shared vec4 sums_b[WORKGROUP_SIZE];
+
+layout (local_size_x = WORKGROUP_SIZE, local_size_y = 1, local_size_z = 1) in;
+void main() {
+    uint local = gl_LocalInvocationID.x;
+    vec4 a = vec4(0.0), b = vec4(0.0);
+    for (uint i = local; i < partial_count; i += WORKGROUP_SIZE) {
+        a += partials[2 * i];
+        b += partials[2 * i + 1];
+    }
+
+    sums_a[local] = a;
+    sums_b[local] = b;
+    barrier();
+
+    for (uint stride = WORKGROUP_SIZE / 2; stride > 0; stride /= 2) {
+        if (local < stride) {
+            sums_a[local] += sums_a[local + stride];
+            sums_b[local] += sums_b[local + stride];
+        }
+
+        barrier();
+    }
+
+    if (local == 0) {
+        result[0] = sums_a[0];
+        result[1] = sums_b[0];
+    }
+}
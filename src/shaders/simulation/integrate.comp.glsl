@@ -0,0 +1,52 @@
+#version 460
+#extension GL_GOOGLE_include_directive : require
+
+layout (std430, set = 0, binding = 0) buffer Positions { vec2 r[]; };
+layout (std430, set = 0, binding = 1) buffer Velocities { vec2 v[]; };
+layout (std430, set = 0, binding = 2) readonly buffer Masses { float m[]; };
+layout (std430, set = 0, binding = 3) readonly buffer Movable { float mov[]; };
+layout (std430, set = 0, binding = 4) buffer Scratch { vec4 scratch[]; }; // INTEGRATOR_SCRATCH_SIZE per body
+
+layout (std140, set = 2, binding = 0) uniform Constants {
+    uint body_count;
+    float G;
+    float ee;
+    float dt;
+};
+
+#define SCRATCH(i, k) scratch[3 * (i) + (k)]
+#include "integrators.lib.glsl"
+
+#if INTEGRATOR_STAGE == 0
+#define SOURCE_POSITION(i) r[i]
+#else
+#define SOURCE_POSITION(i) SCRATCH(i, INTEGRATOR_SOURCE).xy
+#endif
+#include "gravity.lib.glsl"
+
+vec2 acceleration(uint self, vec2 r_self) { return gravity(self, r_self); }
+
+layout (local_size_x = WORKGROUP_SIZE, local_size_y = 1, local_size_z = 1) in;
+void main() {
+    uint i = gl_GlobalInvocationID.x;
+    if (i >= body_count) return;
+
+#if INTEGRATOR_STAGE == INTEGRATOR_STAGES
+    // a single stage reads every position from `r`, so it can't write them in place and this extra pass commits them
+    State y_next = load(SCRATCH(i, 0));
+    r[i] = y_next.r;
+    v[i] = y_next.v;
+#else
+    State y = State(r[i], v[i]);
+    State y_next;
+    if (!integrate(y, i, mov[i], y_next)) return;
+
+    y_next = State(mix(y.r, y_next.r, mov[i]), mix(y.v, y_next.v, mov[i]));
+#if INTEGRATOR_STAGES == 1
+    SCRATCH(i, 0) = store(y_next);
+#else
+    r[i] = y_next.r;
+    v[i] = y_next.v;
+#endif
+#endif
+}
@@ -0,0 +1,79 @@
+#version 460
+#extension GL_GOOGLE_include_directive : require
+
+#ifndef WORKGROUP_SIZE
+#define WORKGROUP_SIZE 64
+#endif
+
+// level of detail for bodies smaller than `splat_radius` pixels: instead of a quad each, they add their covered area
+// times their colour into a fixed point rgb density buffer, which splat.frag.glsl tone maps in one fullscreen pass.
+// SPLAT_STAGE 0 clears the buffer, 1 accumulates the bodies
+#ifndef SPLAT_STAGE
+#define SPLAT_STAGE 0
+#endif
+
+#define SPLAT_SCALE 1024.0 // fixed point units per fully covered pixel, must match splat.frag.glsl
+#define PI 3.14159265359
+
+#if SPLAT_STAGE == 1
+#include "render.lib.glsl"
+layout (std430, set = 0, binding = 0) readonly buffer Positions { vec2 positions[]; };
+layout (std430, set = 0, binding = 1) readonly buffer Render { uvec2 render[]; };
+#endif
+
+layout (std430, set = 1, binding = 0) buffer Density { uint density_rgb[]; }; // 3 per pixel, rows top to bottom
+
+layout (std140, set = 2, binding = 0) uniform Constants {
+    mat4 orthographic;
+    mat4 view;
+    uint body_count;
+    float splat_radius;
+    float movable_outline;
+    float static_outline;
+    uint width;
+    uint height;
+};
+
+#if SPLAT_STAGE == 1
+void splat(ivec2 pixel, vec3 value) {
+    if (any(lessThan(pixel, ivec2(0))) || pixel.x >= int(width) || pixel.y >= int(height)) return;
+    uint index = 3 * (uint(pixel.y) * width + uint(pixel.x));
+    uvec3 fixed_point = uvec3(value * SPLAT_SCALE + 0.5);
+    if (fixed_point.r > 0) atomicAdd(density_rgb[index + 0], fixed_point.r);
+    if (fixed_point.g > 0) atomicAdd(density_rgb[index + 1], fixed_point.g);
+    if (fixed_point.b > 0) atomicAdd(density_rgb[index + 2], fixed_point.b);
+}
+#endif
+
+layout (local_size_x = WORKGROUP_SIZE, local_size_y = 1, local_size_z = 1) in;
+void main() {
+    uint i = gl_GlobalInvocationID.x;
+#if SPLAT_STAGE == 0
+    // grid stride, a 4K buffer has more words than a dispatch has invocations
+    for (; i < 3 * width * height; i += gl_NumWorkGroups.x * WORKGROUP_SIZE) density_rgb[i] = 0;
+#else
+    if (i >= body_count) return;
+    mat4 transform = orthographic * view;
+    BodyRender data = unpack_render(render[i]);
+    float radius = data.radius * length(transform[0].xy) * 0.5 * float(width);
+    if (radius >= splat_radius) return; // drawn as a circle
+
+    vec2 ndc = (transform * vec4(positions[i], 0.0, 1.0)).xy;
+    vec2 pixel = vec2(0.5 * ndc.x + 0.5, 0.5 - 0.5 * ndc.y) * vec2(width, height) - 0.5;
+    if (any(lessThan(pixel, vec2(-1.0))) || pixel.x >= float(width) || pixel.y >= float(height)) return;
+
+    // the area circle.frag.glsl would have lit, bodies are outlined rings
+    float outline = data.movable ? movable_outline : static_outline;
+    float inner = 1.0 - outline;
+    vec4 color = data.color;
+    vec3 value = color.rgb * color.a * PI * radius * radius * (1.0 - inner * inner);
+
+    // bilinear weights so bodies glide across pixels instead of snapping
+    ivec2 base = ivec2(floor(pixel));
+    vec2 f = pixel - vec2(base);
+    splat(base, value * (1.0 - f.x) * (1.0 - f.y));
+    splat(base + ivec2(1, 0), value * f.x * (1.0 - f.y));
+    splat(base + ivec2(0, 1), value * (1.0 - f.x) * f.y);
+    splat(base + ivec2(1, 1), value * f.x * f.y);
+#endif
+}
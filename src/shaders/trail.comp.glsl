@@ -1,12 +1,40 @@
 #version 460
+#extension GL_GOOGLE_include_directive : require
 
-const uint TRAIL_LENGTH = 512;
-layout (std430, set = 0, binding = 0) writeonly buffer Trails { vec2 trails[][TRAIL_LENGTH]; };
+#ifndef WORKGROUP_SIZE
+#define WORKGROUP_SIZE 64
+#endif
+
+#include "compact.lib.glsl"
+
+layout (std430, set = 0, binding = 0) buffer Trails { POINT trails[]; };
 layout (std430, set = 0, binding = 1) readonly buffer Positions { vec2 positions[]; };
-layout (std140, set = 2, binding = 0) uniform Frame { uint frame; };
+layout (std430, set = 0, binding = 2) buffer Anchors { vec2 anchors[]; };
+layout (std430, set = 0, binding = 3) readonly buffer Bodies { uint bodies[]; }; // slot -> body, see tracking.h
+layout (std140, set = 2, binding = 0) uniform Frame {
+    uint frame;
+    uint slot_count;
+    uint trail_length;
+};
 
-layout (local_size_x = 1, local_size_y = 1, local_size_z = 1) in;
+layout (local_size_x = WORKGROUP_SIZE, local_size_y = 1, local_size_z = 1) in;
 void main() {
     uint i = gl_GlobalInvocationID.x;
-    trails[i][frame] = positions[i];
+    if (i >= slot_count) return;
+    vec2 position = positions[bodies[i]];
+
+#if COMPACT
+    // whenever the ring wraps the anchor moves onto the body, so offsets never span much more than one trail
+    if (frame == 0) {
+        vec2 anchor = position;
+        for (uint k = 1; k < trail_length; k++) {
+            uint index = i * trail_length + k;
+            trails[index] = ENCODE_POINT(DECODE_POINT(trails[index], anchors[i]), anchor);
+        }
+
+        anchors[i] = anchor;
+    }
+#endif
+
+    trails[i * trail_length + frame] = ENCODE_POINT(position, anchors[i]);
 }
@@ -0,0 +1,90 @@
+#version 460
+#extension GL_GOOGLE_include_directive : require
+
+#ifndef WORKGROUP_SIZE
+#define WORKGROUP_SIZE 64
+#endif
+
+// screen space decimation of the trails before drawing: walking each trail from its newest point, a point is only kept
+// when it strays more than `tolerance` pixels from the chord between the last kept point and the next one, so straight
+// stretches collapse to their ends. writes the kept trail indices and one indirect draw per tracked body
+#include "compact.lib.glsl"
+
+layout (std430, set = 0, binding = 0) readonly buffer Trails { POINT trails[]; };
+layout (std430, set = 0, binding = 1) readonly buffer Anchors { vec2 anchors[]; };
+
+layout (std430, set = 1, binding = 0) writeonly buffer Indices { uint indices[]; }; // trail_length per slot
+layout (std430, set = 1, binding = 1) writeonly buffer Arguments { uvec4 arguments[]; }; // SDL_GPUIndirectDrawCommand per slot
+
+layout (std140, set = 2, binding = 0) uniform Constants {
+    mat4 orthographic;
+    mat4 view;
+    uint slot_count;
+    uint target; // the followed body's slot
+    uint frame;
+    uint trail_length;
+    float tolerance;
+    float width;
+    float height;
+};
+
+// the same target relative offset trail.vert.glsl applies
+vec2 trail_position(uint slot, uint index) {
+    vec2 position = DECODE_POINT(trails[slot * trail_length + index], anchors[slot]);
+    if (target != uint(-1)) {
+        position += DECODE_POINT(trails[target * trail_length + frame], anchors[target])
+            - DECODE_POINT(trails[target * trail_length + index], anchors[target]);
+    }
+
+    return position;
+}
+
+uint trail_index(uint age) { return (frame + trail_length - age) % trail_length; }
+
+vec2 to_pixels(mat4 transform, vec2 position) {
+    return (transform * vec4(position, 0.0, 1.0)).xy * 0.5 * vec2(width, height);
+}
+
+float segment_distance(vec2 p, vec2 a, vec2 b) {
+    vec2 ab = b - a;
+    float t = clamp(dot(p - a, ab) / max(dot(ab, ab), 1e-12), 0.0, 1.0);
+    return length(p - a - t * ab);
+}
+
+layout (local_size_x = WORKGROUP_SIZE, local_size_y = 1, local_size_z = 1) in;
+void main() {
+    uint slot = gl_GlobalInvocationID.x;
+    if (slot >= slot_count) return;
+
+    mat4 transform = orthographic * view;
+    uint first = slot * trail_length;
+    uint count = 0;
+
+    vec2 anchor = to_pixels(transform, trail_position(slot, trail_index(0)));
+    vec2 low = anchor, high = anchor;
+    indices[first + count++] = first + trail_index(0);
+
+    vec2 current = trail_length > 1 ? to_pixels(transform, trail_position(slot, trail_index(1))) : anchor;
+    for (uint age = 1; age + 1 < trail_length; age++) {
+        vec2 next = to_pixels(transform, trail_position(slot, trail_index(age + 1)));
+        if (segment_distance(current, anchor, next) > tolerance) {
+            indices[first + count++] = first + trail_index(age);
+            anchor = current;
+        }
+
+        low = min(low, current);
+        high = max(high, current);
+        current = next;
+    }
+
+    if (trail_length > 1) {
+        indices[first + count++] = first + trail_index(trail_length - 1);
+        low = min(low, current);
+        high = max(high, current);
+    }
+
+    // trails entirely off screen draw nothing
+    vec2 half_size = 0.5 * vec2(width, height);
+    bool visible = all(lessThanEqual(low, half_size)) && all(greaterThanEqual(high, -half_size));
+    arguments[slot] = uvec4(visible ? count : 0, 1, first, 0);
+}
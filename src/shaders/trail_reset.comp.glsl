@@ -0,0 +1,28 @@
+#version 460
+#extension GL_GOOGLE_include_directive : require
+
+#ifndef WORKGROUP_SIZE
+#define WORKGROUP_SIZE 64
+#endif
+
+#include "compact.lib.glsl"
+
+layout (std430, set = 0, binding = 0) writeonly buffer Trails { POINT trails[]; };
+layout (std430, set = 0, binding = 1) readonly buffer Positions { vec2 positions[]; };
+layout (std430, set = 0, binding = 2) writeonly buffer Anchors { vec2 anchors[]; };
+layout (std430, set = 0, binding = 3) readonly buffer Bodies { uint bodies[]; }; // slot -> body, see tracking.h
+layout (std140, set = 2, binding = 0) uniform Reset {
+    uint first;
+    uint slot_count;
+    uint trail_length;
+};
+
+// collapses the trails of slots [first, slot_count) onto their body's current position
+layout (local_size_x = WORKGROUP_SIZE, local_size_y = 1, local_size_z = 1) in;
+void main() {
+    uint i = first + gl_GlobalInvocationID.x;
+    if (i >= slot_count) return;
+    vec2 position = positions[bodies[i]];
+    anchors[i] = position;
+    for (uint frame = 0; frame < trail_length; frame++) trails[i * trail_length + frame] = ENCODE_POINT(position, position);
+}
@@ -1,100 +1,75 @@
 #version 460
+#extension GL_GOOGLE_include_directive : require
 
-const uint PREDICTION_LENGTH = 2048;
-layout (std430, set = 0, binding = 0) buffer TrajectoryPositions { vec2 r[][PREDICTION_LENGTH]; };
-layout (std430, set = 0, binding = 1) buffer TrajectoryVelocities { vec2 v[]; };
-layout (std430, set = 0, binding = 2) buffer TrajectoryGhost { vec2 _padding1; vec2 r_g[PREDICTION_LENGTH]; };
+#include "compact.lib.glsl"
+
+// every body is integrated from `s`: its position of the previous and the current frame, alternating, then its velocity.
+// only tracked bodies write their points, at their slot, compact ones as offsets from the body's current position.
+// the stages of each frame borrow the simulation's scratch, which is free between steps, the ghost's is the one past the bodies
+layout (std430, set = 0, binding = 0) buffer TrajectoryPositions { POINT r[]; };
+layout (std430, set = 0, binding = 1) buffer TrajectoryState { vec2 s[]; };
+layout (std430, set = 0, binding = 2) buffer TrajectoryGhost { vec2 _padding1; vec2 r_g[]; };
 layout (std430, set = 0, binding = 3) readonly buffer Positions { vec2 r_0[]; };
 layout (std430, set = 0, binding = 4) readonly buffer Velocities { vec2 v_0[]; };
 layout (std430, set = 0, binding = 5) readonly buffer Masses { float m[]; };
 layout (std430, set = 0, binding = 6) readonly buffer Movable { float mov[]; };
-
-const uint EULER = 0;
-const uint VERLET = 1;
-const uint RK4 = 2;
+layout (std430, set = 0, binding = 7) readonly buffer Slots { uint slots[]; }; // body -> slot, see tracking.h
+layout (std430, set = 0, binding = 8) buffer Scratch { vec4 scratch[]; }; // Simulation.scratch, body_count + 1 entries
 
 layout (std140, set = 2, binding = 0) uniform Constants {
     uint body_count;
-    uint integrator;
     float G;
     float ee;
     float dt;
+    uint prediction_length;
 };
 
 layout (std140, set = 2, binding = 1) uniform Ghost {
     vec4 _padding2;
     float m_g;
-    bool ghost;
 };
 
 layout (std140, set = 2, binding = 2) uniform Frame { uint frame; };
 
-uint when_neq(uint a, uint b) { return uint(a != b); }
-vec2 gravity(uint self, vec2 r_self, uint frame) {
-    vec2 net_a = vec2(0.0);
-    for (uint i = 0; i < body_count; i++) {
-        vec2 R = r[i][frame] - r_self;
-        float R2 = dot(R, R) + ee * ee;
-        net_a += (G * m[i] / R2) * normalize(R) * when_neq(i, self);
-    }
-
-    if (ghost) {
-        vec2 R = r_g[frame] - r_self;
-        float R2 = dot(R, R) + ee * ee;
-        net_a += (G * m_g / R2) * normalize(R);
-    }
-
+#define SCRATCH(i, k) scratch[3 * (i) + (k)]
+#include "integrators.lib.glsl"
+
+#if INTEGRATOR_STAGE == 0
+#define SOURCE_POSITION(i) s[3 * (i) + ((frame - 1) & 1)]
+#define GHOST_POSITION r_g[frame - 1]
+#else
+#define SOURCE_POSITION(i) SCRATCH(i, INTEGRATOR_SOURCE).xy
+#define GHOST_POSITION SCRATCH(body_count, INTEGRATOR_SOURCE).xy
+#endif
+#include "gravity.lib.glsl"
+
+vec2 acceleration(uint self, vec2 r_self) {
+    vec2 net_a = gravity(self, r_self);
+#if GHOST
+    net_a += pair_acceleration(GHOST_POSITION - r_self, m_g);
+#endif
     return net_a;
 }
 
-struct State {
-    vec2 r;
-    vec2 v;
-};
-
-State add(State a, State b) { return State(a.r + b.r, a.v + b.v); }
-State scale(State y, float a) { return State(a * y.r, a * y.v); }
-State f(State y, uint i) { return State(y.v, gravity(i, y.r, frame - 1)); }
-
-layout (local_size_x = 1, local_size_y = 1, local_size_z = 1) in;
+layout (local_size_x = WORKGROUP_SIZE, local_size_y = 1, local_size_z = 1) in;
 void main() {
     uint i = gl_GlobalInvocationID.x;
+    if (i >= body_count) return;
 
+    vec2 position;
     if (frame == 0) {
-        r[i][frame] = r_0[i];
-        v[i] = v_0[i];
+        position = r_0[i];
+        s[3 * i + 2] = v_0[i];
     } else {
-        switch (integrator) {
-            case EULER:
-                v[i] += gravity(i, r[i][frame - 1], frame - 1) * dt;
-                r[i][frame] = r[i][frame - 1] + v[i] * dt;
-                break;
-
-            case VERLET:
-                vec2 a = gravity(i, r[i][frame - 1], frame - 1);
-                r[i][frame] = r[i][frame - 1] + v[i] * dt + a * (dt * dt) / 2;
-                vec2 a_next = gravity(i, r[i][frame], frame - 1);
-                v[i] += (a + a_next) * (dt / 2);
-                break;
-
-            case RK4:
-                State y = State(r[i][frame - 1], v[i]);
-                State k_1 = f(y, i);
-                State k_2 = f(add(y, scale(k_1, dt / 2)), i);
-                State k_3 = f(add(y, scale(k_2, dt / 2)), i);
-                State k_4 = f(add(y, scale(k_3, dt)), i);
-
-                State k_sum = add(
-                    k_1, add(
-                        scale(k_2, 2),
-                        add(scale(k_3, 2), k_4)
-                    )
-                );
-
-                State y_next = add(y, scale(k_sum, dt / 6));
-                r[i][frame] = y_next.r;
-                v[i] = y_next.v;
-                break;
-        }
+        // the state the frame started from, every stage integrates from it
+        State y = State(s[3 * i + ((frame - 1) & 1)], s[3 * i + 2]);
+        State y_next;
+        if (!integrate(y, i, mov[i], y_next)) return;
+        position = mix(y.r, y_next.r, mov[i]);
+        s[3 * i + 2] = mix(y.v, y_next.v, mov[i]);
     }
+
+    s[3 * i + (frame & 1)] = position;
+    uint slot = slots[i];
+    if (slot != uint(-1)) r[slot * prediction_length + frame] = ENCODE_POINT(position, r_0[i]);
 }
@@ -13,13 +13,15 @@ SDL_AppResult simulation_init(Simulation *sim, SDL_GPUDevice *gpu) {
         .paused = false
     };
 
-    SDL_GPUComputePipeline *euler = CreateGPUComputePipeline(gpu, "shaders/simulation/euler.comp.spv");
-    SDL_GPUComputePipeline *verlet = CreateGPUComputePipeline(gpu, "shaders/simulation/verlet.comp.spv");
-    SDL_GPUComputePipeline *runge_kutta = CreateGPUComputePipeline(gpu, "shaders/simulation/runge_kutta.comp.spv");
-    if (!euler) panic("Failed to create simulation euler compute pipeline!");
-    if (!verlet) panic("Failed to create simulation verlet compute pipeline!");
-    if (!runge_kutta) panic("Failed to create simulation runge kutta compute pipeline!");
-    memcpy(sim->integrators, (SDL_GPUComputePipeline*[3]) { euler, verlet, runge_kutta }, sizeof(sim->integrators));
+    const char *integrators[] = { "euler", "verlet", "runge_kutta" };
+    for (u32 i = 0; i < INTEGRATOR_COUNT; i++) {
+        for (u32 stage = 0; stage < SIMULATION_STAGES(i); stage++) {
+            char path[128];
+            SDL_snprintf(path, sizeof(path), "shaders/simulation/integrate.%s.s%u.comp.spv", integrators[i], stage);
+            sim->integrators[i][stage] = CreateGPUComputePipeline(gpu, path);
+            if (!sim->integrators[i][stage]) panic("Failed to create simulation integrator compute pipeline!");
+        }
+    }
 
     sim->positions = CreateGPUArray(gpu, sizeof(HMM_Vec2), SDL_GPU_BUFFERUSAGE_COMPUTE_STORAGE_READ | SDL_GPU_BUFFERUSAGE_COMPUTE_STORAGE_WRITE | SDL_GPU_BUFFERUSAGE_GRAPHICS_STORAGE_READ);
     sim->velocities = CreateGPUArray(gpu, sizeof(HMM_Vec2), SDL_GPU_BUFFERUSAGE_COMPUTE_STORAGE_READ | SDL_GPU_BUFFERUSAGE_COMPUTE_STORAGE_WRITE | SDL_GPU_BUFFERUSAGE_GRAPHICS_STORAGE_READ);
@@ -30,6 +32,9 @@ SDL_AppResult simulation_init(Simulation *sim, SDL_GPUDevice *gpu) {
     if (!sim->masses.buffer) panic("Failed to create simulation masses buffer!");
     if (!sim->movable.buffer) panic("Failed to create simulation movable buffer!");
 
+    sim->scratch = CreateGPUArray(gpu, INTEGRATOR_SCRATCH_SIZE, SDL_GPU_BUFFERUSAGE_COMPUTE_STORAGE_READ | SDL_GPU_BUFFERUSAGE_COMPUTE_STORAGE_WRITE);
+    if (!sim->scratch.buffer) panic("Failed to create simulation scratch buffer!");
+
     return SDL_APP_CONTINUE;
 }
 
@@ -42,10 +47,43 @@ u32 simulation_add_body(Simulation *sim, SDL_GPUDevice *gpu, SDL_GPUCopyPass *co
     };
 
     AppendGPUArrays(gpu, copy_pass, bindings, sizeof(bindings) / sizeof(AppendGPUArrayBinding));
-    return sim->body_count++;
+    const u32 index = sim->body_count++;
+    simulation_reserve_scratch(sim, gpu, copy_pass);
+    return index;
+}
+
+// bulk insert, one upload per array however many bodies there are
+u32 simulation_add_bodies(Simulation *sim, SDL_GPUDevice *gpu, SDL_GPUCopyPass *copy_pass, const BodyTable *bodies) {
+    if (bodies->count == 0) return sim->body_count;
+    const AppendGPUArrayBinding bindings[] = {
+        { .array = &sim->positions, .source = (u8 *) bodies->positions, .size = bodies->count * (u32) sizeof(HMM_Vec2) },
+        { .array = &sim->velocities, .source = (u8 *) bodies->velocities, .size = bodies->count * (u32) sizeof(HMM_Vec2) },
+        { .array = &sim->masses, .source = (u8 *) bodies->masses, .size = bodies->count * (u32) sizeof(f32) },
+        { .array = &sim->movable, .source = (u8 *) bodies->movable, .size = bodies->count * (u32) sizeof(f32) },
+    };
+
+    AppendGPUArrays(gpu, copy_pass, bindings, sizeof(bindings) / sizeof(AppendGPUArrayBinding));
+    const u32 first = sim->body_count;
+    sim->body_count += bodies->count;
+    simulation_reserve_scratch(sim, gpu, copy_pass);
+    return first;
 }
 
-void simulation_update(const Simulation *sim, SDL_GPUCommandBuffer *command_buffer, SDL_GPUComputePass *compute_pass, const f32 delta_time) {
+void simulation_clear(Simulation *sim) {
+    sim->positions.used = 0;
+    sim->velocities.used = 0;
+    sim->masses.used = 0;
+    sim->movable.used = 0;
+    sim->body_count = 0;
+}
+
+// only grows, no stage reads what an earlier step left in the scratch
+void simulation_reserve_scratch(Simulation *sim, SDL_GPUDevice *gpu, SDL_GPUCopyPass *copy_pass) {
+    const u32 size = (sim->body_count + 1) * (u32) INTEGRATOR_SCRATCH_SIZE;
+    if (size > sim->scratch.used) ReserveGPUArray(&sim->scratch, gpu, copy_pass, size - sim->scratch.used);
+}
+
+void simulation_update(Simulation *sim, SDL_GPUCommandBuffer *command_buffer, SDL_GPUComputePass *compute_pass, const f32 delta_time) {
     if (sim->options.paused) return;
 
     const struct {
@@ -62,18 +100,24 @@ void simulation_update(const Simulation *sim, SDL_GPUCommandBuffer *command_buff
 
     SDL_PushGPUComputeUniformData(command_buffer, 0, &constants, sizeof(constants));
 
-    SDL_GPUComputePipeline *integrator = sim->integrators[sim->options.integrator];
-    SDL_BindGPUComputePipeline(compute_pass, integrator);
-
-    SDL_GPUBuffer *buffers[] = { sim->positions.buffer, sim->velocities.buffer, sim->masses.buffer, sim->movable.buffer, };
+    SDL_GPUBuffer *buffers[] = { sim->positions.buffer, sim->velocities.buffer, sim->masses.buffer, sim->movable.buffer, sim->scratch.buffer };
     SDL_BindGPUComputeStorageBuffers(compute_pass, 0, buffers, sizeof(buffers) / sizeof(SDL_GPUBuffer *));
-    SDL_DispatchGPUCompute(compute_pass, sim->body_count, 1, 1);
+    for (u32 stage = 0; stage < SIMULATION_STAGES(sim->options.integrator); stage++) {
+        SDL_BindGPUComputePipeline(compute_pass, sim->integrators[sim->options.integrator][stage]);
+        SDL_DispatchGPUCompute(compute_pass, WORKGROUP_COUNT(sim->body_count), 1, 1);
+    }
+
+    sim->step++;
 }
 
 void simulation_free(const Simulation *sim, SDL_GPUDevice *gpu) {
-    for (u8 i = 0; i < 3; i++) SDL_ReleaseGPUComputePipeline(gpu, sim->integrators[i]);
+    for (u32 i = 0; i < INTEGRATOR_COUNT; i++) {
+        for (u32 stage = 0; stage < SIMULATION_STAGES(i); stage++) SDL_ReleaseGPUComputePipeline(gpu, sim->integrators[i][stage]);
+    }
+
     SDL_ReleaseGPUBuffer(gpu, sim->positions.buffer);
     SDL_ReleaseGPUBuffer(gpu, sim->velocities.buffer);
     SDL_ReleaseGPUBuffer(gpu, sim->masses.buffer);
     SDL_ReleaseGPUBuffer(gpu, sim->movable.buffer);
+    SDL_ReleaseGPUBuffer(gpu, sim->scratch.buffer);
 }
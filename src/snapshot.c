@@ -0,0 +1,288 @@
+#include "snapshot.h"
+#include "constants.h"
+#include "trails.h"
+#include "trajectories.h"
+#include "tracking.h"
+
+#include "sdl_utils.h"
+
+#define ALIGN_UP(x, a) (((x) + (a) - 1) / (a) * (a))
+
+static GPUArray *snapshot_block_array(const SnapshotInfo *info, const SnapshotBlockType type) {
+    switch (type) {
+        case SNAPSHOT_BLOCK_POSITIONS: return &info->sim->positions;
+        case SNAPSHOT_BLOCK_VELOCITIES: return &info->sim->velocities;
+        case SNAPSHOT_BLOCK_MASSES: return &info->sim->masses;
+        case SNAPSHOT_BLOCK_MOVABLE: return &info->sim->movable;
+        case SNAPSHOT_BLOCK_COLORS: return &info->appearance->colors;
+        case SNAPSHOT_BLOCK_TRAILS: return &info->trails->array;
+        default: return NULL;
+    }
+}
+
+static const u32 SNAPSHOT_ELEMENT_SIZES[SNAPSHOT_BLOCK_COUNT] = {
+    [SNAPSHOT_BLOCK_POSITIONS] = sizeof(HMM_Vec2),
+    [SNAPSHOT_BLOCK_VELOCITIES] = sizeof(HMM_Vec2),
+    [SNAPSHOT_BLOCK_MASSES] = sizeof(f32),
+    [SNAPSHOT_BLOCK_MOVABLE] = sizeof(f32),
+    [SNAPSHOT_BLOCK_COLORS] = sizeof(u32), // RGBA8
+};
+
+static u64 snapshot_block_size(const SnapshotHeader *header, const SnapshotBlockType type) {
+    if (type == SNAPSHOT_BLOCK_TRAILS) return (u64) sizeof(HMM_Vec2) * header->trail_length * header->body_count;
+    return (u64) SNAPSHOT_ELEMENT_SIZES[type] * header->body_count;
+}
+
+bool snapshot_write(SDL_IOStream *io, const SnapshotInfo *info) {
+    const u32 body_count = info->sim->body_count;
+    SnapshotHeader header = {
+        .magic = SNAPSHOT_MAGIC,
+        .version = SNAPSHOT_VERSION,
+        .header_size = sizeof(SnapshotHeader),
+        .body_count = body_count,
+        .block_count = SNAPSHOT_BLOCK_COUNT,
+        .trail_length = info->trails->length,
+        .trail_frame = info->trails->frame,
+        .step = info->sim->step,
+        .simulation = info->sim->options,
+        .graphics = info->appearance->options,
+        .camera = *info->cam,
+    };
+
+    u64 offset = ALIGN_UP(sizeof(SnapshotHeader), SNAPSHOT_ALIGNMENT);
+    const u64 data_offset = offset;
+    for (u32 i = 0; i < SNAPSHOT_BLOCK_COUNT; i++) {
+        u64 size = snapshot_block_size(&header, i);
+        const bool partial = info->tracking->mode != TRACKING_ALL || info->trails->slot_count != body_count;
+        if (i == SNAPSHOT_BLOCK_TRAILS && (size > SNAPSHOT_TRAILS_MAX_SIZE || partial || info->trails->compact)) size = 0;
+        header.blocks[i] = (SnapshotBlock) { .offset = offset, .size = size };
+        offset = ALIGN_UP(offset + header.blocks[i].size, SNAPSHOT_ALIGNMENT);
+    }
+
+    // the file body is downloaded straight into its final layout and written in one go
+    const usize data_size = offset - data_offset;
+    u8 *data = SDL_calloc(1, data_size + 1);
+    if (!data) return false;
+
+    u32 binding_count = 0;
+    ReadGPUBufferBinding bindings[SNAPSHOT_BLOCK_COUNT];
+    for (u32 i = 0; i < SNAPSHOT_BLOCK_COUNT; i++) {
+        if (!header.blocks[i].size) continue;
+        bindings[binding_count++] = (ReadGPUBufferBinding) {
+            .buffer = snapshot_block_array(info, i)->buffer,
+            .destination = data,
+            .destination_offset = header.blocks[i].offset - data_offset,
+            .size = header.blocks[i].size,
+        };
+    }
+
+    ReadFromGPUBufferNow(info->gpu, bindings, binding_count);
+
+    u8 padding[SNAPSHOT_ALIGNMENT] = { 0 };
+    const bool written = SDL_WriteIO(io, &header, sizeof(header)) == sizeof(header)
+        && SDL_WriteIO(io, padding, data_offset - sizeof(header)) == data_offset - sizeof(header)
+        && SDL_WriteIO(io, data, data_size) == data_size;
+
+    SDL_free(data);
+    if (!written) SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "SDL_WriteIO() in snapshot_write(): %s\n", SDL_GetError());
+    return written;
+}
+
+// everything that later indexes pipelines, rings or the file is checked here, before any state is touched
+static bool snapshot_is_finite(const f32 value) {
+    return !SDL_isinff(value) && !SDL_isnanf(value);
+}
+
+// the header is read as raw bytes, a bool that isn't 0 or 1 would be undefined to even load as a bool
+static bool snapshot_is_bool(const bool *value) {
+    u8 byte;
+    SDL_memcpy(&byte, value, sizeof(byte));
+    return byte <= 1;
+}
+
+// the options are copied over the live ones as they are, so anything a UI or a kernel can't work with is rejected here
+static bool snapshot_check_options(const SnapshotHeader *header) {
+    const SimulationOptions *simulation = &header->simulation;
+    const GraphicsOptions *graphics = &header->graphics;
+    const Camera *camera = &header->camera;
+    return (u32) simulation->integrator < INTEGRATOR_COUNT
+        && snapshot_is_finite(simulation->gravity)
+        && snapshot_is_finite(simulation->softening) && simulation->softening >= 0.0f
+        && snapshot_is_finite(simulation->density) && simulation->density > 0.0f
+        && snapshot_is_bool(&simulation->paused)
+        && snapshot_is_bool(&graphics->field)
+        && snapshot_is_finite(camera->zoom) && camera->zoom > 0.0f
+        && snapshot_is_finite(camera->position.X) && snapshot_is_finite(camera->position.Y)
+        && header->trail_length <= TRAIL_LENGTH_MAX && header->trail_frame < header->trail_length;
+}
+
+static bool snapshot_read_header(SDL_IOStream *io, SnapshotHeader *header) {
+    const i64 start = SDL_TellIO(io);
+    const i64 stream_size = SDL_GetIOSize(io);
+    if (SDL_ReadIO(io, header, sizeof(*header)) != sizeof(*header)) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "SDL_ReadIO() in snapshot_read_header(): Snapshot is truncated.\n");
+        return false;
+    }
+
+    if (header->magic != SNAPSHOT_MAGIC || header->version != SNAPSHOT_VERSION || header->header_size != sizeof(SnapshotHeader) || header->block_count < SNAPSHOT_BLOCK_COUNT || header->block_count > SNAPSHOT_MAX_BLOCKS) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "snapshot_read_header(): Not a version %d snapshot.\n", SNAPSHOT_VERSION);
+        return false;
+    }
+
+    if (!snapshot_check_options(header)) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "snapshot_read_header(): Snapshot has invalid options.\n");
+        return false;
+    }
+
+    // a stream of unknown size is read as is, a short read still fails in snapshot_read()
+    if (start < 0 || stream_size < 0) return true;
+    const u64 available = (u64) (stream_size - SDL_min(start, stream_size));
+    for (u32 i = 0; i < SNAPSHOT_BLOCK_COUNT; i++) {
+        if (header->blocks[i].size > available || header->blocks[i].offset > available - header->blocks[i].size) {
+            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "snapshot_read_header(): Snapshot block %u is past the end of the file.\n", i);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool snapshot_read(SDL_IOStream *io, const SnapshotInfo *info) {
+    const i64 start = SDL_TellIO(io);
+    SnapshotHeader header;
+    if (!snapshot_read_header(io, &header)) return false;
+
+    u64 data_offset = (u64) -1, data_end = 0;
+    for (u32 i = 0; i < SNAPSHOT_BLOCK_COUNT; i++) {
+        const bool optional = i == SNAPSHOT_BLOCK_TRAILS && header.blocks[i].size == 0;
+        if (!optional && header.blocks[i].size != snapshot_block_size(&header, i)) {
+            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "snapshot_read(): Snapshot block %u has the wrong size.\n", i);
+            return false;
+        }
+
+        data_offset = SDL_min(data_offset, header.blocks[i].offset);
+        data_end = SDL_max(data_end, header.blocks[i].offset + header.blocks[i].size);
+    }
+
+    if (data_end - data_offset > (u32) -1) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "snapshot_read(): Snapshot is too large to upload.\n");
+        return false;
+    }
+
+    // file contents go straight into the mapped upload buffer, no intermediate host copy or parsing
+    const u32 data_size = (u32) (data_end - data_offset);
+    SDL_GPUTransferBuffer *transfer_buffer = NULL;
+    if (data_size) {
+        transfer_buffer = SDL_CreateGPUTransferBuffer(info->gpu, &(SDL_GPUTransferBufferCreateInfo) {
+            .size = data_size,
+            .usage = SDL_GPU_TRANSFERBUFFERUSAGE_UPLOAD
+        });
+
+        u8 *data_map = transfer_buffer ? SDL_MapGPUTransferBuffer(info->gpu, transfer_buffer, false) : NULL;
+        const bool read = data_map
+            && SDL_SeekIO(io, start + (i64) data_offset, SDL_IO_SEEK_SET) >= 0
+            && SDL_ReadIO(io, data_map, data_size) == data_size;
+
+        if (data_map) SDL_UnmapGPUTransferBuffer(info->gpu, transfer_buffer);
+        if (!read) {
+            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "SDL_ReadIO() in snapshot_read(): %s\n", SDL_GetError());
+            SDL_ReleaseGPUTransferBuffer(info->gpu, transfer_buffer);
+            return false;
+        }
+    }
+
+    // the trails block holds full precision points for every body, compact or partially tracked trails start over instead
+    Trails *trails = info->trails;
+    tracking_clear(info->tracking);
+    const u32 slot_count = tracking_add_bodies(info->tracking, header.body_count);
+    const bool restore_trails = header.blocks[SNAPSHOT_BLOCK_TRAILS].size && !trails->compact && slot_count == header.body_count;
+    SDL_GPUCommandBuffer *command_buffer = SDL_AcquireGPUCommandBuffer(info->gpu);
+    SDL_GPUCopyPass *copy_pass = SDL_BeginGPUCopyPass(command_buffer);
+    for (u32 i = 0; i < SNAPSHOT_BLOCK_COUNT; i++) {
+        GPUArray *array = snapshot_block_array(info, i);
+        array->used = 0;
+        if (!header.blocks[i].size || (i == SNAPSHOT_BLOCK_TRAILS && !restore_trails)) continue;
+
+        ExpandGPUArray(array, info->gpu, copy_pass, header.blocks[i].size);
+        SDL_UploadToGPUBuffer(
+            copy_pass,
+            &(SDL_GPUTransferBufferLocation) { .transfer_buffer = transfer_buffer, .offset = header.blocks[i].offset - data_offset },
+            &(SDL_GPUBufferRegion) { .buffer = array->buffer, .offset = 0, .size = header.blocks[i].size },
+            false
+        );
+
+        array->used = header.blocks[i].size;
+    }
+
+    // a restored trail ring continues exactly where it was saved, a missing one starts collapsed onto the bodies
+    info->sim->body_count = header.body_count;
+    info->appearance->body_count = header.body_count;
+    info->appearance->revision++;
+    simulation_reserve_scratch(info->sim, info->gpu, copy_pass);
+    if (restore_trails) {
+        trails->slot_count = slot_count;
+        trails->length = header.trail_length;
+        trails->frame = header.trail_frame;
+        trails->reset_from = (u32) -1;
+        trails->anchors.used = 0;
+        ReserveGPUArray(&trails->anchors, info->gpu, copy_pass, (u32) sizeof(HMM_Vec2) * header.body_count);
+    } else {
+        trails_clear(trails);
+        trails_add_slots(trails, info->gpu, copy_pass, slot_count);
+    }
+
+    if (info->trajectories) {
+        trajectories_clear(info->trajectories);
+        trajectories_add_bodies(info->trajectories, info->gpu, copy_pass, header.body_count);
+        trajectories_set_slots(info->trajectories, info->gpu, copy_pass, slot_count);
+    }
+
+    tracking_upload(info->tracking, info->gpu, copy_pass);
+    SDL_EndGPUCopyPass(copy_pass);
+    SDL_SubmitGPUCommandBuffer(command_buffer);
+    if (transfer_buffer) SDL_ReleaseGPUTransferBuffer(info->gpu, transfer_buffer);
+
+    info->sim->options = header.simulation;
+    info->sim->step = header.step;
+    info->appearance->options = header.graphics;
+    *info->cam = header.camera;
+    if (info->cam->target >= header.body_count) info->cam->target = (u32) -1;
+
+    SDL_SeekIO(io, start + (i64) data_end, SDL_IO_SEEK_SET);
+    return true;
+}
+
+bool snapshot_save(const char *path, const SnapshotInfo *info) {
+    SDL_IOStream *io = SDL_IOFromFile(path, "wb");
+    if (!io) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "SDL_IOFromFile() in snapshot_save(): Couldn't open %s.\n", path);
+        return false;
+    }
+
+    const bool saved = snapshot_write(io, info);
+    return SDL_CloseIO(io) && saved;
+}
+
+bool snapshot_load(const char *path, const SnapshotInfo *info) {
+    SDL_IOStream *io = SDL_IOFromFile(path, "rb");
+    if (!io) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "SDL_IOFromFile() in snapshot_load(): Couldn't open %s.\n", path);
+        return false;
+    }
+
+    const bool loaded = snapshot_read(io, info);
+    SDL_CloseIO(io);
+    return loaded;
+}
+
+bool snapshot_peek(const char *path, SnapshotHeader *header) {
+    SDL_IOStream *io = SDL_IOFromFile(path, "rb");
+    if (!io) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "SDL_IOFromFile() in snapshot_peek(): Couldn't open %s.\n", path);
+        return false;
+    }
+
+    const bool read = snapshot_read_header(io, header);
+    SDL_CloseIO(io);
+    return read;
+}
@@ -0,0 +1,3 @@
+// the one stb_ds implementation for everything linking nbody_core
+#define STB_DS_IMPLEMENTATION
+#include "stb_ds.h"
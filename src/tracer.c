@@ -0,0 +1,122 @@
+#include "tracer.h"
+
+#include "SDL3/SDL_atomic.h"
+#include "SDL3/SDL_iostream.h"
+#include "SDL3/SDL_thread.h"
+#include "SDL3/SDL_timer.h"
+
+typedef struct {
+    const char *name;
+    u64 start;
+    u64 duration;
+} TraceEvent;
+
+// single writer (the owning thread), events are published by bumping `head`
+typedef struct {
+    TraceEvent events[TRACE_EVENT_CAPACITY];
+    SDL_AtomicU32 head;
+    const char *names[TRACE_MAX_DEPTH];
+    u64 starts[TRACE_MAX_DEPTH];
+    u32 depth;
+    SDL_ThreadID thread;
+} TraceBuffer;
+
+static TraceBuffer *trace_buffers[TRACE_MAX_THREADS];
+static SDL_AtomicInt trace_buffer_count;
+static _Thread_local TraceBuffer *trace_buffer;
+static u64 trace_epoch;
+
+static TraceBuffer *tracer_thread_buffer(void) {
+    if (trace_buffer) return trace_buffer;
+
+    const i32 slot = SDL_AddAtomicInt(&trace_buffer_count, 1);
+    if (slot >= TRACE_MAX_THREADS) {
+        SDL_AddAtomicInt(&trace_buffer_count, -1);
+        return NULL;
+    }
+
+    if (slot == 0) trace_epoch = SDL_GetTicksNS();
+    trace_buffer = SDL_calloc(1, sizeof(TraceBuffer));
+    if (!trace_buffer) return NULL;
+    trace_buffer->thread = SDL_GetCurrentThreadID();
+
+    SDL_MemoryBarrierRelease();
+    trace_buffers[slot] = trace_buffer;
+    return trace_buffer;
+}
+
+void tracer_begin(const char *name) {
+    TraceBuffer *buffer = tracer_thread_buffer();
+    if (!buffer) return;
+
+    if (buffer->depth < TRACE_MAX_DEPTH) {
+        buffer->names[buffer->depth] = name;
+        buffer->starts[buffer->depth] = SDL_GetTicksNS();
+    }
+
+    buffer->depth++;
+}
+
+void tracer_end(void) {
+    TraceBuffer *buffer = trace_buffer;
+    if (!buffer || buffer->depth == 0) return;
+
+    buffer->depth--;
+    if (buffer->depth >= TRACE_MAX_DEPTH) return;
+
+    const u32 head = SDL_GetAtomicU32(&buffer->head);
+    const u64 start = buffer->starts[buffer->depth];
+    buffer->events[head % TRACE_EVENT_CAPACITY] = (TraceEvent) {
+        .name = buffer->names[buffer->depth],
+        .start = start,
+        .duration = SDL_GetTicksNS() - start
+    };
+
+    SDL_MemoryBarrierRelease();
+    SDL_SetAtomicU32(&buffer->head, head + 1);
+}
+
+// Chrome trace-event format, loads in chrome://tracing and ui.perfetto.dev
+bool tracer_dump(const char *path) {
+    SDL_IOStream *file = SDL_IOFromFile(path, "w");
+    if (!file) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "SDL_IOFromFile() in tracer_dump(): Couldn't open %s.\n", path);
+        return false;
+    }
+
+    SDL_IOprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+    bool first = true;
+    const i32 count = SDL_min(SDL_GetAtomicInt(&trace_buffer_count), TRACE_MAX_THREADS);
+    for (i32 i = 0; i < count; i++) {
+        SDL_MemoryBarrierAcquire();
+        TraceBuffer *buffer = trace_buffers[i];
+        if (!buffer) continue;
+
+        // events near the tail may be overwritten by the owner while we read, skip a margin of them
+        const u32 head = SDL_GetAtomicU32(&buffer->head);
+        SDL_MemoryBarrierAcquire();
+        const u32 available = SDL_min(head, TRACE_EVENT_CAPACITY - TRACE_MAX_DEPTH);
+        for (u32 e = head - available; e != head; e++) {
+            const TraceEvent *event = &buffer->events[e % TRACE_EVENT_CAPACITY];
+            SDL_IOprintf(file, "%s\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":0,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+                first ? "" : ",",
+                event->name,
+                (u32) buffer->thread,
+                (f64) (event->start - trace_epoch) / 1000.0,
+                (f64) event->duration / 1000.0
+            );
+
+            first = false;
+        }
+    }
+
+    SDL_IOprintf(file, "\n]}\n");
+    SDL_CloseIO(file);
+    SDL_Log("Wrote frame trace to %s\n", path);
+    return true;
+}
+
+void tracer_keyboard(const SDL_Event *event) {
+    if (event->type != SDL_EVENT_KEY_DOWN) return;
+    if (event->key.scancode == SDL_SCANCODE_F2) tracer_dump(TRACE_DUMP_PATH);
+}
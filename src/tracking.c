@@ -0,0 +1,114 @@
+#include "tracking.h"
+
+#include "stb_ds.h"
+
+#define TRACKING_USAGE SDL_GPU_BUFFERUSAGE_COMPUTE_STORAGE_READ | SDL_GPU_BUFFERUSAGE_GRAPHICS_STORAGE_READ
+
+// emptying keeps the capacity. arrsetlen(a, 0) compares the capacity against 0, which -Wtype-limits flags
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wtype-limits"
+static void tracking_empty(u32 *array) {
+    arrsetlen(array, 0);
+}
+#pragma GCC diagnostic pop
+
+const char *TRACKING_MODE_NAMES[TRACKING_MODE_COUNT] = {
+    [TRACKING_ALL] = "All Bodies",
+    [TRACKING_SELECTED] = "Selected Bodies",
+};
+
+SDL_AppResult tracking_init(Tracking *tracking, SDL_GPUDevice *gpu) {
+    *tracking = (Tracking) {
+        .mode = TRACKING_ALL,
+        .slot_table = CreateGPUArray(gpu, sizeof(u32), TRACKING_USAGE),
+        .body_table = CreateGPUArray(gpu, sizeof(u32), TRACKING_USAGE),
+    };
+
+    if (!tracking->slot_table.buffer || !tracking->body_table.buffer) panic("Failed to create tracking tables!");
+    return SDL_APP_CONTINUE;
+}
+
+u32 tracking_slot_count(const Tracking *tracking) {
+    return (u32) arrlenu(tracking->bodies);
+}
+
+u32 tracking_slot(const Tracking *tracking, const u32 body) {
+    return body < tracking->body_count ? tracking->slots[body] : TRACKING_NONE;
+}
+
+u32 tracking_add_bodies(Tracking *tracking, const u32 count) {
+    const u32 slot_count = tracking_slot_count(tracking);
+    for (u32 i = 0; i < count; i++) {
+        const u32 body = tracking->body_count + i;
+        arrput(tracking->slots, tracking->mode == TRACKING_ALL ? tracking_slot_count(tracking) : TRACKING_NONE);
+        if (tracking->mode == TRACKING_ALL) arrput(tracking->bodies, body);
+    }
+
+    tracking->body_count += count;
+    tracking->dirty |= count > 0;
+    return tracking_slot_count(tracking) - slot_count;
+}
+
+bool tracking_add(Tracking *tracking, const u32 body) {
+    if (body >= tracking->body_count || tracking->slots[body] != TRACKING_NONE) return false;
+    tracking->slots[body] = tracking_slot_count(tracking);
+    arrput(tracking->bodies, body);
+    tracking->dirty = true;
+    return true;
+}
+
+bool tracking_remove(Tracking *tracking, const u32 body, u32 *slot) {
+    if (body >= tracking->body_count || tracking->slots[body] == TRACKING_NONE) return false;
+    *slot = tracking->slots[body];
+    const u32 last = arrpop(tracking->bodies);
+    if (last != body) {
+        tracking->bodies[*slot] = last;
+        tracking->slots[last] = *slot;
+    }
+
+    tracking->slots[body] = TRACKING_NONE;
+    tracking->dirty = true;
+    return true;
+}
+
+// rebuilds the table, every slot is new afterwards
+void tracking_set_mode(Tracking *tracking, const TrackingMode mode) {
+    tracking->mode = mode;
+    tracking_empty(tracking->bodies);
+    for (u32 body = 0; body < tracking->body_count; body++) {
+        tracking->slots[body] = mode == TRACKING_ALL ? body : TRACKING_NONE;
+        if (mode == TRACKING_ALL) arrput(tracking->bodies, body);
+    }
+
+    tracking->dirty = true;
+}
+
+void tracking_clear(Tracking *tracking) {
+    tracking_empty(tracking->slots);
+    tracking_empty(tracking->bodies);
+    tracking->body_count = 0;
+    tracking->dirty = true;
+}
+
+// both tables are small next to the trails they index, so a change uploads them whole
+void tracking_upload(Tracking *tracking, SDL_GPUDevice *gpu, SDL_GPUCopyPass *copy_pass) {
+    if (!tracking->dirty) return;
+    tracking->slot_table.used = 0;
+    tracking->body_table.used = 0;
+
+    usize binding_count = 0;
+    AppendGPUArrayBinding bindings[2];
+    const u32 slots_size = tracking->body_count * (u32) sizeof(u32);
+    const u32 bodies_size = tracking_slot_count(tracking) * (u32) sizeof(u32);
+    if (slots_size) bindings[binding_count++] = (AppendGPUArrayBinding) { .array = &tracking->slot_table, .source = (const u8 *) tracking->slots, .size = slots_size };
+    if (bodies_size) bindings[binding_count++] = (AppendGPUArrayBinding) { .array = &tracking->body_table, .source = (const u8 *) tracking->bodies, .size = bodies_size };
+    if (binding_count) AppendGPUArrays(gpu, copy_pass, bindings, binding_count);
+    tracking->dirty = false;
+}
+
+void tracking_free(Tracking *tracking, SDL_GPUDevice *gpu) {
+    arrfree(tracking->slots);
+    arrfree(tracking->bodies);
+    SDL_ReleaseGPUBuffer(gpu, tracking->slot_table.buffer);
+    SDL_ReleaseGPUBuffer(gpu, tracking->body_table.buffer);
+}
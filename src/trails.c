@@ -1,43 +1,125 @@
 #include "trails.h"
 #include "constants.h"
 #include "simulation.h"
+#include "tracking.h"
 
-#define TRAIL_SIZE sizeof(HMM_Vec2) * TRAIL_LENGTH
+#define TRAIL_USAGE SDL_GPU_BUFFERUSAGE_COMPUTE_STORAGE_READ | SDL_GPU_BUFFERUSAGE_COMPUTE_STORAGE_WRITE | SDL_GPU_BUFFERUSAGE_GRAPHICS_STORAGE_READ
 
 SDL_AppResult trails_init(Trails *trails, SDL_GPUDevice *gpu) {
-    trails->pipeline = CreateGPUComputePipeline(gpu, "shaders/trail.comp.spv");
-    if (!trails->pipeline) panic("Could not create trails pipeline!");
+    trails->pipelines[0] = CreateGPUComputePipeline(gpu, "shaders/trail.float.comp.spv");
+    trails->pipelines[1] = CreateGPUComputePipeline(gpu, "shaders/trail.half.comp.spv");
+    trails->reset_pipelines[0] = CreateGPUComputePipeline(gpu, "shaders/trail_reset.float.comp.spv");
+    trails->reset_pipelines[1] = CreateGPUComputePipeline(gpu, "shaders/trail_reset.half.comp.spv");
+    if (!trails->pipelines[0] || !trails->pipelines[1]) panic("Could not create trails pipeline!");
+    if (!trails->reset_pipelines[0] || !trails->reset_pipelines[1]) panic("Could not create trails reset pipeline!");
 
-    trails->array = CreateGPUArray(gpu, TRAIL_SIZE, SDL_GPU_BUFFERUSAGE_COMPUTE_STORAGE_READ | SDL_GPU_BUFFERUSAGE_COMPUTE_STORAGE_WRITE | SDL_GPU_BUFFERUSAGE_GRAPHICS_STORAGE_READ);
+    trails->length = TRAIL_LENGTH_DEFAULT;
+    trails->reset_from = (u32) -1;
+    trails->array = CreateGPUArray(gpu, TRAIL_POINT_SIZE(trails->compact) * trails->length, TRAIL_USAGE);
+    trails->anchors = CreateGPUArray(gpu, sizeof(HMM_Vec2), TRAIL_USAGE);
     if (!trails->array.buffer) panic("Could not create trails array!");
+    if (!trails->anchors.buffer) panic("Could not create trail anchors array!");
     return SDL_APP_CONTINUE;
 }
 
-u32 trails_add_body(Trails *trails, SDL_GPUDevice *gpu, SDL_GPUCopyPass *copy_pass, const HMM_Vec2 position) {
-    HMM_Vec2 trail[TRAIL_LENGTH];
-    for (usize i = 0; i < TRAIL_LENGTH; i++) trail[i] = position;
+u32 trails_add_slots(Trails *trails, SDL_GPUDevice *gpu, SDL_GPUCopyPass *copy_pass, const u32 count) {
+    const u32 first = trails->slot_count;
+    if (count == 0) return first;
 
-    AppendGPUArrays(gpu, copy_pass, &(AppendGPUArrayBinding) {
-        .array = &trails->array,
-        .source = (u8 *) &trail,
-        .size = TRAIL_SIZE
-    }, 1);
+    ReserveGPUArray(&trails->array, gpu, copy_pass, (u32) TRAIL_POINT_SIZE(trails->compact) * trails->length * count);
+    ReserveGPUArray(&trails->anchors, gpu, copy_pass, sizeof(HMM_Vec2) * count);
+    trails->reset_from = SDL_min(trails->reset_from, first);
+    trails->slot_count += count;
+    return first;
+}
+
+// swap removal like tracking_remove, the last ring and its anchor are copied over the freed slot
+void trails_remove_slot(Trails *trails, SDL_GPUCopyPass *copy_pass, const u32 slot) {
+    if (slot >= trails->slot_count) return;
+    const u32 last = --trails->slot_count;
+    const u32 ring_size = (u32) TRAIL_POINT_SIZE(trails->compact) * trails->length;
+    if (slot != last) {
+        SDL_CopyGPUBufferToBuffer(
+            copy_pass,
+            &(SDL_GPUBufferLocation) { .buffer = trails->array.buffer, .offset = last * ring_size },
+            &(SDL_GPUBufferLocation) { .buffer = trails->array.buffer, .offset = slot * ring_size },
+            ring_size,
+            false
+        );
+
+        SDL_CopyGPUBufferToBuffer(
+            copy_pass,
+            &(SDL_GPUBufferLocation) { .buffer = trails->anchors.buffer, .offset = last * (u32) sizeof(HMM_Vec2) },
+            &(SDL_GPUBufferLocation) { .buffer = trails->anchors.buffer, .offset = slot * (u32) sizeof(HMM_Vec2) },
+            sizeof(HMM_Vec2),
+            false
+        );
+    }
+
+    trails->array.used = ring_size * trails->slot_count;
+    trails->anchors.used = (u32) sizeof(HMM_Vec2) * trails->slot_count;
+    if (trails->reset_from != (u32) -1) trails->reset_from = SDL_min(trails->reset_from, slot);
+}
 
-    return trails->body_count++;
+void trails_clear(Trails *trails) {
+    trails->array.used = 0;
+    trails->anchors.used = 0;
+    trails->slot_count = 0;
+    trails->reset_from = (u32) -1;
 }
 
-void trails_update(Trails *trails, SDL_GPUCommandBuffer *command_buffer, SDL_GPUComputePass *compute_pass, const Simulation *sim) {
-    if (sim->options.paused) return;
-    trails->frame = (trails->frame + 1) % TRAIL_LENGTH;
-    SDL_PushGPUComputeUniformData(command_buffer, 0, &trails->frame, sizeof(u32));
+// a new length or encoding restarts every trail, the old points aren't converted
+void trails_resize(Trails *trails, SDL_GPUDevice *gpu, const u32 length, const bool compact) {
+    if (length == 0 || (length == trails->length && compact == trails->compact)) return;
+    const u32 point_size = (u32) TRAIL_POINT_SIZE(compact);
+    GPUArray array = CreateGPUArray(gpu, point_size * length * SDL_max(trails->slot_count, 1), TRAIL_USAGE);
+    GPUArray anchors = CreateGPUArray(gpu, sizeof(HMM_Vec2) * SDL_max(trails->slot_count, 1), TRAIL_USAGE);
+    if (!array.buffer || !anchors.buffer) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "SDL_CreateGPUBuffer() in trails_resize(): %s\n", SDL_GetError());
+        SDL_ReleaseGPUBuffer(gpu, array.buffer);
+        SDL_ReleaseGPUBuffer(gpu, anchors.buffer);
+        return;
+    }
+
+    SDL_ReleaseGPUBuffer(gpu, trails->array.buffer);
+    SDL_ReleaseGPUBuffer(gpu, trails->anchors.buffer);
+    trails->array = array;
+    trails->array.used = point_size * length * trails->slot_count;
+    trails->anchors = anchors;
+    trails->anchors.used = sizeof(HMM_Vec2) * trails->slot_count;
+    trails->compact = compact;
+    trails->length = length;
+    trails->frame = 0;
+    trails->reset_from = 0;
+}
+
+void trails_update(Trails *trails, const TrailsUpdateInfo *info) {
+    SDL_GPUBuffer *buffers[] = { trails->array.buffer, info->sim->positions.buffer, trails->anchors.buffer, info->tracking->body_table.buffer };
+    if (trails->reset_from < trails->slot_count) {
+        const u32 constants[] = { trails->reset_from, trails->slot_count, trails->length };
+        SDL_PushGPUComputeUniformData(info->command_buffer, 0, constants, sizeof(constants));
+        SDL_BindGPUComputePipeline(info->compute_pass, trails->reset_pipelines[trails->compact]);
+        SDL_BindGPUComputeStorageBuffers(info->compute_pass, 0, buffers, SDL_arraysize(buffers));
+        SDL_DispatchGPUCompute(info->compute_pass, WORKGROUP_COUNT(trails->slot_count - trails->reset_from), 1, 1);
+        trails->reset_from = (u32) -1;
+    }
+
+    if (info->sim->options.paused) return;
+    trails->frame = (trails->frame + 1) % trails->length;
+    if (!trails->slot_count) return;
+    const u32 constants[] = { trails->frame, trails->slot_count, trails->length };
+    SDL_PushGPUComputeUniformData(info->command_buffer, 0, constants, sizeof(constants));
 
-    SDL_BindGPUComputePipeline(compute_pass, trails->pipeline);
-    SDL_GPUBuffer *buffers[] = { trails->array.buffer, sim->positions.buffer };
-    SDL_BindGPUComputeStorageBuffers(compute_pass, 0, buffers, 2);
-    SDL_DispatchGPUCompute(compute_pass, sim->body_count, 1, 1);
+    SDL_BindGPUComputePipeline(info->compute_pass, trails->pipelines[trails->compact]);
+    SDL_BindGPUComputeStorageBuffers(info->compute_pass, 0, buffers, SDL_arraysize(buffers));
+    SDL_DispatchGPUCompute(info->compute_pass, WORKGROUP_COUNT(trails->slot_count), 1, 1);
 }
 
 void trails_free(const Trails *trails, SDL_GPUDevice *gpu) {
     SDL_ReleaseGPUBuffer(gpu, trails->array.buffer);
-    SDL_ReleaseGPUComputePipeline(gpu, trails->pipeline);
+    SDL_ReleaseGPUBuffer(gpu, trails->anchors.buffer);
+    for (u32 i = 0; i < 2; i++) {
+        SDL_ReleaseGPUComputePipeline(gpu, trails->pipelines[i]);
+        SDL_ReleaseGPUComputePipeline(gpu, trails->reset_pipelines[i]);
+    }
 }
@@ -3,59 +3,113 @@
 #include "constants.h"
 #include "simulation.h"
 #include "ghost.h"
+#include "tracking.h"
 
 #include "HandmadeMath.h"
 
-#define PREDICTION_SIZE sizeof(HMM_Vec2) * PREDICTION_LENGTH
+#define PREDICTION_USAGE SDL_GPU_BUFFERUSAGE_COMPUTE_STORAGE_READ | SDL_GPU_BUFFERUSAGE_COMPUTE_STORAGE_WRITE | SDL_GPU_BUFFERUSAGE_GRAPHICS_STORAGE_READ
 
 SDL_AppResult trajectories_init(Trajectories *trajectories, SDL_GPUDevice *gpu) {
-    trajectories->pipeline = CreateGPUComputePipeline(gpu, "shaders/trajectory.comp.spv");
-    trajectories->ghost_pipeline = CreateGPUComputePipeline(gpu, "shaders/ghost_trajectory.comp.spv");
-    if (!trajectories->pipeline) panic("Failed to create trajectories pipeline!");
-    if (!trajectories->ghost_pipeline) panic("Failed to create ghost trajectories pipeline!");
+    const char *integrators[] = { "euler", "verlet", "runge_kutta" };
+    const char *ghost_variants[] = { "noghost", "ghost" };
+    const char *encodings[] = { "float", "half" };
+    for (u32 i = 0; i < INTEGRATOR_COUNT; i++) {
+        for (u32 s = 0; s < INTEGRATOR_STAGES(i); s++) {
+            char path[128];
+            for (u32 c = 0; c < 2; c++) {
+                for (u32 g = 0; g < 2; g++) {
+                    SDL_snprintf(path, sizeof(path), "shaders/trajectory.%s.s%u.%s.%s.comp.spv", integrators[i], s, ghost_variants[g], encodings[c]);
+                    trajectories->pipelines[i][s][g][c] = CreateGPUComputePipeline(gpu, path);
+                    if (!trajectories->pipelines[i][s][g][c]) panic("Failed to create trajectories pipeline!");
+                }
+
+                SDL_snprintf(path, sizeof(path), "shaders/ghost_trajectory.%s.s%u.%s.comp.spv", integrators[i], s, encodings[c]);
+                trajectories->ghost_pipelines[i][s][c] = CreateGPUComputePipeline(gpu, path);
+                if (!trajectories->ghost_pipelines[i][s][c]) panic("Failed to create ghost trajectories pipeline!");
+            }
+        }
+    }
 
-    trajectories->positions = CreateGPUArray(gpu, PREDICTION_SIZE, SDL_GPU_BUFFERUSAGE_COMPUTE_STORAGE_READ | SDL_GPU_BUFFERUSAGE_COMPUTE_STORAGE_WRITE | SDL_GPU_BUFFERUSAGE_GRAPHICS_STORAGE_READ);
-    trajectories->velocities = CreateGPUArray(gpu, sizeof(HMM_Vec2), SDL_GPU_BUFFERUSAGE_COMPUTE_STORAGE_READ | SDL_GPU_BUFFERUSAGE_COMPUTE_STORAGE_WRITE | SDL_GPU_BUFFERUSAGE_GRAPHICS_STORAGE_READ);
+    trajectories->length = PREDICTION_LENGTH_DEFAULT;
+    trajectories->positions = CreateGPUArray(gpu, (u32) TRAJECTORY_POINT_SIZE(trajectories->compact) * trajectories->length, PREDICTION_USAGE);
+    trajectories->state = CreateGPUArray(gpu, TRAJECTORY_STATE_SIZE, PREDICTION_USAGE);
     trajectories->ghost = SDL_CreateGPUBuffer(gpu, &(SDL_GPUBufferCreateInfo) {
-        .size = sizeof(HMM_Vec2) + PREDICTION_SIZE,
-        .usage = SDL_GPU_BUFFERUSAGE_COMPUTE_STORAGE_READ | SDL_GPU_BUFFERUSAGE_COMPUTE_STORAGE_WRITE | SDL_GPU_BUFFERUSAGE_GRAPHICS_STORAGE_READ
+        .size = sizeof(HMM_Vec2) + sizeof(HMM_Vec2) * trajectories->length,
+        .usage = PREDICTION_USAGE
     });
 
     if (!trajectories->positions.buffer) panic("Failed to create trajectory positions buffer!");
-    if (!trajectories->velocities.buffer) panic("Failed to create trajectory velocities buffer!");
+    if (!trajectories->state.buffer) panic("Failed to create trajectory state buffer!");
     if (!trajectories->ghost) panic("Failed to create trajectories ghost buffer!");
 
     trajectories->enabled = true;
     return SDL_APP_CONTINUE;
 }
 
-u32 trajectories_add_body(Trajectories *trajectories, SDL_GPUDevice *gpu, SDL_GPUCopyPass *copy_pass, const HMM_Vec2 position) {
-    HMM_Vec2 trajectory[PREDICTION_LENGTH];
-    for (usize i = 0; i < PREDICTION_LENGTH; i++) trajectory[i] = position;
+// predictions are recomputed from the current state every update, so new bodies are left uninitialized
+u32 trajectories_add_bodies(Trajectories *trajectories, SDL_GPUDevice *gpu, SDL_GPUCopyPass *copy_pass, const u32 count) {
+    const u32 first = trajectories->body_count;
+    if (count == 0) return first;
 
-    const AppendGPUArrayBinding bindings[] = {
-        { .array = &trajectories->positions, .source = (u8 *) &trajectory, .size = PREDICTION_SIZE },
-        { .array = &trajectories->velocities, .source = (u8 *) &trajectory, .size = sizeof(HMM_Vec2) },
-    };
+    ReserveGPUArray(&trajectories->state, gpu, copy_pass, (u32) TRAJECTORY_STATE_SIZE * count);
+    trajectories->body_count += count;
+    return first;
+}
+
+// the points of every slot are overwritten by the next update, so slots are never moved or initialized
+void trajectories_set_slots(Trajectories *trajectories, SDL_GPUDevice *gpu, SDL_GPUCopyPass *copy_pass, const u32 slot_count) {
+    const u32 slot_size = (u32) TRAJECTORY_POINT_SIZE(trajectories->compact) * trajectories->length;
+    if (slot_count > trajectories->slot_count) ReserveGPUArray(&trajectories->positions, gpu, copy_pass, slot_size * (slot_count - trajectories->slot_count));
+    trajectories->positions.used = slot_size * slot_count;
+    trajectories->slot_count = slot_count;
+}
+
+void trajectories_clear(Trajectories *trajectories) {
+    trajectories->positions.used = 0;
+    trajectories->state.used = 0;
+    trajectories->body_count = 0;
+    trajectories->slot_count = 0;
+}
 
-    AppendGPUArrays(gpu, copy_pass, bindings, sizeof(bindings) / sizeof(AppendGPUArrayBinding));
-    return trajectories->body_count++;
+void trajectories_resize(Trajectories *trajectories, SDL_GPUDevice *gpu, const u32 length, const bool compact) {
+    if (length == 0 || (length == trajectories->length && compact == trajectories->compact)) return;
+    const u32 point_size = (u32) TRAJECTORY_POINT_SIZE(compact);
+    GPUArray positions = CreateGPUArray(gpu, point_size * length * SDL_max(trajectories->slot_count, 1), PREDICTION_USAGE);
+    SDL_GPUBuffer *ghost = SDL_CreateGPUBuffer(gpu, &(SDL_GPUBufferCreateInfo) {
+        .size = sizeof(HMM_Vec2) + sizeof(HMM_Vec2) * length,
+        .usage = PREDICTION_USAGE
+    });
+
+    if (!positions.buffer || !ghost) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "SDL_CreateGPUBuffer() in trajectories_resize(): %s\n", SDL_GetError());
+        SDL_ReleaseGPUBuffer(gpu, positions.buffer);
+        SDL_ReleaseGPUBuffer(gpu, ghost);
+        return;
+    }
+
+    SDL_ReleaseGPUBuffer(gpu, trajectories->positions.buffer);
+    SDL_ReleaseGPUBuffer(gpu, trajectories->ghost);
+    trajectories->positions = positions;
+    trajectories->positions.used = point_size * length * trajectories->slot_count;
+    trajectories->ghost = ghost;
+    trajectories->compact = compact;
+    trajectories->length = length;
 }
 
 void trajectories_update(const Trajectories *trajectories, const TrajectoriesUpdateInfo *info) {
     if (!trajectories->enabled) return;
     const struct {
         u32 count;
-        u32 integrator;
         f32 gravity;
         f32 softening;
         f32 delta_time;
+        u32 length;
     } constants = {
         info->sim->body_count,
-        info->sim->options.integrator,
         info->sim->options.gravity,
         info->sim->options.softening,
         info->delta_time,
+        trajectories->length,
     };
 
     const struct {
@@ -75,30 +129,44 @@ void trajectories_update(const Trajectories *trajectories, const TrajectoriesUpd
 
     SDL_GPUBuffer *buffers[] = {
         trajectories->positions.buffer,
-        trajectories->velocities.buffer,
+        trajectories->state.buffer,
         trajectories->ghost,
         info->sim->positions.buffer,
         info->sim->velocities.buffer,
         info->sim->masses.buffer,
-        info->sim->movable.buffer
+        info->sim->movable.buffer,
+        info->tracking->slot_table.buffer,
+        info->sim->scratch.buffer
     };
 
     SDL_BindGPUComputeStorageBuffers(info->compute_pass, 0, buffers, sizeof(buffers) / sizeof(SDL_GPUBuffer *));
 
-    for (u32 i = 0; i < PREDICTION_LENGTH; i++) {
+    // every stage of the bodies is followed by the ghost's, which reads the positions the bodies' stage evaluated forces at.
+    // the first frame only copies the current state
+    const u32 integrator = info->sim->options.integrator;
+    for (u32 i = 0; i < trajectories->length; i++) {
         SDL_PushGPUComputeUniformData(info->command_buffer, 2, &i, sizeof(i));
-        SDL_BindGPUComputePipeline(info->compute_pass, trajectories->pipeline);
-        SDL_DispatchGPUCompute(info->compute_pass, info->sim->body_count, 1, 1);
-        SDL_BindGPUComputePipeline(info->compute_pass, trajectories->ghost_pipeline);
-        SDL_DispatchGPUCompute(info->compute_pass, 1, 1, 1);
+        for (u32 s = 0; s < (i ? INTEGRATOR_STAGES(integrator) : 1); s++) {
+            SDL_BindGPUComputePipeline(info->compute_pass, trajectories->pipelines[integrator][s][info->ghost->enabled][trajectories->compact]);
+            SDL_DispatchGPUCompute(info->compute_pass, WORKGROUP_COUNT(info->sim->body_count), 1, 1);
+            SDL_BindGPUComputePipeline(info->compute_pass, trajectories->ghost_pipelines[integrator][s][trajectories->compact]);
+            SDL_DispatchGPUCompute(info->compute_pass, 1, 1, 1);
+        }
     }
 }
 
 void trajectories_free(const Trajectories *trajectories, SDL_GPUDevice *gpu) {
-    SDL_ReleaseGPUComputePipeline(gpu, trajectories->pipeline);
-    SDL_ReleaseGPUComputePipeline(gpu, trajectories->ghost_pipeline);
+    for (u32 i = 0; i < INTEGRATOR_COUNT; i++) {
+        for (u32 s = 0; s < INTEGRATOR_STAGES(i); s++) {
+            for (u32 c = 0; c < 2; c++) {
+                SDL_ReleaseGPUComputePipeline(gpu, trajectories->pipelines[i][s][0][c]);
+                SDL_ReleaseGPUComputePipeline(gpu, trajectories->pipelines[i][s][1][c]);
+                SDL_ReleaseGPUComputePipeline(gpu, trajectories->ghost_pipelines[i][s][c]);
+            }
+        }
+    }
     SDL_ReleaseGPUBuffer(gpu, trajectories->positions.buffer);
-    SDL_ReleaseGPUBuffer(gpu, trajectories->velocities.buffer);
+    SDL_ReleaseGPUBuffer(gpu, trajectories->state.buffer);
     SDL_ReleaseGPUBuffer(gpu, trajectories->ghost);
 }
 